@@ -0,0 +1,56 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// A process that keeps a few large lists alive while allocating lots of
+// short-lived large lists and small objects. The large lists are never
+// copied by process collections. Run with -Xprint_gc_statistics to see how
+// much is copied and how many bytes of large objects survive each full
+// collection.
+
+import "BenchmarkBase.dart";
+
+main() {
+  new LargeBuffers().report();
+}
+
+class LargeBuffers extends BenchmarkBase {
+  static const int BUFFER_LENGTH = 32 * 1024;
+  static const int LIVE_BUFFERS = 8;
+  static const int TEMPORARY_BUFFERS = 64;
+  static const int SMALL_OBJECTS_PER_BUFFER = 200;
+
+  List<List> buffers;
+
+  LargeBuffers() : super("LargeBuffers");
+
+  void setup() {
+    buffers = new List<List>(LIVE_BUFFERS);
+    for (int i = 0; i < LIVE_BUFFERS; i++) {
+      buffers[i] = new List(BUFFER_LENGTH);
+    }
+  }
+
+  void teardown() {
+    for (int i = 0; i < LIVE_BUFFERS; i++) {
+      Expect.equals(BUFFER_LENGTH, buffers[i].length);
+    }
+    buffers = null;
+  }
+
+  void run() {
+    int sum = 0;
+    for (int i = 0; i < TEMPORARY_BUFFERS; i++) {
+      List temporary = new List(BUFFER_LENGTH);
+      for (int j = 0; j < SMALL_OBJECTS_PER_BUFFER; j++) {
+        temporary[j] = [i, j];
+      }
+      sum += temporary[i][0];
+      // Keep the live buffers pointing to young objects, so they have to be
+      // remembered by the young collections.
+      List live = buffers[i % LIVE_BUFFERS];
+      live[i] = temporary[i];
+    }
+    Expect.equals(TEMPORARY_BUFFERS * (TEMPORARY_BUFFERS - 1) ~/ 2, sum);
+  }
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+// A process that keeps a large tree alive while allocating lots of
+// short-lived objects, and every now and then stores a new object into the
+// long-lived tree. Run with -Xprint_gc_statistics to see how much is copied
+// by each process collection.
+
+import "BenchmarkBase.dart";
+
+main() {
+  new LongLivedState().report();
+}
+
+class Node {
+  Node left;
+  Node right;
+  int value;
+
+  Node(this.left, this.right, this.value);
+}
+
+class LongLivedState extends BenchmarkBase {
+  static const int TREE_DEPTH = 16;
+  static const int TEMPORARIES = 20000;
+  static const int UPDATE_INTERVAL = 100;
+
+  Node tree;
+  int seed = 42;
+
+  LongLivedState() : super("LongLivedState");
+
+  void setup() {
+    tree = build(TREE_DEPTH);
+  }
+
+  void teardown() {
+    Expect.equals((1 << TREE_DEPTH) - 1, count(tree));
+    tree = null;
+  }
+
+  void run() {
+    int sum = 0;
+    for (int i = 0; i < TEMPORARIES; i++) {
+      Node temporary = new Node(null, null, i);
+      sum += new Node(temporary, null, i).left.value;
+      if (i % UPDATE_INTERVAL == 0) update(new Node(null, null, i));
+    }
+    Expect.equals(TEMPORARIES * (TEMPORARIES - 1) ~/ 2, sum);
+  }
+
+  // Replace a random leaf of the tree. The tree is old by now, so this
+  // stores a pointer to a new object into an old one.
+  void update(Node leaf) {
+    Node parent = tree;
+    seed = (seed * 1103515245 + 12345) & 0x3fffffff;
+    int path = seed;
+    for (int i = 0; i < TREE_DEPTH - 2; i++) {
+      parent = (path & 1) == 0 ? parent.left : parent.right;
+      path >>= 1;
+    }
+    if ((path & 1) == 0) {
+      parent.left = leaf;
+    } else {
+      parent.right = leaf;
+    }
+  }
+
+  static Node build(int depth) {
+    if (depth == 1) return new Node(null, null, depth);
+    return new Node(build(depth - 1), build(depth - 1), depth);
+  }
+
+  static int count(Node node) {
+    if (node == null) return 0;
+    return 1 + count(node.left) + count(node.right);
+  }
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+import 'dart:fletch';
+
+import '../BenchmarkBase.dart';
+import 'utils.dart';
+
+void main() {
+  for (int workers = 1; workers <= 32; workers *= 2) {
+    new ProcessScalingBenchmark(workers).report();
+  }
+}
+
+// Runs [workers] independent inter-process ping-pong pairs at the same time.
+// With perfect scaling across scheduler threads the reported time stays
+// constant until the number of pairs exceeds the number of cores.
+class ProcessScalingBenchmark extends BenchmarkBase {
+  final int workers;
+  Channel input;
+  Port inputPort;
+
+  ProcessScalingBenchmark(int workers)
+      : workers = workers,
+        super("ProcessScaling$workers");
+
+  void setup() {
+    input = new Channel();
+    inputPort = new Port(input);
+  }
+
+  void exercise() => run();
+
+  void run() {
+    for (int i = 0; i < workers; i++) {
+      Process.spawn(pingPongWorker, inputPort);
+    }
+    for (int i = 0; i < workers; i++) {
+      input.receive();
+    }
+  }
+
+  static void pingPongWorker(Port done) {
+    Channel input = new Channel();
+    Process.spawn(portResponder, new Port(input));
+    Port output = input.receive();
+    int i = DEFAULT_MESSAGES;
+    while (i > 0) {
+      output.send(i);
+      i = input.receive();
+    }
+    output.send(0);
+    done.send(null);
+  }
+}
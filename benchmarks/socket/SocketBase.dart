@@ -7,20 +7,26 @@ import 'dart:fletch.io';
 import 'dart:typed_data';
 import '../BenchmarkBase.dart';
 
+// On Linux, run with -Xio_uring to measure the io_uring event handler instead
+// of the epoll one.
+
 const int MESSAGE_SIZE = 256;
 const int PING_PONG_COUNT = 1000;
 
 class SocketBenchmark extends BenchmarkBase {
   final int clients;
+  final int pingPongs;
 
   final channel = new Channel();
   var port;
   int serverSocketPort;
   var serverPort;
 
-  SocketBenchmark(int clients)
-    : super("SocketPingPong$clients"),
-      this.clients = clients;
+  SocketBenchmark(int clients,
+                  {String name, int pingPongs: PING_PONG_COUNT})
+    : super(name != null ? name : "SocketPingPong$clients"),
+      this.clients = clients,
+      this.pingPongs = pingPongs;
 
   static void acceptProcess(Socket socket) {
     var buffer = new Uint8List(MESSAGE_SIZE).buffer;
@@ -68,6 +74,7 @@ class SocketBenchmark extends BenchmarkBase {
       Process.spawn(clientProcess, new Port(channel));
       var clientPort = channel.receive();
       clientPort.send(serverSocketPort);
+      clientPort.send(pingPongs);
       clientPort.send(port);
     }
     for (int i = 0; i < clients; i++) {
@@ -80,9 +87,10 @@ class SocketBenchmark extends BenchmarkBase {
     port.send(new Port(channel));
 
     var socket = new Socket.connect("127.0.0.1", channel.receive());
+    int pingPongs = channel.receive();
     port = channel.receive();
     var buffer = new Uint8List(MESSAGE_SIZE).buffer;
-    for (int i = 0; i < PING_PONG_COUNT; i++) {
+    for (int i = 0; i < pingPongs; i++) {
       socket.write(buffer);
       if (socket.read(MESSAGE_SIZE) == null) throw "Bad socket response";
     }
@@ -0,0 +1,28 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+import 'SocketBase.dart';
+
+// Many mostly idle connections, so the event handler sees a lot of sockets
+// becoming ready at the same time. Needs at least 2 * CLIENTS file
+// descriptors (see 'ulimit -n').
+const int CLIENTS = 1024;
+const int PING_PONGS = 20;
+
+void main() {
+  new SocketManyConnectionsBenchmark().report();
+}
+
+class SocketManyConnectionsBenchmark extends SocketBenchmark {
+  SocketManyConnectionsBenchmark()
+      : super(CLIENTS, name: "SocketManyConnections", pingPongs: PING_PONGS);
+
+  void report() {
+    int score = measure();
+    // Every round trip waits for a read event at both ends.
+    int events = 2 * clients * pingPongs;
+    print("$name(RunTime): $score us.");
+    print("$name(EventsPerSecond): ${events * 1000000 ~/ score}.");
+  }
+}
@@ -4,7 +4,6 @@
 
 import 'dart:_fletch_system' as fletch;
 import 'dart:fletch';
-import 'dart:fletch.io';
 import 'dart:math';
 
 const patch = "patch";
@@ -37,31 +36,63 @@ Channel _ensureEventQueue() {
   }
 }
 
-final int _maxWaitTimeInMilliseconds = 1000;
-
 final int _baseTime = new DateTime.now().millisecondsSinceEpoch;
 
 int get _currentTimestamp {
   return new DateTime.now().millisecondsSinceEpoch - _baseTime;
 }
 
-// TODO(ager): This is a pretty horrible implementation. We should get
-// this integrated with the event loop. For now this is enough to show
-// that we can implement async on top of our current primitives.
+// The timers of this process are kept in a list sorted by timestamp. Only the
+// first timer is armed in the VM, which sends a message to [_timerPort] when
+// it expires. A single fiber waits for these messages and fires the expired
+// timers. Waiting does not block the scheduler thread.
+Channel _timerChannel;
+Port _timerPort;
+bool _hasTimerFiber = false;
+
+void _handleTimeouts() {
+  while (_timers != null) {
+    _timerChannel.receive();
+    _FletchTimer._fireExpiredTimers();
+  }
+  _hasTimerFiber = false;
+}
+
+void _armTimeout() {
+  if (_timerChannel == null) {
+    _timerChannel = new Channel();
+    _timerPort = new Port(_timerChannel);
+  }
+  if (_timers == null) {
+    _cancelTimeout(_timerPort);
+    // Wake up the timer fiber so it can terminate.
+    if (_hasTimerFiber) _timerChannel.send(null);
+    return;
+  }
+  int milliseconds = max(0, _timers._timestamp - _currentTimestamp);
+  _scheduleTimeout(milliseconds, _timerPort);
+  if (!_hasTimerFiber) {
+    _hasTimerFiber = true;
+    Fiber.fork(_handleTimeouts);
+  }
+}
+
+@fletch.native external _scheduleTimeout(int milliseconds, Port port);
+@fletch.native external _cancelTimeout(Port port);
+
 class _FletchTimer implements Timer {
   final int _milliseconds;
   var _callback;
   int _timestamp = 0;
   _FletchTimer _next;
   bool _isActive = true;
-  bool _hasActiveWaitFiber = false;
 
   bool get _isPeriodic => _milliseconds >= 0;
 
   _FletchTimer(this._timestamp, this._callback)
       : _milliseconds = -1 {
     _schedule();
-    _forkWaitFiber();
+    if (identical(_timers, this)) _armTimeout();
   }
 
   _FletchTimer.periodic(this._timestamp,
@@ -69,54 +100,24 @@ class _FletchTimer implements Timer {
                         this._milliseconds) {
     _callback = () { callback(this); };
     _schedule();
-    _forkWaitFiber();
-  }
-
-  void _forkWaitFiber() {
-    if (_timers != this) return;
-    assert(!_hasActiveWaitFiber);
-    _hasActiveWaitFiber = true;
-    Fiber.fork(() {
-      var milliseconds = _timestamp - _currentTimestamp;
-      if (milliseconds < 0) milliseconds = 0;
-      // Cap the sleep time so that a timer that is set way in the
-      // future will not cause the system to keep running if it is
-      // cancelled.
-      if (milliseconds > _maxWaitTimeInMilliseconds) {
-        milliseconds = _maxWaitTimeInMilliseconds;
-      }
+    if (identical(_timers, this)) _armTimeout();
+  }
 
-      Channel channel = new Channel();
-      Port port = new Port(channel);
-      Process.spawn((int milliseconds) {
-        sleep(milliseconds);
-        port.send(null);
-      }, milliseconds);
-      channel.receive();
-
-      _hasActiveWaitFiber = false;
-      _fireExpiredTimers();
-    });
-  }
-
-  void _fireExpiredTimers() {
-    // Skip cancelled timers.
-    while (_timers != null && !_timers._isActive) _timers = _timers._next;
-    if (_timers != null) {
-      // If first timer is expired, fire it and reschedule if it is
-      // periodic.
-      if (_currentTimestamp >= _timers._timestamp) {
-        _AsyncRun._scheduleImmediate(_timers._callback);
-        var current = _timers;
-        _timers = _timers._next;
-        if (current._isPeriodic) current._reschedule();
-      }
-      // Spin up a timer fiber if there isn't already one for
-      // the next timer to fire.
-      if (_timers != null && !_timers._hasActiveWaitFiber) {
-        _timers._forkWaitFiber();
+  static void _fireExpiredTimers() {
+    int now = _currentTimestamp;
+    while (_timers != null && now >= _timers._timestamp) {
+      var current = _timers;
+      _timers = current._next;
+      _AsyncRun._scheduleImmediate(current._callback);
+      if (current._isPeriodic) {
+        current._reschedule();
+      } else {
+        current._isActive = false;
       }
     }
+    // The expired timeout has been consumed, so only a new one needs to be
+    // armed.
+    if (_timers != null) _armTimeout();
   }
 
   void _schedule() {
@@ -136,6 +137,22 @@ class _FletchTimer implements Timer {
     }
   }
 
+  void _unschedule() {
+    if (identical(_timers, this)) {
+      _timers = _next;
+    } else {
+      for (_FletchTimer current = _timers;
+           current != null;
+           current = current._next) {
+        if (identical(current._next, this)) {
+          current._next = _next;
+          break;
+        }
+      }
+    }
+    _next = null;
+  }
+
   void _reschedule() {
     assert(_isPeriodic);
     _timestamp = _currentTimestamp + _milliseconds;
@@ -143,7 +160,11 @@ class _FletchTimer implements Timer {
   }
 
   void cancel() {
+    if (!_isActive) return;
     _isActive = false;
+    bool wasFirst = identical(_timers, this);
+    _unschedule();
+    if (wasFirst) _armTimeout();
   }
 
   bool get isActive => _isActive;
@@ -261,8 +261,13 @@ class Coroutine {
 class Process {
   /**
    * Spawn a top-level function.
+   *
+   * If [heapLimit] is given, the heap of the new process may hold at most
+   * that many bytes. An allocation that does not fit after a garbage
+   * collection throws an out of memory exception, and if it is not caught
+   * only the new process is terminated.
    */
-  static void spawn(Function fn, [argument]) {
+  static void spawn(Function fn, [argument, int heapLimit]) {
     if (!isImmutable(fn)) {
       throw new ArgumentError(
           'The closure passed to Process.spawn() must be immutable.');
@@ -273,7 +278,12 @@ class Process {
           'The optional argument passed to Process.spawn() must be immutable.');
     }
 
-    _spawn(_entry, fn, argument);
+    if (heapLimit != null && heapLimit <= 0) {
+      throw new ArgumentError.value(
+          heapLimit, "heapLimit", "The heap limit must be positive.");
+    }
+
+    _spawn(_entry, fn, argument, heapLimit);
   }
 
   /**
@@ -352,7 +362,8 @@ class Process {
   }
 
   // Low-level helper function for spawning.
-  @fletch.native static void _spawn(Function entry, Function fn, argument) {
+  @fletch.native static void _spawn(
+      Function entry, Function fn, argument, int heapLimit) {
     throw new ArgumentError();
   }
 
@@ -509,3 +520,17 @@ class _ChannelEntry {
 bool isImmutable(Object object) => _isImmutable(object);
 
 @fletch.native external bool _isImmutable(String string);
+
+/// Writes a census of the heap of the current process and the shared
+/// immutable heap to the file at [path], as a JSON list with the number of
+/// instances and bytes of each class. With [retainedSizes] it also computes
+/// how many bytes the instances of each class keep alive, which takes longer.
+/// Only the current process is paused while the census is taken. Returns
+/// false if the file could not be written.
+bool writeHeapCensus(String path, {bool retainedSizes: false}) {
+  return _writeHeapCensus(path, retainedSizes);
+}
+
+@fletch.native bool _writeHeapCensus(String path, bool retainedSizes) {
+  throw new ArgumentError();
+}
@@ -87,9 +87,16 @@ abstract class System {
   int setBlocking(int fd, bool blocking);
   int setReuseaddr(int fd);
 
-  static int eventHandler = _getEventHandler();
-  @fletch.native external static int _getEventHandler();
+  // The event handler may be split into several shards (-Xevent_handlers).
+  // Returns the one responsible for [fd].
+  static int eventHandlerFor(int fd) => _getEventHandler(fd);
+
+  @fletch.native external static int _getEventHandler(int fd);
   @fletch.native external static int _incrementPortRef(Port port);
+  @fletch.native external static bool _isIoUringEventHandler();
+  @fletch.native external static int _setPortForNextEvent(
+      int fd, Port port, int mask);
+  @fletch.native external static int _cancelNextEvent(int fd);
 }
 
 final int hostWordSize = Foreign.bitsPerMachineWord ~/ 8;
@@ -10,6 +10,7 @@ const int EPOLLERR      = 0x8;
 const int EPOLLHUP      = 0x10;
 const int EPOLLRDHUP    = 0x2000;
 const int EPOLLONESHOT  = 0x40000000;
+const int EPOLLET       = 0x80000000;
 
 const int EPOLL_CTL_ADD = 1;
 const int EPOLL_CTL_DEL = 2;
@@ -62,6 +63,16 @@ class LinuxSystem extends PosixSystem {
 
   final EpollEvent _epollEvent = new EpollEvent();
 
+  // Extra epoll flags used when a socket is armed for its next event, e.g.
+  // EPOLLET. Sockets are always armed EPOLLONESHOT and re-armed with
+  // EPOLL_CTL_MOD, which rules out EPOLLEXCLUSIVE.
+  static int eventFlags = 0;
+
+  // With the io_uring event handler (-Xio_uring) sockets are armed by the VM
+  // instead of through epoll_ctl. Data is still moved by the synchronous read,
+  // write and accept calls in PosixSystem.
+  static final bool _useIoUring = System._isIoUringEventHandler();
+
   int get FIONREAD => 0x541B;
 
   int get SOL_SOCKET => 1;
@@ -72,27 +83,30 @@ class LinuxSystem extends PosixSystem {
   ForeignFunction get _open => _openLinux;
 
   int addToEventHandler(int fd) {
+    if (_useIoUring) return 0;
     _epollEvent.events = 0;
     _epollEvent.data = 0;
-    int eh = System.eventHandler;
+    int eh = System.eventHandlerFor(fd);
     return _retry(() => _epollCtl.icall$4(eh, EPOLL_CTL_ADD, fd, _epollEvent));
   }
 
   int removeFromEventHandler(int fd) {
     // TODO(ajohnsen): If we increased the refcount of the port before adding it
     // to the epoll set and we remove it now, we can leak memory.
-    int eh = System.eventHandler;
+    if (_useIoUring) return System._cancelNextEvent(fd);
+    int eh = System.eventHandlerFor(fd);
     return _retry(() => _epollCtl.icall$4(eh, EPOLL_CTL_DEL, fd,
                                           ForeignPointer.NULL));
   }
 
   int setPortForNextEvent(int fd, Port port, int mask) {
-    int events = EPOLLRDHUP | EPOLLHUP | EPOLLONESHOT;
+    if (_useIoUring) return System._setPortForNextEvent(fd, port, mask);
+    int events = EPOLLRDHUP | EPOLLHUP | EPOLLONESHOT | eventFlags;
     if ((mask & READ_EVENT) != 0) events |= EPOLLIN;
     if ((mask & WRITE_EVENT) != 0) events |= EPOLLOUT;
     _epollEvent.events = events;
     _epollEvent.data = System._incrementPortRef(port);
-    int eh = System.eventHandler;
+    int eh = System.eventHandlerFor(fd);
     return _retry(() => _epollCtl.icall$4(eh, EPOLL_CTL_MOD, fd, _epollEvent));
   }
 }
@@ -81,8 +81,8 @@ class MacOSSystem extends PosixSystem {
   ForeignFunction get _lseek => _lseekMac;
   ForeignFunction get _open => _openMac;
 
-  int _setEvents(bool read, bool write) {
-    int eh = System.eventHandler;
+  int _setEvents(int fd, bool read, bool write) {
+    int eh = System.eventHandlerFor(fd);
     int status = 0;
     if (read) {
       _kEvent.filter = EVFILT_READ;
@@ -118,6 +118,6 @@ class MacOSSystem extends PosixSystem {
     _kEvent.ident = fd;
     _kEvent.flags = EV_ADD | EV_ONESHOT;
     _kEvent.udata = System._incrementPortRef(port);
-    return _setEvents((mask & READ_EVENT) != 0, (mask & WRITE_EVENT) != 0);
+    return _setEvents(fd, (mask & READ_EVENT) != 0, (mask & WRITE_EVENT) != 0);
   }
 }
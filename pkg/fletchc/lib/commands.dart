@@ -81,6 +81,62 @@ abstract class Command {
       case CommandCode.ProcessNumberOfStacks:
         int value = CommandBuffer.readInt32FromBuffer(buffer, 0);
         return new ProcessNumberOfStacks(value);
+      case CommandCode.ProcessProfile:
+        ProcessProfile profile = new ProcessProfile();
+        int offset = 0;
+        while (offset < buffer.length) {
+          int count = CommandBuffer.readInt32FromBuffer(buffer, offset);
+          int depth = CommandBuffer.readInt32FromBuffer(buffer, offset + 4);
+          offset += 8;
+          ProfileStack stack = new ProfileStack(count, depth);
+          for (int i = 0; i < depth; i++) {
+            stack.functionIds[i] =
+                CommandBuffer.readInt64FromBuffer(buffer, offset);
+            stack.bytecodeIndices[i] =
+                CommandBuffer.readInt64FromBuffer(buffer, offset + 8);
+            offset += 16;
+          }
+          profile.stacks.add(stack);
+        }
+        return profile;
+      case CommandCode.GcEvents:
+        GcEvents events = new GcEvents();
+        for (int offset = 0; offset < buffer.length; offset += 48) {
+          events.events.add(new GcEvent(
+              CommandBuffer.readInt32FromBuffer(buffer, offset),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 4),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 12),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 20),
+              CommandBuffer.readInt32FromBuffer(buffer, offset + 28),
+              CommandBuffer.readInt32FromBuffer(buffer, offset + 32),
+              CommandBuffer.readInt32FromBuffer(buffer, offset + 36),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 40)));
+        }
+        return events;
+      case CommandCode.HeapCensus:
+        HeapCensus census = new HeapCensus();
+        for (int offset = 0; offset < buffer.length; offset += 28) {
+          census.classes.add(new ClassCensus(
+              CommandBuffer.readInt64FromBuffer(buffer, offset),
+              CommandBuffer.readInt32FromBuffer(buffer, offset + 8),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 12),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 20)));
+        }
+        return census;
+      case CommandCode.LookupCacheStatistics:
+        LookupCacheStatistics statistics = new LookupCacheStatistics();
+        for (int offset = 0; offset < buffer.length; offset += 56) {
+          statistics.threads.add(new ThreadLookupCacheStatistics(
+              CommandBuffer.readInt32FromBuffer(buffer, offset),
+              CommandBuffer.readInt32FromBuffer(buffer, offset + 4),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 8),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 16),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 24),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 32),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 40),
+              CommandBuffer.readInt64FromBuffer(buffer, offset + 48)));
+        }
+        return statistics;
       case CommandCode.UncaughtException:
         return const UncaughtException();
       case CommandCode.CommitChangesResult:
@@ -955,6 +1011,201 @@ class ProcessNumberOfStacks extends Command {
   String valuesToString() => "$value";
 }
 
+class ProcessProfileRequest extends Command {
+  const ProcessProfileRequest()
+      : super(CommandCode.ProcessProfileRequest);
+
+  /// The peer will respond with [ProcessProfile].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "";
+}
+
+/// A stack sampled by the profiler, outermost frame first.
+class ProfileStack {
+  final int count;
+  final List<int> functionIds;
+  final List<int> bytecodeIndices;
+
+  ProfileStack(this.count, int depth)
+      : functionIds = new List<int>(depth),
+        bytecodeIndices = new List<int>(depth);
+
+  String toString() => "$count, $functionIds, $bytecodeIndices";
+}
+
+class ProcessProfile extends Command {
+  final List<ProfileStack> stacks = <ProfileStack>[];
+
+  ProcessProfile()
+      : super(CommandCode.ProcessProfile);
+
+  void internalAddTo(Sink<List<int>> sink, CommandBuffer<CommandCode> buffer) {
+    throw new UnimplementedError();
+  }
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() => "$stacks";
+}
+
+class GcEventsRequest extends Command {
+  const GcEventsRequest()
+      : super(CommandCode.GcEventsRequest);
+
+  /// The peer will respond with [GcEvents].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "";
+}
+
+/// A collection recorded by the VM. Times are in microseconds and sizes in
+/// bytes. [process] is zero for collections of the program heap and the
+/// immutable heap.
+class GcEvent {
+  static const List<String> kindNames = const <String>[
+      "process-young",
+      "process-full",
+      "immutable-scavenge",
+      "immutable-mark-sweep",
+      "program"];
+
+  final int kind;
+  final int process;
+  final int start;
+  final int end;
+  final int sizeBefore;
+  final int sizeAfter;
+  final int promoted;
+  final int wait;
+
+  GcEvent(this.kind, this.process, this.start, this.end, this.sizeBefore,
+          this.sizeAfter, this.promoted, this.wait);
+
+  String get kindName => kindNames[kind];
+
+  int get pause => end - start;
+
+  String toString() {
+    return "$kindName, $process, $start, $end, $sizeBefore, $sizeAfter, "
+        "$promoted, $wait";
+  }
+}
+
+class GcEvents extends Command {
+  final List<GcEvent> events = <GcEvent>[];
+
+  GcEvents()
+      : super(CommandCode.GcEvents);
+
+  void internalAddTo(Sink<List<int>> sink, CommandBuffer<CommandCode> buffer) {
+    throw new UnimplementedError();
+  }
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() => "$events";
+}
+
+class HeapCensusRequest extends Command {
+  final bool retainedSizes;
+
+  const HeapCensusRequest(this.retainedSizes)
+      : super(CommandCode.HeapCensusRequest);
+
+  void internalAddTo(Sink<List<int>> sink, CommandBuffer<CommandCode> buffer) {
+    buffer
+        ..addUint8(retainedSizes ? 1 : 0)
+        ..sendOn(sink, code);
+  }
+
+  /// The peer will respond with [HeapCensus].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "$retainedSizes";
+}
+
+/// The instances of a class in a heap census. [retained] is zero unless
+/// retained sizes were requested.
+class ClassCensus {
+  final int classId;
+  final int instances;
+  final int bytes;
+  final int retained;
+
+  ClassCensus(this.classId, this.instances, this.bytes, this.retained);
+
+  String toString() => "$classId, $instances, $bytes, $retained";
+}
+
+class HeapCensus extends Command {
+  /// Largest shallow size first.
+  final List<ClassCensus> classes = <ClassCensus>[];
+
+  HeapCensus()
+      : super(CommandCode.HeapCensus);
+
+  void internalAddTo(Sink<List<int>> sink, CommandBuffer<CommandCode> buffer) {
+    throw new UnimplementedError();
+  }
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() => "$classes";
+}
+
+class LookupCacheStatisticsRequest extends Command {
+  const LookupCacheStatisticsRequest()
+      : super(CommandCode.LookupCacheStatisticsRequest);
+
+  /// The peer will respond with [LookupCacheStatistics].
+  int get numberOfResponsesExpected => 1;
+
+  String valuesToString() => "";
+}
+
+/// The lookup cache counters of a VM thread. The counters stay zero unless
+/// the VM is a debug build run with -Xlookup-cache-statistics.
+/// [primarySize] is the current number of entries in the primary cache.
+/// The vtable counters are for compact programs, which dispatch through the
+/// vtable instead of the lookup cache.
+class ThreadLookupCacheStatistics {
+  final int thread;
+  final int primarySize;
+  final int primaryHits;
+  final int secondaryHits;
+  final int lookups;
+  final int noSuchMethod;
+  final int vtableHits;
+  final int vtableNoSuchMethod;
+
+  ThreadLookupCacheStatistics(this.thread, this.primarySize, this.primaryHits,
+                              this.secondaryHits, this.lookups,
+                              this.noSuchMethod, this.vtableHits,
+                              this.vtableNoSuchMethod);
+
+  String toString() {
+    return "$thread, $primarySize, $primaryHits, $secondaryHits, $lookups, "
+        "$noSuchMethod, $vtableHits, $vtableNoSuchMethod";
+  }
+}
+
+class LookupCacheStatistics extends Command {
+  final List<ThreadLookupCacheStatistics> threads =
+      <ThreadLookupCacheStatistics>[];
+
+  LookupCacheStatistics()
+      : super(CommandCode.LookupCacheStatistics);
+
+  void internalAddTo(Sink<List<int>> sink, CommandBuffer<CommandCode> buffer) {
+    throw new UnimplementedError();
+  }
+
+  int get numberOfResponsesExpected => 0;
+
+  String valuesToString() => "$threads";
+}
+
 class SessionEnd extends Command {
   const SessionEnd()
       : super(CommandCode.SessionEnd);
@@ -1157,6 +1408,14 @@ enum CommandCode {
   ProcessCompileTimeError,
   ProcessAddFibersToMap,
   ProcessNumberOfStacks,
+  ProcessProfileRequest,
+  ProcessProfile,
+  GcEventsRequest,
+  GcEvents,
+  HeapCensusRequest,
+  HeapCensus,
+  LookupCacheStatisticsRequest,
+  LookupCacheStatistics,
   WriteSnapshot,
   CollectGarbage,
 
@@ -240,5 +240,15 @@ void doBytecodes(V(String name, bool isBranching, String format, int size,
 
   V("FrameSize",            false,    "B",  2, kVarDiff, "frame size %d");
 
+  // Fused bytecodes are only created by the VM.
+  V("LoadLocal0LoadField",  false,    "",   1,        1, "load local 0 (fused)");
+  V("LoadLocal1LoadField",  false,    "",   1,        1, "load local 1 (fused)");
+  V("LoadLocalLoadField",   false,    "B",  2,        1, "load local %d (fused)");
+  V("LoadLocal0InvokeMethodVtable",
+                            false,    "",   1,        1, "load local 0 (fused)");
+  V("LoadLiteralNullIdentical",
+                            false,    "",   1,        1,
+    "load literal null (fused)");
+
   V("MethodEnd",            false,    "I",  5,        0, "method end %d");
 }
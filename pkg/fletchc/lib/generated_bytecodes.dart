@@ -123,6 +123,11 @@ enum Opcode {
   EnterNoSuchMethod,
   ExitNoSuchMethod,
   FrameSize,
+  LoadLocal0LoadField,
+  LoadLocal1LoadField,
+  LoadLocalLoadField,
+  LoadLocal0InvokeMethodVtable,
+  LoadLiteralNullIdentical,
   MethodEnd,
 }
 
@@ -4756,6 +4761,156 @@ class FrameSize extends Bytecode {
   }
 }
 
+class LoadLocal0LoadField extends Bytecode {
+  const LoadLocal0LoadField()
+      : super();
+
+  Opcode get opcode => Opcode.LoadLocal0LoadField;
+
+  String get name => 'LoadLocal0LoadField';
+
+  bool get isBranching => false;
+
+  String get format => '';
+
+  int get size => 1;
+
+  int get stackPointerDifference => 1;
+
+  String get formatString => 'load local 0 (fused)';
+
+  void addTo(Sink<List<int>> sink) {
+    new BytecodeBuffer()
+        ..addUint8(opcode.index)
+        ..sendOn(sink);
+  }
+
+  String toString() => 'load local 0 (fused)';
+}
+
+class LoadLocal1LoadField extends Bytecode {
+  const LoadLocal1LoadField()
+      : super();
+
+  Opcode get opcode => Opcode.LoadLocal1LoadField;
+
+  String get name => 'LoadLocal1LoadField';
+
+  bool get isBranching => false;
+
+  String get format => '';
+
+  int get size => 1;
+
+  int get stackPointerDifference => 1;
+
+  String get formatString => 'load local 1 (fused)';
+
+  void addTo(Sink<List<int>> sink) {
+    new BytecodeBuffer()
+        ..addUint8(opcode.index)
+        ..sendOn(sink);
+  }
+
+  String toString() => 'load local 1 (fused)';
+}
+
+class LoadLocalLoadField extends Bytecode {
+  final int uint8Argument0;
+  const LoadLocalLoadField(this.uint8Argument0)
+      : super();
+
+  Opcode get opcode => Opcode.LoadLocalLoadField;
+
+  String get name => 'LoadLocalLoadField';
+
+  bool get isBranching => false;
+
+  String get format => 'B';
+
+  int get size => 2;
+
+  int get stackPointerDifference => 1;
+
+  String get formatString => 'load local %d (fused)';
+
+  void addTo(Sink<List<int>> sink) {
+    new BytecodeBuffer()
+        ..addUint8(opcode.index)
+        ..addUint8(uint8Argument0)
+        ..sendOn(sink);
+  }
+
+  String toString() => 'load local ${uint8Argument0} (fused)';
+
+  operator==(Bytecode other) {
+    if (!(super==(other))) return false;
+    LoadLocalLoadField rhs = other;
+    if (uint8Argument0 != rhs.uint8Argument0) return false;
+    return true;
+  }
+
+  int get hashCode {
+    int value = super.hashCode;
+    value += uint8Argument0;
+    return value;
+  }
+}
+
+class LoadLocal0InvokeMethodVtable extends Bytecode {
+  const LoadLocal0InvokeMethodVtable()
+      : super();
+
+  Opcode get opcode => Opcode.LoadLocal0InvokeMethodVtable;
+
+  String get name => 'LoadLocal0InvokeMethodVtable';
+
+  bool get isBranching => false;
+
+  String get format => '';
+
+  int get size => 1;
+
+  int get stackPointerDifference => 1;
+
+  String get formatString => 'load local 0 (fused)';
+
+  void addTo(Sink<List<int>> sink) {
+    new BytecodeBuffer()
+        ..addUint8(opcode.index)
+        ..sendOn(sink);
+  }
+
+  String toString() => 'load local 0 (fused)';
+}
+
+class LoadLiteralNullIdentical extends Bytecode {
+  const LoadLiteralNullIdentical()
+      : super();
+
+  Opcode get opcode => Opcode.LoadLiteralNullIdentical;
+
+  String get name => 'LoadLiteralNullIdentical';
+
+  bool get isBranching => false;
+
+  String get format => '';
+
+  int get size => 1;
+
+  int get stackPointerDifference => 1;
+
+  String get formatString => 'load literal null (fused)';
+
+  void addTo(Sink<List<int>> sink) {
+    new BytecodeBuffer()
+        ..addUint8(opcode.index)
+        ..sendOn(sink);
+  }
+
+  String toString() => 'load literal null (fused)';
+}
+
 class MethodEnd extends Bytecode {
   final int uint32Argument0;
   const MethodEnd(this.uint32Argument0)
@@ -31,6 +31,10 @@ Commands:
   'p *<name>'                           print the structure of local variable
   'p'                                   print the values of all locals
   'disasm'                              disassemble code for frame
+  'profile'                             print sampled stacks (needs -Xprofile)
+  'gc'                                  print the recent garbage collections
+  'census [retained]'                   print instances and bytes per class
+  'lookups'                             print lookup cache statistics
   't <flag>'                            toggle one of the flags:
                                           - 'internal' : show internal frames
   'q'/'quit'                            quit the session
@@ -165,6 +169,20 @@ class InputHandler {
           await session.printVariable(variableName);
         }
         break;
+      case 'profile':
+        await session.profile();
+        break;
+      case 'gc':
+        await session.gcEvents();
+        break;
+      case 'census':
+        bool retainedSizes =
+            commandComponents.length > 1 && commandComponents[1] == 'retained';
+        await session.heapCensus(retainedSizes: retainedSizes);
+        break;
+      case 'lookups':
+        await session.lookupCacheStatistics();
+        break;
       case 'q':
       case 'quit':
         await session.terminateSession();
@@ -598,6 +598,69 @@ class Session extends FletchVmSession {
     await runCommand(const DeleteMap(MapId.fibers));
   }
 
+  /// Print the stacks sampled by the profiler (the VM must have been started
+  /// with -Xprofile) in the folded format used by flame graph tools.
+  Future profile() async {
+    ProcessProfile response = await runCommand(const ProcessProfileRequest());
+    Map<String, int> counts = <String, int>{};
+    for (ProfileStack stack in response.stacks) {
+      String frames = stack.functionIds.map((int id) {
+        FletchFunction function = fletchSystem.lookupFunctionById(id);
+        if (function == null) return '<unknown>';
+        return compiler.lookupFunctionName(function);
+      }).join(';');
+      counts[frames] = counts.putIfAbsent(frames, () => 0) + stack.count;
+    }
+    counts.forEach((String frames, int count) {
+      writeStdoutLine('$frames $count');
+    });
+  }
+
+  /// Print the most recent garbage collections, oldest first.
+  Future gcEvents() async {
+    GcEvents response = await runCommand(const GcEventsRequest());
+    for (GcEvent event in response.events) {
+      String process = event.process == 0 ? '' : ' process ${event.process}';
+      writeStdoutLine('${event.kindName}$process: '
+          '${event.sizeBefore} -> ${event.sizeAfter} bytes, '
+          'promoted ${event.promoted} bytes, '
+          'pause ${event.pause} us, wait ${event.wait} us');
+    }
+  }
+
+  /// Print the number of instances and bytes of each class in the heaps of
+  /// all processes and the immutable heap, largest first.
+  Future heapCensus({bool retainedSizes: false}) async {
+    HeapCensus response =
+        await runCommand(new HeapCensusRequest(retainedSizes));
+    for (ClassCensus census in response.classes) {
+      FletchClass klass = census.classId < 0
+          ? null
+          : fletchSystem.lookupClassById(census.classId);
+      String name = klass == null ? '<unknown>' : klass.name;
+      String retained =
+          retainedSizes ? ', retained ${census.retained} bytes' : '';
+      writeStdoutLine('$name: ${census.instances} instances, '
+          '${census.bytes} bytes$retained');
+    }
+  }
+
+  /// Print the lookup cache counters of each VM thread.
+  Future lookupCacheStatistics() async {
+    LookupCacheStatistics response =
+        await runCommand(const LookupCacheStatisticsRequest());
+    for (ThreadLookupCacheStatistics thread in response.threads) {
+      writeStdoutLine('thread ${thread.thread}: '
+          '${thread.primarySize} primary entries, '
+          '${thread.primaryHits} primary hits, '
+          '${thread.secondaryHits} secondary hits, '
+          '${thread.lookups} lookups, '
+          '${thread.noSuchMethod} noSuchMethod, '
+          '${thread.vtableHits} vtable hits, '
+          '${thread.vtableNoSuchMethod} vtable noSuchMethod');
+    }
+  }
+
   String dartValueToString(DartValue value) {
     if (value is Instance) {
       Instance i = value;
@@ -200,6 +200,31 @@ bool Bytecode::IsInvokeVtable(Opcode opcode) {
   return ComputeInvokeKind(opcode) == VTABLE;
 }
 
+bool Bytecode::IsFused(Opcode opcode) {
+  return UnfusedOpcode(opcode) != opcode;
+}
+
+Opcode Bytecode::UnfusedOpcode(Opcode opcode) {
+  switch (opcode) {
+#define FUSED_CASE(name, first, second) \
+    case k##name: return k##first;
+  FUSED_BYTECODES_DO(FUSED_CASE)
+#undef FUSED_CASE
+    default:
+      return opcode;
+  }
+}
+
+Opcode Bytecode::FusedOpcode(Opcode first, Opcode second) {
+#define FUSED_CASE(name, fused_first, fused_second)               \
+  if (first == k##fused_first && second == k##fused_second) {     \
+    return k##name;                                               \
+  }
+  FUSED_BYTECODES_DO(FUSED_CASE)
+#undef FUSED_CASE
+  return first;
+}
+
 // TODO(ager): use branches to skip forward by more than
 // a bytecode at a time as in StackWalker::StackDiff.
 uint8* Bytecode::PreviousBytecode(uint8* current_bcp) {
@@ -126,8 +126,32 @@ const int kLoadLiteralWideLimit = 0x3fffffff;
                                                                                \
   V(FrameSize,            false,    "B",  2, kVarDiff, "frame size %d")        \
                                                                                \
+  /* Fused bytecodes, see FUSED_BYTECODES_DO below. */                         \
+  V(LoadLocal0LoadField,  false,    "",   1,        1, "load local 0 (fused)") \
+  V(LoadLocal1LoadField,  false,    "",   1,        1, "load local 1 (fused)") \
+  V(LoadLocalLoadField,   false,    "B",  2,        1, "load local %d (fused)")\
+  V(LoadLocal0InvokeMethodVtable,                                              \
+                          false,    "",   1,        1, "load local 0 (fused)") \
+  V(LoadLiteralNullIdentical,                                                  \
+                          false,    "",   1,        1, "load literal null "    \
+                                                       "(fused)")              \
+                                                                               \
   V(MethodEnd,            false,    "I",  5,        0, "method end %d")        \
 
+// Superinstructions. Fused bytecodes are only created by the VM when it
+// folds a program. A fused bytecode replaces the first of two bytecodes
+// and has its format, size and stack effect, so the second bytecode stays
+// in place: everything that walks bytecodes still sees both of them, and
+// branches into the second bytecode still work. The interpreters go
+// straight to the second bytecode without dispatching in between.
+#define FUSED_BYTECODES_DO(V)                                                  \
+  /* Name                        First              Second */                  \
+  V(LoadLocal0LoadField,           LoadLocal0,        LoadField)               \
+  V(LoadLocal1LoadField,           LoadLocal1,        LoadField)               \
+  V(LoadLocalLoadField,            LoadLocal,         LoadField)               \
+  V(LoadLocal0InvokeMethodVtable,  LoadLocal0,        InvokeMethodVtable)      \
+  V(LoadLiteralNullIdentical,      LoadLiteralNull,   Identical)               \
+
 #define BYTECODE_OPCODE(name, branching, format, length, stack_diff, print) k##name,
 enum Opcode {
   BYTECODES_DO(BYTECODE_OPCODE)
@@ -174,6 +198,17 @@ class Bytecode {
   static bool IsInvokeFast(Opcode opcode);
   static bool IsInvokeVtable(Opcode opcode);
 
+  // Check if this byte code is a fused bytecode.
+  static bool IsFused(Opcode opcode);
+
+  // Get the bytecode a fused bytecode starts with. Returns [opcode] itself
+  // if it is not fused.
+  static Opcode UnfusedOpcode(Opcode opcode);
+
+  // Get the fused bytecode for [first] followed by [second]. Returns
+  // [first] if the two are not fused.
+  static Opcode FusedOpcode(Opcode first, Opcode second);
+
   // Compute the previous bytecode. Takes time linear in the number of
   // bytecodes in the method.
   static uint8* PreviousBytecode(uint8* current_bcp);
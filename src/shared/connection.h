@@ -84,6 +84,14 @@ class Connection {
     kProcessCompileTimeError,
     kProcessAddFibersToMap,
     kProcessNumberOfStacks,
+    kProcessProfileRequest,
+    kProcessProfile,
+    kGcEventsRequest,
+    kGcEvents,
+    kHeapCensusRequest,
+    kHeapCensus,
+    kLookupCacheStatisticsRequest,
+    kLookupCacheStatistics,
     kWriteSnapshot,
     kCollectGarbage,
 
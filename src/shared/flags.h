@@ -33,6 +33,8 @@ namespace fletch {
       "Validate stack at each interperter step")       \
   BOOLEAN(release, unfold_program, false,              \
       "Unfold the program before running")             \
+  BOOLEAN(release, fuse_bytecodes, true,               \
+      "Fuse common bytecode pairs when folding")       \
   BOOLEAN(release, gc_on_delete, false,                \
       "GC the heap at when terminating isolate")       \
   BOOLEAN(release, validate_heaps, false,              \
@@ -43,6 +45,30 @@ namespace fletch {
       "Log decoding")                                  \
   BOOLEAN(debug, print_program_statistics, false,      \
       "Print statistics about the program")            \
+  BOOLEAN(release, print_bytecode_pairs, false,        \
+      "Print the most common bytecode pairs")          \
+  BOOLEAN(release, print_inline_cache_statistics,      \
+      false, "Print inline cache hits and misses")     \
+  BOOLEAN(debug, lookup_cache_statistics, false,       \
+      "Count lookups (uses the C++ interpreter)")      \
+  INTEGER(release, lookup_cache_resize_threshold, 50,  \
+      "Grow lookup caches above this miss percentage") \
+  BOOLEAN(release, print_gc_statistics, false,         \
+      "Print statistics about process collections")    \
+  INTEGER(release, gc_threads, 0,                      \
+      "Threads for immutable GC (0 for one per core)") \
+  INTEGER(release, finalizer_queue_limit, 67108864,    \
+      "Bytes of native memory waiting for finalizers") \
+  INTEGER(release, process_heap_limit, 0,              \
+      "Bytes a process heap may use (0 for no limit)") \
+  INTEGER(release, immutable_heap_limit, 0,            \
+      "Bytes the immutable heap may use (0 for none)") \
+  BOOLEAN(release, concurrent_immutable_gc, false,     \
+      "Mark the immutable heap concurrently")          \
+  BOOLEAN(release, print_gc_events, false,             \
+      "Print the recent collections as JSON at exit")  \
+  CSTRING(release, gc_events_output, NULL,             \
+      "File for the GC events, instead of stdout")     \
   BOOLEAN(release, verbose, false,                     \
       "Verbose output")                                \
   BOOLEAN(debug, print_flags, false,                   \
@@ -51,6 +77,18 @@ namespace fletch {
       "Profile the execution of the entire VM")        \
   INTEGER(release, profile_interval, 1000,             \
       "Profile interval in us")                        \
+  CSTRING(release, profile_output, NULL,               \
+      "File for the profile, instead of stdout")       \
+  BOOLEAN(release, profile_allocations, false,         \
+      "Sample the stacks of allocations")              \
+  INTEGER(release, allocation_sample_interval, 524288, \
+      "Mean bytes between allocation samples")         \
+  CSTRING(release, allocation_profile_output, NULL,    \
+      "File for the allocation profile")               \
+  BOOLEAN(release, io_uring, false,                    \
+      "Poll for readiness with io_uring (Linux)")      \
+  INTEGER(release, event_handlers, 1,                  \
+      "Number of event handler threads")               \
   CSTRING(release, filter, NULL,                       \
       "Filter string for unit testing")                \
   /* Temporary compiler flags */                       \
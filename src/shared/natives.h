@@ -219,11 +219,18 @@ namespace fletch {
                                                                          \
   N(SystemGetEventHandler,       "System", "_getEventHandler")           \
   N(SystemIncrementPortRef,      "System", "_incrementPortRef")          \
+  N(SystemIsIoUringEventHandler, "System", "_isIoUringEventHandler")     \
+  N(SystemSetPortForNextEvent,   "System", "_setPortForNextEvent")       \
+  N(SystemCancelNextEvent,       "System", "_cancelNextEvent")           \
+                                                                         \
+  N(EventHandlerScheduleTimeout, "<none>", "_scheduleTimeout")           \
+  N(EventHandlerCancelTimeout,   "<none>", "_cancelTimeout")             \
                                                                          \
   N(ServiceRegister,             "<none>", "register")                   \
                                                                          \
   N(IsImmutable,                 "<none>", "_isImmutable")               \
   N(IdentityHashCode,            "<none>", "_identityHashCode")          \
+  N(WriteHeapCensus,             "<none>", "_writeHeapCensus")           \
 
 enum Native {
 #define N(e, c, n) k##e,
@@ -64,6 +64,32 @@ class Platform {
   // Returns the number of available hardware threads.
   static int GetNumberOfHardwareThreads();
 
+  // Tells the processor that the calling thread is spinning.
+  static void Pause() {
+#if defined(FLETCH_TARGET_IA32) || defined(FLETCH_TARGET_X64)
+    __asm__ __volatile__("pause" : : : "memory");
+#else
+    __asm__ __volatile__("" : : : "memory");
+#endif
+  }
+
+  // Gives up the rest of the calling thread's time slice.
+  static void Yield();
+
+  // Maps [size] bytes of page aligned memory. Returns NULL on failure.
+  static void* AllocatePages(uword size);
+
+  // Unmaps memory returned by AllocatePages.
+  static void FreePages(void* address, uword size);
+
+  // Gives the physical memory behind the pages back to the OS. The pages
+  // stay mapped and can still be used.
+  static void ReleasePages(void* address, uword size);
+
+  // Returns the resident set size of this process in bytes, or 0 if it
+  // is not known.
+  static uword GetResidentMemory();
+
   // Load file at 'uri'.
   static List<uint8> LoadFile(const char* name);
 
@@ -5,8 +5,10 @@
 #if defined(FLETCH_TARGET_OS_LINUX)
 
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "src/shared/assert.h"
 #include "src/shared/platform.h"
@@ -24,6 +26,18 @@ void GetPathOfExecutable(char* path, size_t path_length) {
   path[length] = '\0';
 }
 
+uword Platform::GetResidentMemory() {
+  // The second field of statm is the number of resident pages.
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (file == NULL) return 0;
+  uword size = 0;
+  uword resident = 0;
+  int fields = fscanf(file, "%lu %lu", &size, &resident);
+  fclose(file);
+  if (fields != 2) return 0;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
 int Platform::GetLocalTimeZoneOffset() {
   // TODO(ajohnsen): avoid excessive calls to tzset?
   tzset();
@@ -4,6 +4,7 @@
 
 #if defined(FLETCH_TARGET_OS_MACOS)
 
+#include <mach/mach.h>
 #include <mach-o/dyld.h>
 
 #include <CoreFoundation/CFTimeZone.h>
@@ -20,6 +21,16 @@ void GetPathOfExecutable(char* path, size_t path_length) {
   }
 }
 
+uword Platform::GetResidentMemory() {
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  kern_return_t result = task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                                   reinterpret_cast<task_info_t>(&info),
+                                   &count);
+  if (result != KERN_SUCCESS) return 0;
+  return static_cast<uword>(info.resident_size);
+}
+
 int Platform::GetLocalTimeZoneOffset() {
   CFTimeZoneRef tz = CFTimeZoneCopySystem();
   // Even if the offset was 24 hours it would still easily fit into 32 bits.
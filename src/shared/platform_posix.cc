@@ -8,6 +8,7 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <sched.h>
 #include <semaphore.h>
 #include <sys/types.h>  // mmap & munmap
 #include <sys/mman.h>   // mmap & munmap
@@ -54,6 +55,10 @@ int Platform::GetNumberOfHardwareThreads() {
   return hardware_threads_cache_;
 }
 
+void Platform::Yield() {
+  sched_yield();
+}
+
 // Load file at 'uri'.
 List<uint8> Platform::LoadFile(const char* name) {
   // Open the file.
@@ -172,6 +177,20 @@ bool VirtualMemory::Uncommit(uword address, int size) {
               kMmapFd, kMmapFdOffset) != MAP_FAILED;
 }
 
+void* Platform::AllocatePages(uword size) {
+  void* result = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANON, kMmapFd, kMmapFdOffset);
+  return (result == MAP_FAILED) ? NULL : result;
+}
+
+void Platform::FreePages(void* address, uword size) {
+  munmap(address, size);
+}
+
+void Platform::ReleasePages(void* address, uword size) {
+  madvise(address, size, MADV_DONTNEED);
+}
+
 class PosixMutex : public Mutex {
  public:
   PosixMutex() { pthread_mutex_init(&mutex_, NULL);  }
@@ -4,10 +4,13 @@
 
 #include "src/vm/event_handler.h"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "src/shared/flags.h"
 
+#include "src/vm/natives.h"
 #include "src/vm/object.h"
 #include "src/vm/port.h"
 #include "src/vm/process.h"
@@ -16,11 +19,19 @@
 
 namespace fletch {
 
+static int64 CurrentMilliseconds() {
+  return Platform::GetMicroseconds() / 1000;
+}
+
 EventHandler::EventHandler()
     : monitor_(Platform::CreateMonitor()),
       fd_(-1),
+      io_uring_(NULL),
+      requests_(NULL),
       read_fd_(-1),
-      write_fd_(-1) {
+      write_fd_(-1),
+      timer_wheel_(CurrentMilliseconds()),
+      next_timeout_(-1) {
 }
 
 EventHandler::~EventHandler() {
@@ -35,6 +46,13 @@ EventHandler::~EventHandler() {
     thread_.Join();
   }
 
+  // Drop the references held for the timers that never fired.
+  Timer* pending = timer_wheel_.RemoveAll();
+  for (Timer* timer = pending; timer != NULL; timer = timer->next()) {
+    timer->port()->DecrementRef();
+  }
+  TimerWheel::DeleteTimers(pending);
+
   delete monitor_;
 }
 
@@ -46,7 +64,16 @@ void* RunEventHandler(void* peer) {
 
 int EventHandler::GetEventHandler() {
   ScopedMonitorLock locker(monitor_);
+  return EnsureInitialized();
+}
 
+bool EventHandler::UsesIoUring() {
+  ScopedMonitorLock locker(monitor_);
+  EnsureInitialized();
+  return io_uring_ != NULL;
+}
+
+int EventHandler::EnsureInitialized() {
   if (fd_ >= 0) {
     return fd_;
   }
@@ -57,10 +84,74 @@ int EventHandler::GetEventHandler() {
   if (pipe(fds) != 0) FATAL("Failed to start the event handler pipe\n");
   read_fd_ = fds[0];
   write_fd_ = fds[1];
+  // Neither the event handler thread nor a thread scheduling a timeout may
+  // block on the pipe; any pending byte is enough to wake up the handler.
+  fcntl(read_fd_, F_SETFL, fcntl(read_fd_, F_GETFL) | O_NONBLOCK);
+  fcntl(write_fd_, F_SETFL, fcntl(write_fd_, F_GETFL) | O_NONBLOCK);
   thread_ = Thread::Run(RunEventHandler, reinterpret_cast<void*>(this));
   return fd_;
 }
 
+void EventHandler::ScheduleTimeout(int64 milliseconds, Port* port) {
+  ScopedMonitorLock locker(monitor_);
+  EnsureInitialized();
+
+  int64 deadline = CurrentMilliseconds() + milliseconds;
+  // The wheel keeps a reference to the port until the timer either fires or
+  // is cancelled.
+  if (timer_wheel_.Schedule(port, deadline)) port->IncrementRef();
+
+  // Wake up the event handler if it would otherwise sleep past the deadline.
+  if (next_timeout_ == -1 || deadline < next_timeout_) {
+    next_timeout_ = deadline;
+    char byte = 0;
+    int result;
+    do {
+      result = write(write_fd_, &byte, 1);
+    } while (result == -1 && errno == EINTR);
+  }
+}
+
+void EventHandler::CancelTimeout(Port* port) {
+  ScopedMonitorLock locker(monitor_);
+  if (timer_wheel_.Cancel(port)) port->DecrementRef();
+}
+
+int EventHandler::HandleTimeouts() {
+  int64 now = CurrentMilliseconds();
+  Timer* expired;
+  int64 next;
+  {
+    ScopedMonitorLock locker(monitor_);
+    expired = timer_wheel_.Advance(now);
+    next = timer_wheel_.NextTick();
+    next_timeout_ = next;
+  }
+
+  for (Timer* timer = expired; timer != NULL; timer = timer->next()) {
+    Send(timer->port(), 0);
+  }
+  TimerWheel::DeleteTimers(expired);
+
+  if (next == -1) return -1;
+  int64 timeout = next - now;
+  if (timeout < 0) return 0;
+  // The next tick is never more than a full rotation of the wheel ahead, so
+  // this fits in an int.
+  return static_cast<int>(timeout);
+}
+
+bool EventHandler::HandleInterrupt() {
+  char buffer[64];
+  while (true) {
+    int result = read(read_fd_, buffer, sizeof(buffer));
+    if (result > 0) continue;
+    if (result == 0) return false;
+    if (errno == EINTR) continue;
+    return true;
+  }
+}
+
 void EventHandler::Send(Port* port, uword mask) {
   Object* message = Smi::FromWord(mask);
   port->Lock();
@@ -74,4 +165,110 @@ void EventHandler::Send(Port* port, uword mask) {
   port->DecrementRef();
 }
 
+void EventHandler::SendBatch(Port** ports, uword* masks, int count) {
+  ASSERT(count <= kMaxBatchSize);
+  // The ports are kept locked until the processes have been resumed, so the
+  // processes stay alive. The same port may show up more than once.
+  Port* locked[kMaxBatchSize];
+  int locked_count = 0;
+  Process* processes[kMaxBatchSize];
+  int process_count = 0;
+
+  for (int i = 0; i < count; i++) {
+    Port* port = ports[i];
+    bool is_locked = false;
+    for (int j = 0; j < locked_count; j++) {
+      if (locked[j] == port) {
+        is_locked = true;
+        break;
+      }
+    }
+    if (!is_locked) {
+      port->Lock();
+      locked[locked_count++] = port;
+    }
+
+    Process* port_process = port->process();
+    if (port_process == NULL) continue;
+    bool enqueued = port_process->Enqueue(port, Smi::FromWord(masks[i]));
+    ASSERT(enqueued);
+
+    bool is_known = false;
+    for (int j = 0; j < process_count; j++) {
+      if (processes[j] == port_process) {
+        is_known = true;
+        break;
+      }
+    }
+    if (!is_known) processes[process_count++] = port_process;
+  }
+
+  for (int i = 0; i < process_count; i++) {
+    Process* process = processes[i];
+    process->program()->scheduler()->ResumeProcess(process);
+  }
+  for (int i = 0; i < locked_count; i++) locked[i]->Unlock();
+  // Every event holds its own reference to the port.
+  for (int i = 0; i < count; i++) ports[i]->DecrementRef();
+}
+
+static Port* PortFromInstance(Object* object) {
+  Instance* instance = Instance::cast(object);
+  ASSERT(instance->IsPort());
+  uword address = AsForeignWord(instance->GetInstanceField(0));
+  return reinterpret_cast<Port*>(address);
+}
+
+NATIVE(SystemIsIoUringEventHandler) {
+  // All shards use the same kind of event handler.
+  bool result = process->program()->event_handler(0)->UsesIoUring();
+  return result
+      ? process->program()->true_object()
+      : process->program()->false_object();
+}
+
+NATIVE(SystemSetPortForNextEvent) {
+  Object* fd = arguments[0];
+  Object* mask = arguments[2];
+  if (!fd->IsSmi() || !mask->IsSmi()) return Failure::wrong_argument_type();
+  if (!arguments[1]->IsPort()) return Failure::wrong_argument_type();
+  Port* port = PortFromInstance(arguments[1]);
+  if (port == NULL) return Failure::illegal_state();
+  int value = Smi::cast(fd)->value();
+  int result = process->program()->EventHandlerForFd(value)->
+      SetPortForNextEvent(value, port, Smi::cast(mask)->value());
+  return Smi::FromWord(result);
+}
+
+NATIVE(SystemCancelNextEvent) {
+  Object* fd = arguments[0];
+  if (!fd->IsSmi()) return Failure::wrong_argument_type();
+  int value = Smi::cast(fd)->value();
+  int result =
+      process->program()->EventHandlerForFd(value)->CancelNextEvent(value);
+  return Smi::FromWord(result);
+}
+
+NATIVE(EventHandlerScheduleTimeout) {
+  Object* milliseconds = arguments[0];
+  if (!milliseconds->IsSmi() && !milliseconds->IsLargeInteger()) {
+    return Failure::wrong_argument_type();
+  }
+  if (!arguments[1]->IsPort()) return Failure::wrong_argument_type();
+  Port* port = PortFromInstance(arguments[1]);
+  if (port == NULL) return Failure::illegal_state();
+  int64 value = AsForeignWord(milliseconds);
+  if (value < 0) value = 0;
+  process->program()->EventHandlerForPort(port)->ScheduleTimeout(value, port);
+  return process->program()->null_object();
+}
+
+NATIVE(EventHandlerCancelTimeout) {
+  if (!arguments[0]->IsPort()) return Failure::wrong_argument_type();
+  Port* port = PortFromInstance(arguments[0]);
+  if (port == NULL) return Failure::illegal_state();
+  process->program()->EventHandlerForPort(port)->CancelTimeout(port);
+  return process->program()->null_object();
+}
+
 }  // namespace fletch
@@ -6,10 +6,13 @@
 #define SRC_VM_EVENT_HANDLER_H_
 
 #include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
 #include "src/vm/thread.h"
+#include "src/vm/timer_wheel.h"
 
 namespace fletch {
 
+class IoUring;
 class Monitor;
 class Port;
 
@@ -22,6 +25,9 @@ class EventHandler {
     ERROR_EVENT       = 1 << 3,
   };
 
+  // The maximum number of events handled per wakeup.
+  static const int kMaxBatchSize = 64;
+
   EventHandler();
   ~EventHandler();
 
@@ -29,18 +35,67 @@ class EventHandler {
 
   Monitor* monitor() const { return monitor_; }
 
+  // Send a message to [port] in [milliseconds]. If the port already had a
+  // timeout, it is replaced by the new one.
+  void ScheduleTimeout(int64 milliseconds, Port* port);
+  void CancelTimeout(Port* port);
+
+  // Whether the event handler waits for readiness with io_uring polls
+  // instead of epoll. Selected with the io_uring flag when the event handler
+  // starts, and only on Linux. Either way, the Dart code does the reads,
+  // writes and accepts itself once a socket is ready.
+  bool UsesIoUring();
+
+  // With io_uring, sockets are not registered by the Dart code. These arm
+  // [fd] to send the events in [mask] to [port] once, and cancel that again.
+  // They return -1 on failure, and once the event handler has shut down.
+  int SetPortForNextEvent(int fd, Port* port, int mask);
+  int CancelNextEvent(int fd);
+
   int Create();
   void Run();
 
  private:
+  class PollRequest;
+
   Monitor* monitor_;
   int fd_;
   ThreadIdentifier thread_;
 
+  // Only used with io_uring. The pending polls and all requests that have
+  // not completed yet are protected by [monitor_].
+  IoUring* io_uring_;
+  HashMap<uword, PollRequest*> polls_;
+  PollRequest* requests_;
+
   int read_fd_;
   int write_fd_;
 
+  // Protected by [monitor_].
+  TimerWheel timer_wheel_;
+  // The time the event handler thread will wake up by itself, or -1 if it is
+  // waiting for I/O events only.
+  int64 next_timeout_;
+
+  int EnsureInitialized();
+
+  void RunEpoll();
+  void RunIoUring();
+  void Shutdown();
+
+  // Send messages to all ports whose timeout has expired. Returns the number
+  // of milliseconds until the next timeout, or -1 if there is none.
+  int HandleTimeouts();
+
+  // Drain the wakeup pipe. Returns false if the pipe was closed, in which
+  // case the event handler thread should shut down.
+  bool HandleInterrupt();
+
   void Send(Port* port, uword mask);
+
+  // Send the messages for a batch of [count] events. Every process is resumed
+  // at most once, after all its messages have been enqueued.
+  void SendBatch(Port** ports, uword* masks, int count);
 };
 
 }  // namespace fletch
@@ -6,10 +6,17 @@
 
 #include "src/vm/event_handler.h"
 
+#include <errno.h>
+#include <poll.h>
 #include <sys/epoll.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "src/shared/flags.h"
+#include "src/shared/utils.h"
+
+#include "src/vm/io_uring.h"
+#include "src/vm/port.h"
 #include "src/vm/thread.h"
 
 // Some versions of android sys/epoll does not define
@@ -19,42 +26,246 @@
 #define EPOLLRDHUP 0x2000
 #endif  // !defined(EPOLLRDHUP)
 
+#if !defined(POLLRDHUP)
+#define POLLRDHUP 0x2000
+#endif  // !defined(POLLRDHUP)
+
 namespace fletch {
 
+// A pending io_uring poll. The user data of the poll points to it. It holds
+// a reference to [port] until the poll completes. All requests are linked
+// together, including those that were replaced or cancelled but have not
+// completed yet, so they can be released when the event handler shuts down.
+class EventHandler::PollRequest {
+ public:
+  PollRequest(int fd, Port* port)
+      : fd(fd), port(port), previous_(NULL), next_(NULL) { }
+
+  void Link(PollRequest** list) {
+    next_ = *list;
+    if (next_ != NULL) next_->previous_ = this;
+    *list = this;
+  }
+
+  void Unlink(PollRequest** list) {
+    if (next_ != NULL) next_->previous_ = previous_;
+    if (previous_ != NULL) {
+      previous_->next_ = next_;
+    } else {
+      *list = next_;
+    }
+  }
+
+  PollRequest* next() const { return next_; }
+
+  const int fd;
+  Port* const port;
+
+ private:
+  PollRequest* previous_;
+  PollRequest* next_;
+};
+
+// The user data of the poll on the wakeup pipe. Poll requests are always
+// aligned, so this can never be confused with one.
+static const uint64 kInterruptUserData = 1;
+
+static const int kIoUringEntries = 256;
+
 int EventHandler::Create() {
+  if (Flags::io_uring) {
+    io_uring_ = IoUring::Create(kIoUringEntries);
+    if (io_uring_ != NULL) return io_uring_->fd();
+    if (Flags::verbose) {
+      Print::Error("io_uring is not available, using epoll instead\n");
+    }
+  }
   return epoll_create(1);
 }
 
 void EventHandler::Run() {
+  if (io_uring_ != NULL) {
+    RunIoUring();
+  } else {
+    RunEpoll();
+  }
+}
+
+void EventHandler::Shutdown() {
+  close(read_fd_);
+
+  ScopedMonitorLock locker(monitor_);
+  if (io_uring_ != NULL) {
+    // Closing the ring cancels all the pending polls. Tear it down while
+    // holding the lock, so no other thread can submit to it afterwards.
+    delete io_uring_;
+    io_uring_ = NULL;
+  } else {
+    close(fd_);
+  }
+  // The completions of the remaining requests will never be read, so
+  // release them like the completions would have.
+  PollRequest* request = requests_;
+  while (request != NULL) {
+    PollRequest* next = request->next();
+    request->port->DecrementRef();
+    delete request;
+    request = next;
+  }
+  requests_ = NULL;
+  HashMap<uword, PollRequest*> empty;
+  polls_.Swap(empty);
+  fd_ = -1;
+  monitor_->Notify();
+}
+
+void EventHandler::RunEpoll() {
   struct epoll_event event;
-  event.events = EPOLLHUP | EPOLLRDHUP;
+  event.events = EPOLLIN | EPOLLHUP | EPOLLRDHUP;
   event.data.fd = read_fd_;
   epoll_ctl(fd_, EPOLL_CTL_ADD, read_fd_, &event);
+
+  struct epoll_event events[kMaxBatchSize];
+  Port* ports[kMaxBatchSize];
+  uword masks[kMaxBatchSize];
   while (true) {
-    int status = epoll_wait(fd_, &event, 1, -1);
-    if (status != 1) continue;
+    int timeout = HandleTimeouts();
+    int status = epoll_wait(fd_, events, kMaxBatchSize, timeout);
+    if (status <= 0) continue;
+
+    int count = 0;
+    bool shutdown = false;
+    for (int i = 0; i < status; i++) {
+      if (events[i].data.fd == read_fd_) {
+        if (!HandleInterrupt()) shutdown = true;
+        continue;
+      }
 
-    if (event.data.fd == read_fd_) {
-      close(read_fd_);
-      close(fd_);
+      int flags = events[i].events;
+      word mask = 0;
+      if ((flags & EPOLLIN) != 0) mask |= READ_EVENT;
+      if ((flags & EPOLLOUT) != 0) mask |= WRITE_EVENT;
+      if ((flags & EPOLLRDHUP) != 0) mask |= CLOSE_EVENT;
+      if ((flags & EPOLLHUP) != 0) mask |= CLOSE_EVENT;
+      if ((flags & EPOLLERR) != 0) mask |= ERROR_EVENT;
 
-      ScopedMonitorLock locker(monitor_);
-      fd_ = -1;
-      monitor_->Notify();
+      ports[count] = reinterpret_cast<Port*>(events[i].data.ptr);
+      masks[count] = mask;
+      count++;
+    }
+    if (count > 0) SendBatch(ports, masks, count);
+
+    if (shutdown) {
+      Shutdown();
+      return;
+    }
+  }
+}
+
+void EventHandler::RunIoUring() {
+  io_uring_->PollAdd(read_fd_, POLLIN, kInterruptUserData);
+
+  Port* ports[kMaxBatchSize];
+  uword masks[kMaxBatchSize];
+  while (true) {
+    int timeout = HandleTimeouts();
+    io_uring_->Wait(timeout);
+
+    int count = 0;
+    bool shutdown = false;
+    uint64 user_data;
+    int32 result;
+    while (count < kMaxBatchSize &&
+           io_uring_->NextCompletion(&user_data, &result)) {
+      if (user_data == IoUring::kIgnoredUserData) continue;
+
+      if (user_data == kInterruptUserData) {
+        if (HandleInterrupt()) {
+          io_uring_->PollAdd(read_fd_, POLLIN, kInterruptUserData);
+        } else {
+          shutdown = true;
+        }
+        continue;
+      }
+
+      PollRequest* request = reinterpret_cast<PollRequest*>(user_data);
+      {
+        ScopedMonitorLock locker(monitor_);
+        HashMap<uword, PollRequest*>::ConstIterator it =
+            polls_.Find(request->fd);
+        if (it != polls_.End() && it->second == request) polls_.Erase(it);
+        request->Unlink(&requests_);
+      }
+      Port* port = request->port;
+      delete request;
+
+      if (result < 0) {
+        // The poll was cancelled or replaced.
+        port->DecrementRef();
+        continue;
+      }
+
+      word mask = 0;
+      if ((result & POLLIN) != 0) mask |= READ_EVENT;
+      if ((result & POLLOUT) != 0) mask |= WRITE_EVENT;
+      if ((result & POLLRDHUP) != 0) mask |= CLOSE_EVENT;
+      if ((result & POLLHUP) != 0) mask |= CLOSE_EVENT;
+      if ((result & POLLERR) != 0) mask |= ERROR_EVENT;
+
+      ports[count] = port;
+      masks[count] = mask;
+      count++;
+    }
+    if (count > 0) SendBatch(ports, masks, count);
+
+    if (shutdown) {
+      Shutdown();
       return;
     }
+  }
+}
+
+int EventHandler::SetPortForNextEvent(int fd, Port* port, int mask) {
+  ScopedMonitorLock locker(monitor_);
+  EnsureInitialized();
+  if (io_uring_ == NULL) return -1;
+
+  uint32 events = POLLRDHUP | POLLHUP;
+  if ((mask & READ_EVENT) != 0) events |= POLLIN;
+  if ((mask & WRITE_EVENT) != 0) events |= POLLOUT;
 
-    int events = event.events;
-    word mask = 0;
-    if ((events & EPOLLIN) != 0) mask |= READ_EVENT;
-    if ((events & EPOLLOUT) != 0) mask |= WRITE_EVENT;
-    if ((events & EPOLLRDHUP) != 0) mask |= CLOSE_EVENT;
-    if ((events & EPOLLHUP) != 0) mask |= CLOSE_EVENT;
-    if ((events & EPOLLERR) != 0) mask |= ERROR_EVENT;
+  // Like with EPOLLONESHOT, arming the socket again replaces the previous
+  // registration.
+  HashMap<uword, PollRequest*>::ConstIterator it = polls_.Find(fd);
+  if (it != polls_.End()) {
+    io_uring_->PollRemove(reinterpret_cast<uint64>(it->second));
+    polls_.Erase(it);
+  }
 
-    Port* port = reinterpret_cast<Port*>(event.data.ptr);
-    Send(port, mask);
+  PollRequest* request = new PollRequest(fd, port);
+  port->IncrementRef();
+  polls_[fd] = request;
+  request->Link(&requests_);
+  if (!io_uring_->PollAdd(fd, events, reinterpret_cast<uint64>(request))) {
+    polls_.Erase(polls_.Find(fd));
+    request->Unlink(&requests_);
+    delete request;
+    port->DecrementRef();
+    return -1;
   }
+  return 0;
+}
+
+int EventHandler::CancelNextEvent(int fd) {
+  ScopedMonitorLock locker(monitor_);
+  if (io_uring_ == NULL) return -1;
+  HashMap<uword, PollRequest*>::ConstIterator it = polls_.Find(fd);
+  if (it == polls_.End()) return 0;
+  // The request and its port reference are released when the cancelled poll
+  // completes.
+  bool removed = io_uring_->PollRemove(reinterpret_cast<uint64>(it->second));
+  polls_.Erase(it);
+  return removed ? 0 : -1;
 }
 
 }  // namespace fletch
@@ -8,8 +8,11 @@
 
 #include <sys/event.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include "src/shared/assert.h"
+
 #include "src/vm/thread.h"
 
 namespace fletch {
@@ -18,6 +21,16 @@ int EventHandler::Create() {
   return kqueue();
 }
 
+int EventHandler::SetPortForNextEvent(int fd, Port* port, int mask) {
+  UNREACHABLE();
+  return -1;
+}
+
+int EventHandler::CancelNextEvent(int fd) {
+  UNREACHABLE();
+  return -1;
+}
+
 void EventHandler::Run() {
   struct kevent event = {};
   event.ident = read_fd_;
@@ -25,10 +38,16 @@ void EventHandler::Run() {
   event.filter = EVFILT_READ;
   kevent(fd_, &event, 1, NULL, 0, NULL);
   while (true) {
-    int status = kevent(fd_, NULL, 0, &event, 1, NULL);
+    int timeout = HandleTimeouts();
+    struct timespec ts;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    int status = kevent(fd_, NULL, 0, &event, 1, timeout == -1 ? NULL : &ts);
     if (status != 1) continue;
 
     if (event.ident == static_cast<uintptr_t>(read_fd_)) {
+      if (HandleInterrupt()) continue;
+
       close(read_fd_);
       close(fd_);
       ScopedMonitorLock locker(monitor_);
@@ -0,0 +1,104 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/finalizer_queue.h"
+
+#include "src/shared/flags.h"
+#include "src/shared/platform.h"
+
+namespace fletch {
+
+Monitor* FinalizerQueue::monitor_ = NULL;
+ThreadIdentifier FinalizerQueue::thread_;
+std::vector<FinalizerQueue::Entry>* FinalizerQueue::entries_ = NULL;
+uword FinalizerQueue::pending_size_ = 0;
+bool FinalizerQueue::running_ = false;
+bool FinalizerQueue::busy_ = false;
+bool FinalizerQueue::shutting_down_ = false;
+
+void FinalizerQueue::Setup() {
+  monitor_ = Platform::CreateMonitor();
+  entries_ = new std::vector<Entry>();
+  pending_size_ = 0;
+  running_ = true;
+  busy_ = false;
+  shutting_down_ = false;
+  thread_ = Thread::Run(RunThread);
+}
+
+void FinalizerQueue::TearDown() {
+  // The finalizer thread runs the queued finalizers before it stops.
+  {
+    ScopedMonitorLock lock(monitor_);
+    running_ = false;
+    shutting_down_ = true;
+    monitor_->NotifyAll();
+  }
+  thread_.Join();
+  ASSERT(entries_->empty());
+  delete entries_;
+  entries_ = NULL;
+  delete monitor_;
+  monitor_ = NULL;
+}
+
+void FinalizerQueue::Enqueue(Finalizer finalizer, void* data, uword size) {
+  if (monitor_ != NULL) {
+    ScopedMonitorLock lock(monitor_);
+    uword limit = Flags::finalizer_queue_limit;
+    if (running_ && pending_size_ + size <= limit) {
+      Entry entry = { finalizer, data, size };
+      entries_->push_back(entry);
+      pending_size_ += size;
+      monitor_->NotifyAll();
+      return;
+    }
+  }
+  finalizer(data);
+}
+
+void FinalizerQueue::Flush() {
+  if (monitor_ == NULL) return;
+  ScopedMonitorLock lock(monitor_);
+  while (!entries_->empty() || busy_) monitor_->Wait();
+}
+
+uword FinalizerQueue::pending_size() {
+  if (monitor_ == NULL) return 0;
+  ScopedMonitorLock lock(monitor_);
+  return pending_size_;
+}
+
+void* FinalizerQueue::RunThread(void* data) {
+  MainLoop();
+  return NULL;
+}
+
+void FinalizerQueue::MainLoop() {
+  std::vector<Entry> batch;
+  monitor_->Lock();
+  while (true) {
+    while (entries_->empty() && !shutting_down_) monitor_->Wait();
+    if (entries_->empty()) break;
+
+    // Run the finalizers without holding the lock, so the GC can keep
+    // queueing more.
+    batch.swap(*entries_);
+    busy_ = true;
+    monitor_->Unlock();
+    uword size = 0;
+    for (size_t i = 0; i < batch.size(); i++) {
+      batch[i].finalizer(batch[i].data);
+      size += batch[i].size;
+    }
+    batch.clear();
+    monitor_->Lock();
+    pending_size_ -= size;
+    busy_ = false;
+    monitor_->NotifyAll();
+  }
+  monitor_->Unlock();
+}
+
+}  // namespace fletch
@@ -0,0 +1,63 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_FINALIZER_QUEUE_H_
+#define SRC_VM_FINALIZER_QUEUE_H_
+
+#include <vector>
+
+#include "src/shared/globals.h"
+#include "src/vm/thread.h"
+
+namespace fletch {
+
+class Monitor;
+
+// Runs the native part of finalizers on a thread of its own, so freeing
+// native memory does not add to the GC pauses of processes. A weak pointer
+// callback reads what it needs from the dead object while the GC still
+// has it, and queues the rest here.
+//
+// The native memory waiting to be freed is bounded by
+// [Flags::finalizer_queue_limit]. Finalizers that do not fit, and all
+// finalizers before [Setup] or after [TearDown], run right away.
+class FinalizerQueue {
+ public:
+  typedef void (*Finalizer)(void* data);
+
+  static void Setup();
+  static void TearDown();
+
+  // Calls [finalizer] with [data] on the finalizer thread. [size] is the
+  // amount of native memory the finalizer frees.
+  static void Enqueue(Finalizer finalizer, void* data, uword size);
+
+  // Waits until all the queued finalizers have run.
+  static void Flush();
+
+  // The native memory the queued finalizers will free.
+  static uword pending_size();
+
+ private:
+  struct Entry {
+    Finalizer finalizer;
+    void* data;
+    uword size;
+  };
+
+  static void* RunThread(void* data);
+  static void MainLoop();
+
+  static Monitor* monitor_;
+  static ThreadIdentifier thread_;
+  static std::vector<Entry>* entries_;
+  static uword pending_size_;
+  static bool running_;
+  static bool busy_;
+  static bool shutting_down_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_FINALIZER_QUEUE_H_
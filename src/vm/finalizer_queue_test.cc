@@ -0,0 +1,44 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/flags.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/finalizer_queue.h"
+#include "src/vm/thread.h"
+
+namespace fletch {
+
+static int finalized = 0;
+static int finalized_here = 0;
+
+static void CountFinalized(void* data) {
+  finalized++;
+  if (reinterpret_cast<ThreadIdentifier*>(data)->IsSelf()) finalized_here++;
+}
+
+TEST_CASE(FinalizerQueue) {
+  ThreadIdentifier self;
+  finalized = 0;
+  finalized_here = 0;
+
+  // Queued finalizers run on the finalizer thread.
+  for (int i = 0; i < 100; i++) {
+    FinalizerQueue::Enqueue(CountFinalized, &self, 1);
+  }
+  FinalizerQueue::Flush();
+  EXPECT_EQ(finalized, 100);
+  EXPECT_EQ(finalized_here, 0);
+  EXPECT(FinalizerQueue::pending_size() == 0);
+
+  // Finalizers that would free more than the limit run right away.
+  uword limit = Flags::finalizer_queue_limit;
+  FinalizerQueue::Enqueue(CountFinalized, &self, limit + 1);
+  EXPECT_EQ(finalized, 101);
+  EXPECT_EQ(finalized_here, 1);
+  FinalizerQueue::Flush();
+}
+
+}  // namespace fletch
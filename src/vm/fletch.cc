@@ -7,6 +7,7 @@
 #include "src/shared/platform.h"
 
 #include "src/vm/ffi.h"
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/object_memory.h"
 #include "src/vm/thread.h"
 
@@ -16,9 +17,11 @@ void Fletch::Setup() {
   Platform::Setup();
   ObjectMemory::Setup();
   ForeignFunctionInterface::Setup();
+  FinalizerQueue::Setup();
 }
 
 void Fletch::TearDown() {
+  FinalizerQueue::TearDown();
   ForeignFunctionInterface::TearDown();
   ObjectMemory::TearDown();
 }
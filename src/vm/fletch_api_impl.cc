@@ -9,12 +9,15 @@
 #include "src/shared/connection.h"
 #endif
 #include "src/shared/fletch.h"
+#include "src/shared/flags.h"
 #include "src/shared/list.h"
+#include "src/shared/utils.h"
 
 #include "src/vm/android_print_interceptor.h"
 #include "src/vm/ffi.h"
 #include "src/vm/program.h"
 #include "src/vm/program_folder.h"
+#include "src/vm/profiler.h"
 #include "src/vm/scheduler.h"
 #include "src/vm/session.h"
 #include "src/vm/snapshot.h"
@@ -41,6 +44,24 @@ static bool RunSnapshot(List<uint8> bytes) {
     scheduler.ScheduleProgram(program, process);
     bool success = scheduler.Run();
     scheduler.UnscheduleProgram(program);
+    if (Flags::profile) {
+      const char* path = Flags::profile_output;
+      if (!program->profile()->PrintFoldedStacks(path)) {
+        Print::Error("Failed to write profile to %s\n", path);
+      }
+    }
+    if (Flags::profile_allocations) {
+      const char* path = Flags::allocation_profile_output;
+      if (!program->allocation_profile()->PrintFoldedStacks(path)) {
+        Print::Error("Failed to write allocation profile to %s\n", path);
+      }
+    }
+    if (Flags::print_gc_events) {
+      const char* path = Flags::gc_events_output;
+      if (!program->gc_events()->PrintJson(path)) {
+        Print::Error("Failed to write GC events to %s\n", path);
+      }
+    }
     delete program;
 #if defined(__ANDROID__)
     Print::UnregisterPrintInterceptors();
@@ -0,0 +1,99 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/gc_events.h"
+
+#include <stdio.h>
+
+#include "src/shared/platform.h"
+#include "src/shared/utils.h"
+
+namespace fletch {
+
+const char* GcEvent::KindName(Kind kind) {
+  switch (kind) {
+    case kProcessYoung: return "process-young";
+    case kProcessFull: return "process-full";
+    case kImmutableScavenge: return "immutable-scavenge";
+    case kImmutableMarkSweep: return "immutable-mark-sweep";
+    case kProgram: return "program";
+  }
+  UNREACHABLE();
+  return NULL;
+}
+
+GcEventLog::GcEventLog()
+    : mutex_(Platform::CreateMutex()),
+      events_(new GcEvent[kCapacity]),
+      count_(0) {
+}
+
+GcEventLog::~GcEventLog() {
+  delete[] events_;
+  delete mutex_;
+}
+
+void GcEventLog::Record(const GcEvent& event) {
+  ScopedLock locker(mutex_);
+  events_[count_ % kCapacity] = event;
+  count_++;
+}
+
+int64 GcEventLog::count() {
+  ScopedLock locker(mutex_);
+  return count_;
+}
+
+int GcEventLog::CopyEvents(GcEvent* events) {
+  ScopedLock locker(mutex_);
+  int64 first = (count_ > kCapacity) ? count_ - kCapacity : 0;
+  int length = static_cast<int>(count_ - first);
+  for (int i = 0; i < length; i++) {
+    events[i] = events_[(first + i) % kCapacity];
+  }
+  return length;
+}
+
+static void PrintLine(FILE* file, const char* line) {
+  if (file != NULL) {
+    fprintf(file, "%s\n", line);
+  } else {
+    Print::Out("%s\n", line);
+  }
+}
+
+bool GcEventLog::PrintJson(const char* path) {
+  FILE* file = NULL;
+  if (path != NULL) {
+    file = fopen(path, "w");
+    if (file == NULL) return false;
+  }
+  GcEvent* events = new GcEvent[kCapacity];
+  int length = CopyEvents(events);
+  PrintLine(file, "[");
+  for (int i = 0; i < length; i++) {
+    GcEvent* event = &events[i];
+    char line[256];
+    snprintf(line, sizeof(line),
+             "  {\"kind\": \"%s\", \"process\": %lu, \"start\": %llu, "
+             "\"end\": %llu, \"size_before\": %d, \"size_after\": %d, "
+             "\"promoted\": %d, \"wait\": %llu}%s",
+             GcEvent::KindName(event->kind),
+             event->process,
+             static_cast<unsigned long long>(event->start),  // NOLINT
+             static_cast<unsigned long long>(event->end),  // NOLINT
+             event->size_before,
+             event->size_after,
+             event->promoted,
+             static_cast<unsigned long long>(event->wait),  // NOLINT
+             (i == length - 1) ? "" : ",");
+    PrintLine(file, line);
+  }
+  PrintLine(file, "]");
+  delete[] events;
+  if (file != NULL) fclose(file);
+  return true;
+}
+
+}  // namespace fletch
@@ -0,0 +1,85 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_GC_EVENTS_H_
+#define SRC_VM_GC_EVENTS_H_
+
+#include "src/shared/globals.h"
+
+namespace fletch {
+
+class Mutex;
+
+// A single collection. Times are in microseconds since the epoch and sizes
+// in bytes.
+struct GcEvent {
+  enum Kind {
+    kProcessYoung,
+    kProcessFull,
+    kImmutableScavenge,
+    kImmutableMarkSweep,
+    kProgram,
+  };
+
+  GcEvent() : GcEvent(kProgram, 0, 0) { }
+
+  GcEvent(Kind kind, uword process, uint64 start)
+      : kind(kind),
+        process(process),
+        start(start),
+        end(start),
+        size_before(0),
+        size_after(0),
+        promoted(0),
+        wait(0) { }
+
+  static const char* KindName(Kind kind);
+
+  Kind kind;
+  // Identifies the collected process. Zero for program-wide collections.
+  uword process;
+  uint64 start;
+  uint64 end;
+  int size_before;
+  int size_after;
+  // Bytes promoted to the old generation by a young collection.
+  int promoted;
+  // Time spent waiting for the other threads to stop.
+  uint64 wait;
+};
+
+// Ring buffer with the most recent collections of a program. Processes
+// record their collections from the threads they run on, so recording
+// takes a lock.
+class GcEventLog {
+ public:
+  static const int kCapacity = 1024;
+
+  GcEventLog();
+  ~GcEventLog();
+
+  void Record(const GcEvent& event);
+
+  // The number of events recorded so far, including the ones that have
+  // been overwritten.
+  int64 count();
+
+  // Copies the events still in the buffer, oldest first, to [events], which
+  // must have room for [kCapacity] of them. Returns the number of events.
+  int CopyEvents(GcEvent* events);
+
+  // Prints the events in the buffer as a JSON array to the file at [path],
+  // or to stdout if [path] is NULL. Returns false if the file could not be
+  // written.
+  bool PrintJson(const char* path);
+
+ private:
+  Mutex* const mutex_;
+  GcEvent* const events_;
+  int64 count_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_GC_EVENTS_H_
@@ -0,0 +1,44 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/gc_events.h"
+
+namespace fletch {
+
+static GcEvent MakeEvent(int i) {
+  GcEvent event(GcEvent::kProcessYoung, 1, i);
+  event.end = i + 1;
+  event.size_before = i;
+  return event;
+}
+
+TEST_CASE(GcEventLog) {
+  GcEventLog log;
+  GcEvent* events = new GcEvent[GcEventLog::kCapacity];
+  EXPECT_EQ(log.CopyEvents(events), 0);
+
+  log.Record(MakeEvent(0));
+  log.Record(MakeEvent(1));
+  EXPECT_EQ(log.count(), 2);
+  EXPECT_EQ(log.CopyEvents(events), 2);
+  EXPECT_EQ(events[0].size_before, 0);
+  EXPECT_EQ(events[1].size_before, 1);
+
+  // Once the buffer is full, the oldest events are overwritten.
+  int capacity = GcEventLog::kCapacity;
+  int total = capacity + 10;
+  for (int i = 2; i < total; i++) log.Record(MakeEvent(i));
+  EXPECT_EQ(log.count(), total);
+  int length = log.CopyEvents(events);
+  EXPECT_EQ(length, capacity);
+  for (int i = 0; i < length; i++) {
+    EXPECT_EQ(events[i].size_before, i + 10);
+  }
+  delete[] events;
+}
+
+}  // namespace fletch
@@ -87,6 +87,11 @@ void GCThread::Resume() {
   }
 }
 
+bool GCThread::IsPauseRequested() {
+  ScopedMonitorLock lock(gc_thread_monitor_);
+  return pause_count_ > 0;
+}
+
 void GCThread::StopThread() {
   // Tell thread he should stop.
   {
@@ -22,6 +22,10 @@ class GCThread {
   void Resume();
   void StopThread();
 
+  // Tells whether someone is waiting in [Pause]. Long running collections
+  // check this to give up early.
+  bool IsPauseRequested();
+
  private:
   static void* GCThreadEntryPoint(void *data);
 
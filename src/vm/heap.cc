@@ -13,16 +13,20 @@
 namespace fletch {
 
 Heap::Heap(RandomLCG* random, int maximum_initial_size)
-    : random_(random), space_(NULL), weak_pointers_(NULL) {
+    : random_(random),
+      space_(NULL),
+      large_object_space_(NULL) {
   space_ = new Space(maximum_initial_size);
   AdjustAllocationBudget();
 }
 
-Heap::Heap(Space* existing_space, WeakPointer* weak_pointers)
-    : random_(NULL), space_(existing_space), weak_pointers_(weak_pointers) { }
+Heap::Heap(Space* existing_space)
+    : random_(NULL),
+      space_(existing_space),
+      large_object_space_(NULL) { }
 
 Heap::~Heap() {
-  WeakPointer::ForceCallbacks(&weak_pointers_);
+  weak_pointers_.ForceCallbacks();
   delete space_;
 }
 
@@ -55,8 +59,15 @@ Object* Heap::CreateInstance(Class* the_class,
 Object* Heap::CreateArray(Class* the_class, int length, Object* init_value) {
   ASSERT(the_class->instance_format().type() == InstanceFormat::ARRAY_TYPE);
   int size = Array::AllocationSize(length);
-  Object* raw_result = Allocate(size);
-  if (raw_result->IsFailure()) return raw_result;
+  Object* raw_result;
+  if (size >= kLargeObjectSize && large_object_space_ != NULL) {
+    uword address = large_object_space_->AllocateLarge(size);
+    if (address == 0) return Failure::retry_after_gc();
+    raw_result = HeapObject::FromAddress(address);
+  } else {
+    raw_result = Allocate(size);
+    if (raw_result->IsFailure()) return raw_result;
+  }
   Array* result = reinterpret_cast<Array*>(raw_result);
   result->set_class(the_class);
   result->Initialize(length, size, init_value);
@@ -221,12 +232,6 @@ Space* Heap::TakeSpace() {
   return result;
 }
 
-WeakPointer* Heap::TakeWeakPointers() {
-  WeakPointer* weak_pointers = weak_pointers_;
-  weak_pointers_ = NULL;
-  return weak_pointers;
-}
-
 void Heap::MergeInOtherHeap(Heap* heap) {
   Space* other_space = heap->TakeSpace();
   if (space_ == NULL) {
@@ -235,21 +240,24 @@ void Heap::MergeInOtherHeap(Heap* heap) {
     space_->PrependSpace(other_space);
   }
 
-  WeakPointer* other_weak_pointers = heap->TakeWeakPointers();
-  WeakPointer::PrependWeakPointers(&weak_pointers_, other_weak_pointers);
+  weak_pointers_.TakeFrom(&heap->weak_pointers_);
 }
 
 void Heap::AddWeakPointer(HeapObject* object,
                           WeakPointerCallback callback) {
-  weak_pointers_ = new WeakPointer(object, callback, weak_pointers_);
+  weak_pointers_.Add(object, callback);
 }
 
 void Heap::RemoveWeakPointer(HeapObject* object) {
-  WeakPointer::Remove(&weak_pointers_, object);
+  weak_pointers_.Remove(object);
+}
+
+void Heap::ProcessWeakPointers(Space* survivor_space) {
+  weak_pointers_.Process(space(), survivor_space);
 }
 
-void Heap::ProcessWeakPointers() {
-  WeakPointer::Process(space(), &weak_pointers_);
+void Heap::ProcessWeakPointers(SweepingVisitor* visitor) {
+  weak_pointers_.ProcessSwept(visitor);
 }
 
 }  // namespace fletch
@@ -31,7 +31,8 @@ class Heap {
   // Allocate heap object.
   Object* CreateInstance(Class* the_class, Object* init_value, bool immutable);
 
-  // Allocate array.
+  // Allocate array. Arrays of at least [kLargeObjectSize] bytes are
+  // allocated in the large object space, if the heap has one.
   Object* CreateArray(Class* the_class, int length, Object* init_value);
 
   // Allocate byte array.
@@ -89,9 +90,14 @@ class Heap {
 
   Space* space() { return space_; }
 
+  // Large objects are never copied. Each of them gets a chunk of its own
+  // in the large object space, which is owned by whoever set it.
+  static const int kLargeObjectSize = 64 * KB;
+  Space* large_object_space() { return large_object_space_; }
+  void set_large_object_space(Space* space) { large_object_space_ = space; }
+
   void ReplaceSpace(Space* space);
   Space* TakeSpace();
-  WeakPointer* TakeWeakPointers();
 
   void MergeInOtherHeap(Heap* heap);
 
@@ -107,9 +113,15 @@ class Heap {
 
   void AddWeakPointer(HeapObject* object, WeakPointerCallback callback);
   void RemoveWeakPointer(HeapObject* object);
-  void ProcessWeakPointers();
+  // Processes the weak pointers after the live objects have been moved
+  // out of the space of the heap. If [survivor_space] is given, only the
+  // young objects of a generational heap were moved, and the ones that
+  // survived are in [survivor_space] or in the old generation.
+  void ProcessWeakPointers(Space* survivor_space = NULL);
+  void ProcessWeakPointers(SweepingVisitor* visitor);
+  void UntenureWeakPointers() { weak_pointers_.Untenure(); }
   void VisitWeakObjectPointers(PointerVisitor* visitor) {
-    WeakPointer::Visit(weak_pointers_, visitor);
+    weak_pointers_.Visit(visitor);
   }
 
  private:
@@ -117,7 +129,7 @@ class Heap {
   friend class ImmutableHeap;
   friend class Scheduler;
 
-  Heap(Space* existing_space, WeakPointer* weak_pointers);
+  explicit Heap(Space* existing_space);
 
   Object* CreateStringInternal(Class* the_class, int length, bool clear);
 
@@ -130,8 +142,9 @@ class Heap {
   // Used for initializing identity hash codes for immutable objects.
   RandomLCG* random_;
   Space* space_;
-  // Linked list of weak pointers to heap objects in this heap.
-  WeakPointer* weak_pointers_;
+  Space* large_object_space_;
+  // Weak pointers to heap objects in this heap.
+  WeakPointerTable weak_pointers_;
 };
 
 // Helper class for copying HeapObjects.
@@ -158,6 +171,42 @@ class ScavengeVisitor: public PointerVisitor {
   Space* to_;
 };
 
+// Helper class for scavenging the young generation. Objects in the nursery
+// are copied to the new survivor space, and objects that have already
+// survived a scavenge are promoted to the old space.
+class GenerationalScavengeVisitor: public PointerVisitor {
+ public:
+  GenerationalScavengeVisitor(Space* nursery,
+                              Space* survivors,
+                              Space* to,
+                              Space* old_space)
+      : nursery_(nursery),
+        survivors_(survivors),
+        to_(to),
+        old_space_(old_space) { }
+
+  void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) ScavengePointer(p);
+  }
+
+ private:
+  void ScavengePointer(Object** p) {
+    Object* object = *p;
+    if (!object->IsHeapObject()) return;
+    uword address = reinterpret_cast<uword>(object);
+    if (nursery_->Includes(address)) {
+      *p = reinterpret_cast<HeapObject*>(object)->CloneInToSpace(to_);
+    } else if (survivors_->Includes(address)) {
+      *p = reinterpret_cast<HeapObject*>(object)->CloneInToSpace(old_space_);
+    }
+  }
+
+  Space* nursery_;
+  Space* survivors_;
+  Space* to_;
+  Space* old_space_;
+};
+
 // Extract a raw void* pointer from [object].
 //
 // [object] must be either a Smi or a LargeInteger.
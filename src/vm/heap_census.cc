@@ -0,0 +1,290 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/heap_census.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+
+#include "src/shared/utils.h"
+#include "src/vm/object_memory.h"
+#include "src/vm/process.h"
+#include "src/vm/program.h"
+
+namespace fletch {
+
+// The reachable objects of a census as a graph in compressed form: the
+// successors of node i are edges_[edge_start_[i]] up to
+// edges_[edge_start_[i + 1]]. Node 0 stands for the roots, the other nodes
+// are numbered in the order the objects are found.
+class CensusGraph : public PointerVisitor {
+ public:
+  explicit CensusGraph(HeapCensus* census) : census_(census) { }
+
+  void Build() {
+    objects_.push_back(NULL);
+    for (size_t i = 0; i < objects_.size(); i++) {
+      edge_start_.push_back(edges_.size());
+      if (i == 0) {
+        for (size_t j = 0; j < census_->processes_.size(); j++) {
+          census_->processes_[j]->IterateRoots(this);
+        }
+        for (size_t j = 0; j < census_->roots_.size(); j++) {
+          Visit(reinterpret_cast<Object**>(&census_->roots_[j]));
+        }
+      } else {
+        objects_[i]->IteratePointers(this);
+      }
+    }
+    edge_start_.push_back(edges_.size());
+  }
+
+  void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) {
+      Object* object = *p;
+      if (!object->IsHeapObject()) continue;
+      HeapObject* heap_object = HeapObject::cast(object);
+      if (!census_->IsCounted(heap_object)) continue;
+      edges_.push_back(NodeFor(heap_object));
+    }
+  }
+
+  // Classes are never counted.
+  void VisitClass(Object** p) { }
+
+  int length() const { return objects_.size(); }
+  HeapObject* object(int node) const { return objects_[node]; }
+  int first_edge(int node) const { return edge_start_[node]; }
+  int last_edge(int node) const { return edge_start_[node + 1]; }
+  int edge(int i) const { return edges_[i]; }
+
+ private:
+  int NodeFor(HeapObject* object) {
+    HashMap<HeapObject*, int>::ConstIterator it = nodes_.Find(object);
+    if (it != nodes_.End()) return it->second;
+    int node = objects_.size();
+    nodes_[object] = node;
+    objects_.push_back(object);
+    return node;
+  }
+
+  HeapCensus* const census_;
+  HashMap<HeapObject*, int> nodes_;
+  std::vector<HeapObject*> objects_;
+  std::vector<int> edge_start_;
+  std::vector<int> edges_;
+};
+
+// Finds the nearest common dominator of two nodes, given by their postorder
+// numbers. Dominators always have higher numbers than the nodes they
+// dominate.
+static int Intersect(const std::vector<int>& dominators, int a, int b) {
+  while (a != b) {
+    while (a < b) a = dominators[a];
+    while (b < a) b = dominators[b];
+  }
+  return a;
+}
+
+HeapCensus::HeapCensus() { }
+
+void HeapCensus::AddProcess(Process* process) {
+  processes_.push_back(process);
+  process->IterateHeapObjects(this);
+}
+
+void HeapCensus::AddSpace(Space* space) {
+  spaces_.push_back(space);
+  space->IterateObjects(this);
+}
+
+void HeapCensus::AddRoot(HeapObject* object) {
+  roots_.push_back(object);
+}
+
+void HeapCensus::Visit(HeapObject* object) {
+  Entry* entry = EntryFor(object->get_class());
+  entry->count++;
+  entry->bytes += object->Size();
+}
+
+// The dominators are computed with the iterative algorithm of Cooper,
+// Harvey and Kennedy, which is simple and fast enough for graphs of this
+// shape.
+void HeapCensus::ComputeRetainedSizes() {
+  CensusGraph graph(this);
+  graph.Build();
+  int length = graph.length();
+
+  // Number the nodes in postorder. The root ends up last.
+  std::vector<int> postorder(length, -1);
+  std::vector<int> order;
+  std::vector<int> next_edge(length, 0);
+  std::vector<int> stack;
+  // Nodes that have been found but not finished are marked with [length].
+  stack.push_back(0);
+  postorder[0] = length;
+  next_edge[0] = graph.first_edge(0);
+  while (!stack.empty()) {
+    int node = stack.back();
+    if (next_edge[node] < graph.last_edge(node)) {
+      int successor = graph.edge(next_edge[node]++);
+      if (postorder[successor] == -1) {
+        postorder[successor] = length;
+        next_edge[successor] = graph.first_edge(successor);
+        stack.push_back(successor);
+      }
+    } else {
+      stack.pop_back();
+      postorder[node] = order.size();
+      order.push_back(node);
+    }
+  }
+  ASSERT(static_cast<int>(order.size()) == length);
+
+  // Collect the predecessors of every node.
+  std::vector<int> predecessor_start(length + 1, 0);
+  for (int node = 0; node < length; node++) {
+    for (int i = graph.first_edge(node); i < graph.last_edge(node); i++) {
+      predecessor_start[graph.edge(i) + 1]++;
+    }
+  }
+  for (int node = 0; node < length; node++) {
+    predecessor_start[node + 1] += predecessor_start[node];
+  }
+  std::vector<int> predecessors(predecessor_start[length]);
+  std::vector<int> filled(predecessor_start.begin(),
+                          predecessor_start.end() - 1);
+  for (int node = 0; node < length; node++) {
+    for (int i = graph.first_edge(node); i < graph.last_edge(node); i++) {
+      predecessors[filled[graph.edge(i)]++] = node;
+    }
+  }
+
+  // Compute the immediate dominators, indexed by postorder number.
+  int root = length - 1;
+  std::vector<int> dominators(length, -1);
+  dominators[root] = root;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int number = root - 1; number >= 0; number--) {
+      int node = order[number];
+      int dominator = -1;
+      for (int i = predecessor_start[node];
+           i < predecessor_start[node + 1];
+           i++) {
+        int predecessor = postorder[predecessors[i]];
+        if (dominators[predecessor] == -1) continue;
+        dominator = (dominator == -1)
+            ? predecessor
+            : Intersect(dominators, predecessor, dominator);
+      }
+      if (dominators[number] != dominator) {
+        dominators[number] = dominator;
+        changed = true;
+      }
+    }
+  }
+
+  // Every node is numbered before its dominator, so a single pass adds up
+  // the retained sizes.
+  std::vector<int64> retained(length, 0);
+  for (int number = 0; number < root; number++) {
+    HeapObject* object = graph.object(order[number]);
+    retained[number] += object->Size();
+    retained[dominators[number]] += retained[number];
+
+    Class* klass = object->get_class();
+    int dominator = dominators[number];
+    if (dominator == root ||
+        graph.object(order[dominator])->get_class() != klass) {
+      EntryFor(klass)->retained += retained[number];
+    }
+  }
+}
+
+static bool CompareBytes(const HeapCensus::Entry& a,
+                         const HeapCensus::Entry& b) {
+  return a.bytes > b.bytes;
+}
+
+std::vector<HeapCensus::Entry>* HeapCensus::SortedEntries() {
+  std::sort(entries_.begin(), entries_.end(), CompareBytes);
+  // The same classes are still in the index, so just update it.
+  for (size_t i = 0; i < entries_.size(); i++) {
+    index_[entries_[i].klass] = i;
+  }
+  return &entries_;
+}
+
+static void PrintLine(FILE* file, const char* line) {
+  if (file != NULL) {
+    fprintf(file, "%s\n", line);
+  } else {
+    Print::Out("%s\n", line);
+  }
+}
+
+bool HeapCensus::PrintJson(Program* program, const char* path) {
+  FILE* file = NULL;
+  if (path != NULL) {
+    file = fopen(path, "w");
+    if (file == NULL) return false;
+  }
+
+  HashMap<Class*, int> class_indices;
+  Array* classes = program->classes();
+  if (classes != NULL) {
+    for (int i = 0; i < classes->length(); i++) {
+      class_indices[Class::cast(classes->get(i))] = i;
+    }
+  }
+
+  std::vector<Entry>* entries = SortedEntries();
+  int length = entries->size();
+  PrintLine(file, "[");
+  for (int i = 0; i < length; i++) {
+    Entry* entry = &(*entries)[i];
+    HashMap<Class*, int>::ConstIterator it = class_indices.Find(entry->klass);
+    int index = (it == class_indices.End()) ? -1 : it->second;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "  {\"class\": %d, \"instances\": %d, \"bytes\": %lld, "
+             "\"retained\": %lld}%s",
+             index,
+             entry->count,
+             static_cast<long long>(entry->bytes),  // NOLINT
+             static_cast<long long>(entry->retained),  // NOLINT
+             (i == length - 1) ? "" : ",");
+    PrintLine(file, line);
+  }
+  PrintLine(file, "]");
+
+  if (file != NULL) fclose(file);
+  return true;
+}
+
+HeapCensus::Entry* HeapCensus::EntryFor(Class* klass) {
+  HashMap<Class*, int>::ConstIterator it = index_.Find(klass);
+  if (it != index_.End()) return &entries_[it->second];
+  index_[klass] = entries_.size();
+  Entry entry = { klass, 0, 0, 0 };
+  entries_.push_back(entry);
+  return &entries_.back();
+}
+
+bool HeapCensus::IsCounted(HeapObject* object) {
+  uword address = object->address();
+  for (size_t i = 0; i < processes_.size(); i++) {
+    if (processes_[i]->HeapIncludes(address)) return true;
+  }
+  for (size_t i = 0; i < spaces_.size(); i++) {
+    if (spaces_[i]->Includes(address)) return true;
+  }
+  return false;
+}
+
+}  // namespace fletch
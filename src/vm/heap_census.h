@@ -0,0 +1,83 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_HEAP_CENSUS_H_
+#define SRC_VM_HEAP_CENSUS_H_
+
+#include <vector>
+
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+#include "src/vm/object.h"
+
+namespace fletch {
+
+class Process;
+class Program;
+class Space;
+
+// Counts the objects in a set of heaps by class. The shallow census walks
+// the spaces, so it includes the objects that are dead but have not been
+// collected yet. Retained sizes are optional, since they take a walk of
+// everything reachable from the roots of the processes: the retained size
+// of an object is the size of everything that would die with it, computed
+// from the dominator tree of the reachable objects.
+//
+// All the heaps must be left alone while the census is taken.
+class HeapCensus : public HeapObjectVisitor {
+ public:
+  struct Entry {
+    Class* klass;
+    int count;
+    int64 bytes;
+    int64 retained;
+  };
+
+  HeapCensus();
+
+  // Counts the objects in the heaps of [process]. Its roots are roots of
+  // the retained size computation.
+  void AddProcess(Process* process);
+
+  // Counts the objects in [space]. Processes never point into each other's
+  // heaps, so this is for the spaces they share, like the immutable heap.
+  void AddSpace(Space* space);
+
+  // Makes [object] a root of the retained size computation.
+  void AddRoot(HeapObject* object);
+
+  // Computes the retained sizes of the objects in the added heaps that are
+  // reachable from the roots. An instance that is
+  // dominated by an instance of the same class is part of the retained size
+  // of that instance, so it does not add to the retained size of the class
+  // again.
+  void ComputeRetainedSizes();
+
+  void Visit(HeapObject* object);
+
+  // The entries, largest shallow size first.
+  std::vector<Entry>* SortedEntries();
+
+  // Prints the census as a JSON array to the file at [path], or to stdout
+  // if [path] is NULL. Classes are named by their index in the classes of
+  // [program], or -1 if they are not there. Returns false if the file could
+  // not be written.
+  bool PrintJson(Program* program, const char* path);
+
+ private:
+  friend class CensusGraph;
+
+  Entry* EntryFor(Class* klass);
+  bool IsCounted(HeapObject* object);
+
+  std::vector<Entry> entries_;
+  HashMap<Class*, int> index_;
+  std::vector<Process*> processes_;
+  std::vector<Space*> spaces_;
+  std::vector<HeapObject*> roots_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_HEAP_CENSUS_H_
@@ -0,0 +1,79 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/random.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/heap.h"
+#include "src/vm/heap_census.h"
+#include "src/vm/object_memory.h"
+
+namespace fletch {
+
+static Array* NewArray(Heap* heap, Class* array_class, int length) {
+  return Array::cast(heap->CreateArray(array_class, length, Smi::zero()));
+}
+
+static HeapCensus::Entry* FindEntry(std::vector<HeapCensus::Entry>* entries,
+                                    Class* klass) {
+  for (size_t i = 0; i < entries->size(); i++) {
+    if ((*entries)[i].klass == klass) return &(*entries)[i];
+  }
+  return NULL;
+}
+
+TEST_CASE(HeapCensus) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* x_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+  Class* y_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+
+  // The root points to a and b, which both point to c, which points to d.
+  // The last object is garbage.
+  Heap heap(&random);
+  Array* root = NewArray(&heap, x_class, 2);
+  Array* a = NewArray(&heap, y_class, 1);
+  Array* b = NewArray(&heap, y_class, 1);
+  Array* c = NewArray(&heap, y_class, 1);
+  Array* d = NewArray(&heap, x_class, 0);
+  NewArray(&heap, y_class, 0);
+  root->set(0, a);
+  root->set(1, b);
+  a->set(0, c);
+  b->set(0, c);
+  c->set(0, d);
+
+  int root_size = root->Size();
+  int small_size = a->Size();
+  int empty_size = d->Size();
+
+  HeapCensus census;
+  census.AddSpace(heap.space());
+  census.AddRoot(root);
+  census.ComputeRetainedSizes();
+
+  std::vector<HeapCensus::Entry>* entries = census.SortedEntries();
+  EXPECT_EQ(static_cast<int>(entries->size()), 2);
+  EXPECT((*entries)[0].bytes >= (*entries)[1].bytes);
+
+  HeapCensus::Entry* x = FindEntry(entries, x_class);
+  EXPECT_EQ(x->count, 2);
+  EXPECT_EQ(x->bytes, static_cast<int64>(root_size + empty_size));
+  HeapCensus::Entry* y = FindEntry(entries, y_class);
+  EXPECT_EQ(y->count, 4);
+  EXPECT_EQ(y->bytes, static_cast<int64>(3 * small_size + empty_size));
+
+  // Neither a nor b dominates c, so the root retains everything that is
+  // reachable. The retained sizes of different classes overlap: d is
+  // retained by c as well as counted for its own class.
+  int reachable = root_size + 3 * small_size + empty_size;
+  EXPECT_EQ(x->retained, static_cast<int64>(reachable + empty_size));
+  EXPECT_EQ(y->retained, static_cast<int64>(3 * small_size + empty_size));
+}
+
+}  // namespace fletch
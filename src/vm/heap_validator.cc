@@ -4,6 +4,8 @@
 
 #include "src/vm/heap_validator.h"
 
+#include "src/vm/process.h"
+
 namespace fletch {
 
 void HeapPointerValidator::VisitBlock(Object** start, Object** end) {
@@ -24,8 +26,8 @@ void HeapPointerValidator::ValidatePointer(Object* object) {
         immutable_heap_->heap()->space()->Includes(address);
   }
   bool is_mutable_heap_obj = false;
-  if (mutable_heap_ != NULL) {
-    is_mutable_heap_obj = mutable_heap_->space()->Includes(address);
+  if (process_ != NULL) {
+    is_mutable_heap_obj = process_->HeapIncludes(address);
   }
 
   bool is_program_heap = program_heap_->space()->Includes(address);
@@ -49,21 +51,53 @@ void HeapPointerValidator::ValidatePointer(Object* object) {
   }
 }
 
+void RememberedSetValidator::VisitBlock(Object** start, Object** end) {
+  for (Object** p = start; p < end; p++) {
+    if (!NeedsRemembering(p)) continue;
+    uword slot = reinterpret_cast<uword>(p);
+    if (!ObjectMemory::ChunkFor(slot)->IsCardDirty(slot)) {
+      fprintf(stderr,
+              "Found slot %p with pointer %p which is not in a dirty card.\n",
+              p, *p);
+      FATAL("Heap validation failed.");
+    }
+  }
+}
+
+bool RememberedSetValidator::NeedsRemembering(Object** slot) {
+  Object* object = *slot;
+  if (!object->IsHeapObject()) return false;
+  HeapObject* heap_object = HeapObject::cast(object);
+  uword address = heap_object->address();
+  if (program_heap_->space()->Includes(address)) return false;
+  if (!process_->HeapIncludes(address)) return true;
+  uword slot_address = reinterpret_cast<uword>(slot);
+  bool slot_is_old = process_->old_space()->Includes(slot_address) ||
+      process_->large_space()->Includes(slot_address);
+  return slot_is_old && process_->IsYoung(heap_object);
+}
+
 void ProcessHeapValidatorVisitor::VisitProcess(Process* process) {
   Heap* process_heap = process->heap();
 
   // Validate pointers in roots, queues, weak pointers and mutable heap.
   {
-    HeapPointerValidator validator(
-        program_heap_, immutable_heap_, process_heap);
+    HeapPointerValidator validator(program_heap_, immutable_heap_, process);
 
     SafeObjectPointerVisitor pointer_visitor(process, &validator);
     process->IterateRoots(&validator);
-    process_heap->IterateObjects(&pointer_visitor);
+    process->IterateHeapObjects(&pointer_visitor);
     process_heap->VisitWeakObjectPointers(&validator);
-    process->store_buffer()->IterateObjects(&pointer_visitor);
     process->IteratePortQueuesPointers(&validator);
   }
+
+  // Validate that the pointers that need to be remembered are in dirty
+  // cards.
+  {
+    RememberedSetValidator validator(program_heap_, process);
+    SafeObjectPointerVisitor pointer_visitor(process, &validator);
+    process->IterateHeapObjects(&pointer_visitor);
+  }
 }
 
 }  // namespace fletch
@@ -12,15 +12,15 @@
 namespace fletch {
 
 // Validates that all pointers it gets called with lie inside certain spaces -
-// depending on [immutable_heap], [mutable_heap], [program_heap].
+// depending on [immutable_heap], the heap of [process], [program_heap].
 class HeapPointerValidator: public PointerVisitor {
  public:
   HeapPointerValidator(Heap* program_heap,
                        ImmutableHeap* immutable_heap,
-                       Heap* mutable_heap)
+                       Process* process)
       : program_heap_(program_heap),
         immutable_heap_(immutable_heap),
-        mutable_heap_(mutable_heap) {}
+        process_(process) {}
   virtual ~HeapPointerValidator() {}
 
   virtual void VisitBlock(Object** start, Object** end);
@@ -30,7 +30,7 @@ class HeapPointerValidator: public PointerVisitor {
 
   Heap* program_heap_;
   ImmutableHeap* immutable_heap_;
-  Heap* mutable_heap_;
+  Process* process_;
 };
 
 // Validates that all pointers it gets called with lie inside program/immutable
@@ -51,6 +51,25 @@ class ProgramHeapPointerValidator: public HeapPointerValidator {
   virtual ~ProgramHeapPointerValidator() {}
 };
 
+// Validates that all the slots it gets called with are in dirty cards if
+// they need to be remembered: slots with pointers to the immutable heap,
+// and slots in the old generation of [process] with pointers to its young
+// generation.
+class RememberedSetValidator: public PointerVisitor {
+ public:
+  RememberedSetValidator(Heap* program_heap, Process* process)
+      : program_heap_(program_heap), process_(process) {}
+  virtual ~RememberedSetValidator() {}
+
+  virtual void VisitBlock(Object** start, Object** end);
+
+ private:
+  bool NeedsRemembering(Object** slot);
+
+  Heap* program_heap_;
+  Process* process_;
+};
+
 // Traverses roots, queues, heaps of a process and makes sure the pointers
 // inside them are valid.
 class ProcessHeapValidatorVisitor : public ProcessVisitor {
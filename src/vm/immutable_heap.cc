@@ -3,6 +3,8 @@
 // BSD-style license that can be found in the LICENSE.md file.
 
 #include "src/vm/immutable_heap.h"
+
+#include "src/shared/flags.h"
 #include "src/vm/object_memory.h"
 
 namespace fletch {
@@ -10,11 +12,13 @@ namespace fletch {
 ImmutableHeap::ImmutableHeap()
     : number_of_hw_threads_(Platform::GetNumberOfHardwareThreads()),
       heap_mutex_(Platform::CreateMutex()),
-      heap_(new Space(), reinterpret_cast<WeakPointer*>(NULL)),
+      heap_(new Space()),
       outstanding_parts_(0),
       unmerged_parts_(NULL),
       immutable_allocation_limit_(0),
-      consumed_memory_(0) {
+      consumed_memory_(0),
+      size_limit_(Flags::immutable_heap_limit),
+      live_size_(0) {
   UpdateLimitAfterImmutableGC(0);
 }
 
@@ -53,19 +57,19 @@ void ImmutableHeap::UpdateLimitAfterImmutableGC(int mutable_size_at_last_gc) {
   if (merged_space != NULL && !merged_space->is_empty()) {
     limit = Utils::Maximum(limit, merged_space->Used());
   }
+  live_size_ = merged_space != NULL ? merged_space->Used() : 0;
 
   // We introduce a constraint here to allow the size of mutable heaps to guide
   // how large the immutable heap can be. Since the amount of computation for
   // an immutable GC depends on the "root set", which is in turn influenced by
   // the size of mutable heaps. Ignoring this factor can cause a lot of
-  // unnecessary immutable GCs and therefore also unnecessary storebuffer
-  // compactions.
+  // unnecessary immutable GCs and therefore also unnecessary scans of the
+  // dirty cards of the mutable heaps.
   //
-  // TODO(kustermann): Once we have de-duplication of storebuffer entries, we
+  // TODO(kustermann): Now that the remembered set is a set of dirty cards, we
   //   * might want to reduce this division factor
   //   * might want to use a different metric than the mutable heap size
-  //     (preferable the number of pointers to immutable space - the size of the
-  //      root set).
+  //     (preferable the number of dirty cards - the size of the root set).
   immutable_allocation_limit_ =
       Utils::Maximum(limit, mutable_size_at_last_gc / 2);
 }
@@ -103,6 +107,14 @@ ImmutableHeap::Part* ImmutableHeap::AcquirePart() {
     part = new Part(NULL, budget);
   }
 
+  Space* space = part->heap()->space();
+  if (size_limit_ == 0) {
+    space->SetAllocationLimit(Space::kNoAllocationLimit);
+  } else {
+    int room = size_limit_ - live_size_ - consumed_memory_;
+    space->SetAllocationLimit(space->Used() + Utils::Maximum(room, 0));
+  }
+
   outstanding_parts_++;
   return part;
 }
@@ -120,6 +132,8 @@ bool ImmutableHeap::ReleasePart(Part* part) {
   ASSERT(diff >= 0);
   int new_consumed_memory = consumed_memory_ + diff;
   bool gc = consumed_memory_ < limit && limit < new_consumed_memory;
+  // Only a collection can make room under the size limit.
+  if (part->heap()->space()->limit_request() != 0) gc = true;
 
   consumed_memory_ += diff;
   return gc;
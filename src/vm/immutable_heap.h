@@ -49,6 +49,13 @@ class ImmutableHeap {
   // It is assumed that this function is only called on allocation failures.
   bool ReleasePart(Part* part);
 
+  // Tells whether an allocation of [size] bytes would take the immutable
+  // heap past [Flags::immutable_heap_limit], even if only the objects that
+  // survived the last immutable GC were left.
+  bool ExceedsLimit(int size) {
+    return size_limit_ != 0 && live_size_ + size > size_limit_;
+  }
+
   // Merges all parts which have been acquired and subsequently released into
   // the accumulated immutable heap.
   //
@@ -90,6 +97,14 @@ class ImmutableHeap {
 
   // The amount of memory consumed by outstanding parts/unmerged parts.
   int consumed_memory_;
+
+  // The limit of the size of the immutable heap, or 0 for no limit. Each
+  // part is limited to the room that was left when it was acquired, so
+  // parts used at the same time can together go a little past it.
+  int size_limit_;
+
+  // The size of the immutable heap after the last immutable GC.
+  int live_size_;
 };
 
 }  // namespace fletch
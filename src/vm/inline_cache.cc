@@ -0,0 +1,50 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/inline_cache.h"
+
+#include "src/vm/object.h"
+
+namespace fletch {
+
+Atomic<int> InlineCache::generation_ = 0;
+
+InlineCache::InlineCache()
+    : entries_(new Entry[kSize]),
+      hits_(0),
+      misses_(0),
+      validated_generation_(generation_) {
+  Clear();
+}
+
+InlineCache::~InlineCache() {
+  delete[] entries_;
+}
+
+InlineCache::Entry* InlineCache::Insert(uint8* bcp,
+                                        Class* clazz,
+                                        Function* target,
+                                        word tag) {
+  Entry* set = &entries_[ComputeSetIndex(bcp) * kWays];
+  memmove(set + 1, set, sizeof(Entry) * (kWays - 1));
+  set->bcp = bcp;
+  set->clazz = clazz;
+  set->target = target;
+  set->tag = tag;
+  return set;
+}
+
+void InlineCache::Invalidate(Class* clazz) {
+  for (int i = 0; i < kSize; i++) {
+    Entry* entry = &entries_[i];
+    if (entry->clazz == NULL || !entry->clazz->IsSubclassOf(clazz)) continue;
+    memset(entry, 0, sizeof(Entry));
+  }
+}
+
+void InlineCache::Clear() {
+  memset(entries_, 0, sizeof(Entry) * kSize);
+}
+
+}  // namespace fletch
@@ -0,0 +1,108 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_INLINE_CACHE_H_
+#define SRC_VM_INLINE_CACHE_H_
+
+#include "src/shared/atomic.h"
+#include "src/shared/globals.h"
+#include "src/shared/utils.h"
+
+namespace fletch {
+
+class Class;
+class Function;
+
+// Inline caches for the method invokes of unfolded programs. Each invoke
+// bytecode gets a set of up to [kWays] entries, keyed by the address of
+// the bytecode, which remember the targets for the receiver classes seen
+// at that call site, most recent first. The entries live in a per-thread
+// side table, so filling them needs no locking. Misses are looked up
+// through the LookupCache. Only the C++ interpreter probes the inline
+// caches; the generated x86 and ARM interpreters still go straight to
+// the LookupCache.
+//
+// Entries refer to bytecodes, classes and methods by address, so all of
+// them are dropped when a program heap is collected: each thread clears
+// its inline caches the next time it starts interpreting. Changing the
+// method table or the superclass of a class only drops the entries for
+// that class and its subclasses.
+class InlineCache {
+ public:
+  static const int kWays = 4;
+  static const int kSets = 1024;
+  static const int kSize = kSets * kWays;
+
+  struct Entry {
+    uint8* bcp;
+    Class* clazz;
+    Function* target;
+    word tag;
+  };
+
+  InlineCache();
+  ~InlineCache();
+
+  Entry* entries() const { return entries_; }
+
+  // Returns the entry for [clazz] at the invoke at [bcp] or NULL.
+  inline Entry* Lookup(uint8* bcp, Class* clazz);
+
+  // Adds an entry for [clazz] at the invoke at [bcp]. The least recently
+  // added entry of the set is dropped if the set is full.
+  Entry* Insert(uint8* bcp, Class* clazz, Function* target, word tag);
+
+  // Drops the entries for [clazz] and its subclasses.
+  void Invalidate(Class* clazz);
+
+  void Clear();
+
+  // Clears the entries if FlushAll has been called since the last time.
+  inline void Validate();
+
+  // Makes all inline caches drop their entries before they are used
+  // again.
+  static void FlushAll() { generation_++; }
+
+  // Counters for tuning, printed by -Xprint-inline-cache-statistics.
+  uword hits() const { return hits_; }
+  uword misses() const { return misses_; }
+  void IncrementHits() { hits_++; }
+  void IncrementMisses() { misses_++; }
+
+  static inline uword ComputeSetIndex(uint8* bcp);
+
+ private:
+  Entry* const entries_;
+  uword hits_;
+  uword misses_;
+  int validated_generation_;
+
+  static Atomic<int> generation_;
+};
+
+InlineCache::Entry* InlineCache::Lookup(uint8* bcp, Class* clazz) {
+  Entry* entry = &entries_[ComputeSetIndex(bcp) * kWays];
+  for (int i = 0; i < kWays; i++, entry++) {
+    if (entry->bcp == bcp && entry->clazz == clazz) return entry;
+  }
+  return NULL;
+}
+
+void InlineCache::Validate() {
+  int generation = generation_;
+  if (generation == validated_generation_) return;
+  Clear();
+  validated_generation_ = generation;
+}
+
+uword InlineCache::ComputeSetIndex(uint8* bcp) {
+  ASSERT(Utils::IsPowerOfTwo(kSets));
+  uword hash = reinterpret_cast<uword>(bcp);
+  return (hash ^ (hash >> 3)) & (kSets - 1);
+}
+
+}  // namespace fletch
+
+#endif  // SRC_VM_INLINE_CACHE_H_
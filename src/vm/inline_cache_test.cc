@@ -0,0 +1,180 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/inline_cache.h"
+#include "src/vm/object.h"
+#include "src/vm/program.h"
+
+namespace fletch {
+
+// The cache never looks at the targets, so any address will do.
+static Function* FakeTarget(int index) {
+  return reinterpret_cast<Function*>((index + 1) * kPointerSize);
+}
+
+// Returns a bytecode pointer into [bytecodes] that maps to another set
+// than [bcp].
+static uint8* InAnotherSet(uint8* bytecodes, int length, uint8* bcp) {
+  for (int i = 0; i < length; i++) {
+    uint8* other = bytecodes + i;
+    if (InlineCache::ComputeSetIndex(other) !=
+        InlineCache::ComputeSetIndex(bcp)) {
+      return other;
+    }
+  }
+  UNREACHABLE();
+  return NULL;
+}
+
+TEST_CASE(InlineCacheLookup) {
+  Program* program = new Program();
+  program->Initialize();
+  Class* smi = program->smi_class();
+  Class* num = program->num_class();
+
+  uint8 bytecodes[16];
+  uint8* bcp = bytecodes;
+  uint8* other = InAnotherSet(bytecodes, 16, bcp);
+
+  InlineCache cache;
+  EXPECT(cache.Lookup(bcp, smi) == NULL);
+
+  InlineCache::Entry* entry = cache.Insert(bcp, smi, FakeTarget(0), 42);
+  EXPECT(cache.Lookup(bcp, smi) == entry);
+  EXPECT(entry->target == FakeTarget(0));
+  EXPECT_EQ(entry->tag, 42);
+
+  // Entries are keyed by both the call site and the receiver class.
+  EXPECT(cache.Lookup(bcp, num) == NULL);
+  EXPECT(cache.Lookup(other, smi) == NULL);
+
+  cache.Clear();
+  EXPECT(cache.Lookup(bcp, smi) == NULL);
+
+  delete program;
+}
+
+TEST_CASE(InlineCacheReplacement) {
+  Program* program = new Program();
+  program->Initialize();
+  Class* classes[] = {
+    program->smi_class(),
+    program->int_class(),
+    program->num_class(),
+    program->double_class(),
+    program->bool_class(),
+  };
+  int ways = InlineCache::kWays;
+  ASSERT(ARRAY_SIZE(classes) == ways + 1);
+
+  uint8 bytecodes[16];
+  uint8* bcp = bytecodes;
+  uint8* other = InAnotherSet(bytecodes, 16, bcp);
+
+  InlineCache cache;
+  InlineCache::Entry* set =
+      &cache.entries()[InlineCache::ComputeSetIndex(bcp) * ways];
+  cache.Insert(other, classes[0], FakeTarget(0), 0);
+  for (int i = 0; i < ways; i++) {
+    // The most recent entry is the first of the set.
+    EXPECT(cache.Insert(bcp, classes[i], FakeTarget(i), i) == set);
+  }
+  for (int i = 0; i < ways; i++) {
+    InlineCache::Entry* entry = cache.Lookup(bcp, classes[i]);
+    EXPECT(entry != NULL);
+    EXPECT(entry->target == FakeTarget(i));
+    EXPECT_EQ(entry->tag, i);
+  }
+
+  // A full set drops its least recently added entry.
+  cache.Insert(bcp, classes[ways], FakeTarget(ways), ways);
+  EXPECT(cache.Lookup(bcp, classes[0]) == NULL);
+  for (int i = 1; i <= ways; i++) {
+    EXPECT(cache.Lookup(bcp, classes[i]) != NULL);
+  }
+
+  // Other sets are not affected.
+  EXPECT(cache.Lookup(other, classes[0]) != NULL);
+
+  delete program;
+}
+
+TEST_CASE(InlineCacheInvalidate) {
+  Program* program = new Program();
+  program->Initialize();
+  Class* smi = program->smi_class();
+  Class* num = program->num_class();
+  Class* double_class = program->double_class();
+  Class* bool_class = program->bool_class();
+
+  uint8 bytecodes[16];
+  uint8* bcp = bytecodes;
+  uint8* other = InAnotherSet(bytecodes, 16, bcp);
+
+  InlineCache cache;
+  cache.Insert(bcp, smi, FakeTarget(0), 0);
+  cache.Insert(bcp, num, FakeTarget(1), 0);
+  cache.Insert(bcp, bool_class, FakeTarget(2), 0);
+  cache.Insert(other, double_class, FakeTarget(3), 0);
+
+  // Smi and double are subclasses of num, bool is not.
+  cache.Invalidate(num);
+  EXPECT(cache.Lookup(bcp, smi) == NULL);
+  EXPECT(cache.Lookup(bcp, num) == NULL);
+  EXPECT(cache.Lookup(other, double_class) == NULL);
+  EXPECT(cache.Lookup(bcp, bool_class) != NULL);
+
+  // Invalidating a leaf class keeps the entries for its superclasses.
+  cache.Insert(bcp, num, FakeTarget(1), 0);
+  cache.Insert(bcp, smi, FakeTarget(0), 0);
+  cache.Invalidate(smi);
+  EXPECT(cache.Lookup(bcp, smi) == NULL);
+  EXPECT(cache.Lookup(bcp, num) != NULL);
+
+  delete program;
+}
+
+TEST_CASE(InlineCacheFlushAll) {
+  Program* program = new Program();
+  program->Initialize();
+  Class* smi = program->smi_class();
+
+  uint8 bytecodes[16];
+  uint8* bcp = bytecodes;
+
+  InlineCache first;
+  InlineCache second;
+  first.Insert(bcp, smi, FakeTarget(0), 0);
+  second.Insert(bcp, smi, FakeTarget(0), 0);
+
+  // Validating without a flush keeps the entries.
+  first.Validate();
+  EXPECT(first.Lookup(bcp, smi) != NULL);
+
+  // Every cache drops its entries the next time it is validated, but
+  // only once per flush.
+  InlineCache::FlushAll();
+  EXPECT(first.Lookup(bcp, smi) != NULL);
+  first.Validate();
+  second.Validate();
+  EXPECT(first.Lookup(bcp, smi) == NULL);
+  EXPECT(second.Lookup(bcp, smi) == NULL);
+
+  first.Insert(bcp, smi, FakeTarget(0), 0);
+  first.Validate();
+  EXPECT(first.Lookup(bcp, smi) != NULL);
+
+  // Caches created after a flush start out validated.
+  InlineCache third;
+  third.Insert(bcp, smi, FakeTarget(0), 0);
+  third.Validate();
+  EXPECT(third.Lookup(bcp, smi) != NULL);
+
+  delete program;
+}
+
+}  // namespace fletch
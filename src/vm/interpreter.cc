@@ -26,6 +26,11 @@
       /* Signal the scheduler that we need an immutable heap GC. */      \
       return Interpreter::kImmutableAllocationFailure;                   \
     }                                                                    \
+    if (process()->TakeOutOfMemory()) {                                  \
+      SaveState();                                                       \
+      Object* exception = program()->raw_out_of_memory();                \
+      if (!DoThrow(exception)) return Interpreter::kUncaughtException;   \
+    }                                                                    \
     /* Re-try interpreting the bytecode by re-dispatching. */            \
     DISPATCH();                                                          \
   }                                                                      \
@@ -149,7 +154,8 @@ class Engine : public State {
   bool DoThrow(Object* exception);
 
   // Returns `true` if the interpretation should stop and we should signal to
-  // the scheduler that immutable garbage should be collected.
+  // the scheduler that immutable garbage should be collected. If the
+  // process is out of memory, [Process::TakeOutOfMemory] tells so.
   bool CollectGarbageIfNecessary();
   void CollectMutableGarbage();
 
@@ -193,6 +199,12 @@ class Engine : public State {
 #define OPCODE_END() }                                    \
   DISPATCH()
 
+// Fused bytecodes go straight to the bytecode they were fused with, but
+// still stop there for breakpoints.
+#define OPCODE_END_FUSED(next) }                          \
+  if (ShouldBreak()) return Interpreter::kBreakPoint;     \
+  DISPATCH_TO(next)
+
 Interpreter::InterruptKind Engine::Interpret(
     TargetYieldResult* target_yield_result) {
 #define LABEL(name, branching, format, length, stack_diff, print) &&name##Label,
@@ -303,10 +315,7 @@ Interpreter::InterruptKind Engine::Interpret(
     Object* value = Local(0);
     Boxed* boxed = Boxed::cast(Local(offset));
     boxed->set_value(value);
-
-    if (value->IsHeapObject() && value->IsImmutable()) {
-      process()->store_buffer()->Insert(boxed);
-    }
+    process()->RecordStore(boxed, Boxed::kValueOffset, value);
 
     Advance(kStoreBoxedLength);
   OPCODE_END();
@@ -316,10 +325,8 @@ Interpreter::InterruptKind Engine::Interpret(
     Object* value = Local(0);
     Array* statics = process()->statics();
     statics->set(index, value);
-
-    if (value->IsHeapObject() && value->IsImmutable()) {
-      process()->store_buffer()->Insert(statics);
-    }
+    process()->RecordStore(
+        statics, Array::kSize + index * kPointerSize, value);
 
     Advance(kStoreStaticLength);
   OPCODE_END();
@@ -328,27 +335,23 @@ Interpreter::InterruptKind Engine::Interpret(
     Object* value = Pop();
     Instance* target = Instance::cast(Pop());
     ASSERT(!target->IsImmutable());
-    target->SetInstanceField(ReadByte(1), value);
+    int index = ReadByte(1);
+    target->SetInstanceField(index, value);
     Push(value);
     Advance(kStoreFieldLength);
-
-    if (value->IsHeapObject() && value->IsImmutable()) {
-      StoreBuffer* store_buffer = process()->store_buffer();
-      store_buffer->Insert(target);
-    }
+    process()->RecordStore(
+        target, Instance::kSize + index * kPointerSize, value);
   OPCODE_END();
 
   OPCODE_BEGIN(StoreFieldWide);
     Object* value = Pop();
     Instance* target = Instance::cast(Pop());
-    target->SetInstanceField(ReadInt32(1), value);
+    int index = ReadInt32(1);
+    target->SetInstanceField(index, value);
     Push(value);
     Advance(kStoreFieldWideLength);
-
-    if (value->IsHeapObject() && value->IsImmutable()) {
-      StoreBuffer* store_buffer = process()->store_buffer();
-      store_buffer->Insert(target);
-    }
+    process()->RecordStore(
+        target, Instance::kSize + index * kPointerSize, value);
   OPCODE_END();
 
   OPCODE_BEGIN(LoadLiteralNull);
@@ -392,8 +395,10 @@ Interpreter::InterruptKind Engine::Interpret(
     int selector = ReadInt32(1);
     int arity = Selector::ArityField::decode(selector);
     Object* receiver = Local(arity);
+    InlineCache::Entry* entry =
+        process()->LookupInlineCacheEntry(bcp(), receiver, selector);
     PushReturnAddress(kInvokeMethodLength);
-    Function* target = process()->LookupEntry(receiver, selector)->target;
+    Function* target = entry->target;
     Goto(target->bytecode_address_for(0));
     STACK_OVERFLOW_CHECK(0);
   OPCODE_END();
@@ -445,8 +450,16 @@ Interpreter::InterruptKind Engine::Interpret(
 
     int index = clazz->id() + offset;
     Array* entry = Array::cast(program()->vtable()->get(index));
-    if (Smi::cast(entry->get(0))->value() != offset) {
-      entry = Array::cast(program()->vtable()->get(0));
+    bool hit = Smi::cast(entry->get(0))->value() == offset;
+    if (!hit) entry = Array::cast(program()->vtable()->get(0));
+    if (Flags::lookup_cache_statistics) {
+      LookupCache::Statistics* statistics =
+          process()->thread_state()->cache()->statistics();
+      if (hit) {
+        statistics->vtable_hits++;
+      } else {
+        statistics->vtable_no_such_method++;
+      }
     }
     Function* target = Function::cast(entry->get(2));
     Goto(target->bytecode_address_for(0));
@@ -550,7 +563,9 @@ Interpreter::InterruptKind Engine::Interpret(
   OPCODE_BEGIN(InvokeTest);
     int selector = ReadInt32(1);
     Object* receiver = Local(0);
-    SetTop(ToBool(process()->LookupEntry(receiver, selector)->tag != 0));
+    InlineCache::Entry* entry =
+        process()->LookupInlineCacheEntry(bcp(), receiver, selector);
+    SetTop(ToBool(entry->tag != 0));
     Advance(kInvokeTestLength);
   OPCODE_END();
 
@@ -690,25 +705,17 @@ Interpreter::InterruptKind Engine::Interpret(
         result, process()->NewInstance(klass));
     Instance* instance = Instance::cast(result);
     int fields = klass->NumberOfInstanceFields();
-    bool in_store_buffer = false;
-    bool storebuffer_full = false;
+    bool has_immutable_pointers = false;
     for (int i = fields - 1; i >= 0; --i) {
       Object* value = Pop();
-      if (!in_store_buffer &&
-          value->IsImmutable() &&
-          value->IsHeapObject()) {
-        in_store_buffer = true;
-        StoreBuffer* store_buffer = process()->store_buffer();
-        store_buffer->Insert(instance);
-        storebuffer_full = store_buffer->ShouldDeduplicate();
+      if (value->IsImmutable() && value->IsHeapObject()) {
+        has_immutable_pointers = true;
       }
       instance->SetInstanceField(i, value);
     }
     Push(instance);
 
-    if (storebuffer_full) {
-      process()->store_buffer()->Deduplicate();
-    }
+    if (has_immutable_pointers) process()->RememberObject(instance);
     Advance(kAllocateLength);
   OPCODE_END();
 
@@ -718,25 +725,17 @@ Interpreter::InterruptKind Engine::Interpret(
         result, process()->NewInstance(klass));
     Instance* instance = Instance::cast(result);
     int fields = klass->NumberOfInstanceFields();
-    bool in_store_buffer = false;
-    bool storebuffer_full = false;
+    bool has_immutable_pointers = false;
     for (int i = fields - 1; i >= 0; --i) {
       Object* value = Pop();
-      if (!in_store_buffer &&
-          value->IsImmutable() &&
-          value->IsHeapObject()) {
-        in_store_buffer = true;
-        StoreBuffer* store_buffer = process()->store_buffer();
-        store_buffer->Insert(instance);
-        storebuffer_full = store_buffer->ShouldDeduplicate();
+      if (value->IsImmutable() && value->IsHeapObject()) {
+        has_immutable_pointers = true;
       }
       instance->SetInstanceField(i, value);
     }
     Push(instance);
 
-    if (storebuffer_full) {
-      process()->store_buffer()->Deduplicate();
-    }
+    if (has_immutable_pointers) process()->RememberObject(instance);
     Advance(kAllocateLength);
   OPCODE_END();
 
@@ -765,11 +764,7 @@ Interpreter::InterruptKind Engine::Interpret(
     Push(instance);
 
     if (!immutable && has_immutable_pointers) {
-      StoreBuffer* store_buffer = process()->store_buffer();
-      store_buffer->Insert(instance);
-      if (store_buffer->ShouldDeduplicate()) {
-        process()->store_buffer()->Deduplicate();
-      }
+      process()->RememberObject(instance);
     }
 
     Advance(kAllocateImmutableLength);
@@ -798,11 +793,7 @@ Interpreter::InterruptKind Engine::Interpret(
     Push(instance);
 
     if (!immutable && has_immutable_pointers) {
-      StoreBuffer* store_buffer = process()->store_buffer();
-      store_buffer->Insert(instance);
-      if (store_buffer->ShouldDeduplicate()) {
-        process()->store_buffer()->Deduplicate();
-      }
+      process()->RememberObject(instance);
     }
 
     Advance(kAllocateImmutableUnfoldLength);
@@ -920,6 +911,31 @@ Interpreter::InterruptKind Engine::Interpret(
     Advance(kFrameSizeLength);
   OPCODE_END();
 
+  OPCODE_BEGIN(LoadLocal0LoadField);
+    Push(Local(0));
+    Advance(kLoadLocal0Length);
+  OPCODE_END_FUSED(LoadField);
+
+  OPCODE_BEGIN(LoadLocal1LoadField);
+    Push(Local(1));
+    Advance(kLoadLocal1Length);
+  OPCODE_END_FUSED(LoadField);
+
+  OPCODE_BEGIN(LoadLocalLoadField);
+    Push(Local(ReadByte(1)));
+    Advance(kLoadLocalLength);
+  OPCODE_END_FUSED(LoadField);
+
+  OPCODE_BEGIN(LoadLocal0InvokeMethodVtable);
+    Push(Local(0));
+    Advance(kLoadLocal0Length);
+  OPCODE_END_FUSED(InvokeMethodVtable);
+
+  OPCODE_BEGIN(LoadLiteralNullIdentical);
+    Push(program()->null_object());
+    Advance(kLoadLiteralNullLength);
+  OPCODE_END_FUSED(Identical);
+
   OPCODE_BEGIN(MethodEnd);
     FATAL("Cannot interpret 'method-end' bytecodes.");
   OPCODE_END();
@@ -964,13 +980,16 @@ bool Engine::DoThrow(Object* exception) {
 }
 
 bool Engine::CollectGarbageIfNecessary() {
-  if (process()->heap()->needs_garbage_collection()) {
-    CollectMutableGarbage();
+  if (process()->allocation_sample_pending()) {
+    SaveState();
+    process()->RecordAllocationSample();
+    RestoreState();
   }
-  if (process()->store_buffer()->ShouldDeduplicate()) {
-    process()->store_buffer()->Deduplicate();
+  if (process()->needs_garbage_collection()) {
+    CollectMutableGarbage();
   }
-  return process()->immutable_heap()->needs_garbage_collection();
+  return !process()->out_of_memory() &&
+      process()->NeedsImmutableGarbageCollection();
 }
 
 void Engine::CollectMutableGarbage() {
@@ -978,13 +997,11 @@ void Engine::CollectMutableGarbage() {
   process()->CollectMutableGarbage();
   RestoreState();
 
-  // After a mutable GC a lot of stacks might no longer have pointers to
-  // immutable space on them. If so, the store buffer will no longer contain
-  // such a stack.
-  //
-  // Since we don't update the store buffer on every mutating operation
-  // - e.g. SetLocal() - we add it before we start using it.
-  process()->store_buffer()->Insert(process()->stack());
+  // After a mutable GC the cards of the stack are only dirty where it has
+  // pointers that need to be remembered. Since there is no write barrier
+  // for stores to the stack - e.g. SetLocal() - we mark all its cards
+  // before we start using it.
+  process()->RememberObject(process()->stack());
 }
 
 void Engine::ValidateStack() {
@@ -1024,6 +1041,11 @@ bool Engine::IsAtBreakPoint() {
   return false;
 }
 
+// The generated interpreters do not update the lookup cache statistics.
+static bool UseNativeInterpreter() {
+  return !Flags::lookup_cache_statistics;
+}
+
 void Interpreter::Run() {
   ASSERT(interruption_ == kReady);
   process_->RestoreErrno();
@@ -1031,18 +1053,18 @@ void Interpreter::Run() {
 
   // Whenever we enter the interpreter, we might operate on a stack which
   // doesn't contain any references to immutable space. This means the
-  // storebuffer might *NOT* contain the stack.
+  // cards of the stack might *NOT* be dirty.
   //
-  // Since we don't update the store buffer on every mutating operation - e.g.
-  // SetLocal() - we add it as soon as the interpreter uses it:
+  // Since there is no write barrier for stores to the stack - e.g.
+  // SetLocal() - we mark all its cards as soon as the interpreter uses it:
   //   * once we enter the interpreter
   //   * once we we're done with mutable GC
   //   * once we we've done a coroutine change
   // This is conservative.
-  process_->store_buffer()->Insert(process_->stack());
+  process_->RememberObject(process_->stack());
 
   int result = -1;
-  if (!process_->is_debugging()) {
+  if (!process_->is_debugging() && UseNativeInterpreter()) {
     result = InterpretFast(process_, &target_yield_result_);
   }
   if (result < 0) {
@@ -1052,13 +1074,6 @@ void Interpreter::Run() {
     interruption_ = static_cast<InterruptKind>(result);
   }
 
-  // NOTE: We compact storebuffers on explicit yields or implicit preemptive
-  // interrupts by the scheduler. The amount of additional entries is thereby
-  // upper bounded by the preemptive intervals.
-  if (process_->store_buffer()->ShouldDeduplicate()) {
-    process_->store_buffer()->Deduplicate();
-  }
-
   process_->ReleaseLookupCache();
   process_->StoreErrno();
   ASSERT(interruption_ != kReady);
@@ -1075,24 +1090,24 @@ bool HandleIsInvokeFast(int opcode) {
 }
 
 int HandleGC(Process* process) {
-  if (process->heap()->needs_garbage_collection()) {
+  if (process->allocation_sample_pending()) {
+    process->RecordAllocationSample();
+  }
+  if (process->needs_garbage_collection()) {
     process->CollectMutableGarbage();
 
-    // After a mutable GC a lot of stacks might no longer have pointers to
-    // immutable space on them. If so, the store buffer will no longer contain
-    // such a stack.
-    //
-    // Since we don't update the store buffer on every mutating operation
-    // - e.g. SetLocal() - we add it before we start using it.
-    process->store_buffer()->Insert(process->stack());
-  }
-  if (process->store_buffer()->ShouldDeduplicate()) {
-    process->store_buffer()->Deduplicate();
+    // After a mutable GC the cards of the stack are only dirty where it
+    // has pointers that need to be remembered. Since there is no write
+    // barrier for stores to the stack - e.g. SetLocal() - we mark all its
+    // cards before we start using it.
+    process->RememberObject(process->stack());
   }
 
-  return process->immutable_heap()->needs_garbage_collection()
-      ? 1
-      : 0;
+  if (!process->out_of_memory() &&
+      process->NeedsImmutableGarbageCollection()) {
+    return 1;
+  }
+  return process->TakeOutOfMemory() ? 2 : 0;
 }
 
 Object* HandleObjectFromFailure(Process* process, Failure* failure) {
@@ -1107,22 +1122,21 @@ Object* HandleAllocate(Process* process,
   if (result->IsFailure()) return result;
 
   if (immutable != 1 && immutable_heapobject_member == 1) {
-    StoreBuffer* store_buffer = process->store_buffer();
-    store_buffer->Insert(HeapObject::cast(result));
-    if (store_buffer->ShouldDeduplicate()) {
-      store_buffer->Deduplicate();
-    }
+    process->RememberObject(HeapObject::cast(result));
   }
   return result;
 }
 
-void AddToStoreBufferSlow(Process* process, Object* object, Object* value) {
+void HandleRecordStore(Process* process,
+                       Object* object,
+                       Object* value,
+                       Object** slot) {
   ASSERT(object->IsHeapObject());
-  ASSERT(process->heap()->space()->Includes(
-      HeapObject::cast(object)->address()));
-  if (value->IsHeapObject() && value->IsImmutable()) {
-    process->store_buffer()->Insert(HeapObject::cast(object));
-  }
+  HeapObject* heap_object = HeapObject::cast(object);
+  ASSERT(process->HeapIncludes(heap_object->address()));
+  int offset = reinterpret_cast<uword>(slot) - heap_object->address();
+  ASSERT(offset > 0 && offset < heap_object->Size());
+  process->RecordStore(heap_object, offset, value);
 }
 
 Object* HandleAllocateBoxed(Process* process, Object* value) {
@@ -1130,11 +1144,7 @@ Object* HandleAllocateBoxed(Process* process, Object* value) {
   if (boxed->IsFailure()) return boxed;
 
   if (value->IsHeapObject() && !value->IsNull() && value->IsImmutable()) {
-    StoreBuffer* store_buffer = process->store_buffer();
-    store_buffer->Insert(HeapObject::cast(boxed));
-    if (store_buffer->ShouldDeduplicate()) {
-      store_buffer->Deduplicate();
-    }
+    process->RememberObject(HeapObject::cast(boxed));
   }
   return boxed;
 }
@@ -1182,6 +1192,9 @@ uint8* HandleThrow(Process* process, Object* exception, int* stack_delta) {
       // Uncaught exception.
       Print::Out("Uncaught exception:\n");
       exception->Print();
+      if (exception == process->program()->raw_out_of_memory()) {
+        process->set_uncaught_out_of_memory();
+      }
       return NULL;
     }
 
@@ -106,9 +106,10 @@ extern "C" Object* HandleAllocate(Process* process,
                                   int immutable,
                                   int has_immutable_heapobject_member);
 
-extern "C" void AddToStoreBufferSlow(Process* process,
-                                     Object* object,
-                                     Object* value);
+extern "C" void HandleRecordStore(Process* process,
+                                  Object* object,
+                                  Object* value,
+                                  Object** slot);
 
 extern "C" Object* HandleAllocateBoxed(Process* process, Object* value);
 
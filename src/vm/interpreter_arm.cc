@@ -212,6 +212,13 @@ class InterpreterGeneratorARM: public InterpreterGenerator {
   virtual void DoExitNoSuchMethod();
 
   virtual void DoFrameSize();
+
+  virtual void DoLoadLocal0LoadField();
+  virtual void DoLoadLocal1LoadField();
+  virtual void DoLoadLocalLoadField();
+  virtual void DoLoadLocal0InvokeMethodVtable();
+  virtual void DoLoadLiteralNullIdentical();
+
   virtual void DoMethodEnd();
 
   virtual void DoIntrinsicObjectEquals();
@@ -240,7 +247,7 @@ class InterpreterGeneratorARM: public InterpreterGenerator {
   void Allocate(bool unfolded, bool immutable);
 
   // This function changes caller-saved registers.
-  void AddToStoreBufferSlow(Register object, Register value);
+  void RecordStore(Register object, Register value, Register slot);
 
   void InvokeEq(const char* fallback);
   void InvokeLt(const char* fallback);
@@ -273,6 +280,10 @@ class InterpreterGeneratorARM: public InterpreterGenerator {
 
   void Dispatch(int size);
 
+  // Continues a fused bytecode with the bytecode [size] bytes further on,
+  // which is handled by the code at [next].
+  void DispatchFused(int size, const char* next);
+
   void SaveState();
   void RestoreState();
 
@@ -339,15 +350,24 @@ void InterpreterGeneratorARM::GenerateEpilogue() {
   __ b(&undo_padding);
 
   // Handle GC and re-interpret current bytecode.
+  Label out_of_memory;
   __ Bind(&gc_);
   SaveState();
   __ mov(R0, R4);
   __ bl("HandleGC");
-  __ tst(R0, R0);
-  __ b(NE, &immutable_alloc_failure);
+  __ cmp(R0, Immediate(1));
+  __ b(EQ, &immutable_alloc_failure);
+  __ b(GT, &out_of_memory);
   RestoreState();
   Dispatch(0);
 
+  // Throw an out of memory exception if the process heap is still over
+  // its limit after the GC.
+  __ Bind(&out_of_memory);
+  __ ldr(R7, Address(R4, Process::ProgramOffset()));
+  __ ldr(R7, Address(R7, Program::raw_out_of_memory_offset()));
+  DoThrowAfterSaveState();
+
   // Stack overflow handling (slow case).
   Label stay_fast, overflow;
   __ Bind(&check_stack_overflow_0_);
@@ -516,9 +536,10 @@ void InterpreterGeneratorARM::DoStoreBoxed() {
   __ ldrb(R0, Address(R5, 1));
   __ neg(R0, R0);
   __ ldr(R1, Address(R6, Operand(R0, TIMES_4)));
-  __ str(R2, Address(R1, Boxed::kValueOffset - HeapObject::kTag));
+  __ add(R3, R1, Immediate(Boxed::kValueOffset - HeapObject::kTag));
+  __ str(R2, Address(R3, 0));
 
-  AddToStoreBufferSlow(R1, R2);
+  RecordStore(R1, R2, R3);
 
   Dispatch(kStoreBoxedLength);
 }
@@ -528,9 +549,10 @@ void InterpreterGeneratorARM::DoStoreStatic() {
   __ ldr(R0, Address(R5, 1));
   __ ldr(R1, Address(R4, Process::StaticsOffset()));
   __ add(R3, R1, Immediate(Array::kSize - HeapObject::kTag));
-  __ str(R2, Address(R3, Operand(R0, TIMES_4)));
+  __ add(R3, R3, Operand(R0, TIMES_4));
+  __ str(R2, Address(R3, 0));
 
-  AddToStoreBufferSlow(R1, R2);
+  RecordStore(R1, R2, R3);
 
   Dispatch(kStoreStaticLength);
 }
@@ -540,11 +562,12 @@ void InterpreterGeneratorARM::DoStoreField() {
   LoadLocal(R2, 0);
   LoadLocal(R0, 1);
   __ add(R3, R0, Immediate(Instance::kSize - HeapObject::kTag));
-  __ str(R2, Address(R3, Operand(R1, TIMES_4)));
+  __ add(R3, R3, Operand(R1, TIMES_4));
+  __ str(R2, Address(R3, 0));
   StoreLocal(R2, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(R0, R2);
+  RecordStore(R0, R2, R3);
 
   Dispatch(kStoreFieldLength);
 }
@@ -554,11 +577,12 @@ void InterpreterGeneratorARM::DoStoreFieldWide() {
   LoadLocal(R2, 0);
   LoadLocal(R0, 1);
   __ add(R3, R0, Immediate(Instance::kSize - HeapObject::kTag));
-  __ str(R2, Address(R3, Operand(R1, TIMES_4)));
+  __ add(R3, R3, Operand(R1, TIMES_4));
+  __ str(R2, Address(R3, 0));
   StoreLocal(R2, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(R0, R2);
+  RecordStore(R0, R2, R3);
 
   Dispatch(kStoreFieldWideLength);
 }
@@ -1222,6 +1246,37 @@ void InterpreterGeneratorARM::DoFrameSize() {
   __ bkpt();
 }
 
+void InterpreterGeneratorARM::DoLoadLocal0LoadField() {
+  LoadLocal(R0, 0);
+  Push(R0);
+  DispatchFused(kLoadLocal0Length, "BC_LoadField");
+}
+
+void InterpreterGeneratorARM::DoLoadLocal1LoadField() {
+  LoadLocal(R0, 1);
+  Push(R0);
+  DispatchFused(kLoadLocal1Length, "BC_LoadField");
+}
+
+void InterpreterGeneratorARM::DoLoadLocalLoadField() {
+  __ ldrb(R0, Address(R5, 1));
+  __ neg(R1, R0);
+  __ ldr(R0, Address(R6, Operand(R1, TIMES_4)));
+  Push(R0);
+  DispatchFused(kLoadLocalLength, "BC_LoadField");
+}
+
+void InterpreterGeneratorARM::DoLoadLocal0InvokeMethodVtable() {
+  LoadLocal(R0, 0);
+  Push(R0);
+  DispatchFused(kLoadLocal0Length, "BC_InvokeMethodVtable");
+}
+
+void InterpreterGeneratorARM::DoLoadLiteralNullIdentical() {
+  Push(R8);
+  DispatchFused(kLoadLiteralNullLength, "BC_Identical");
+}
+
 void InterpreterGeneratorARM::DoMethodEnd() {
   __ bkpt();
 }
@@ -1250,11 +1305,12 @@ void InterpreterGeneratorARM::DoIntrinsicSetField() {
   LoadLocal(R0, 0);
   LoadLocal(R2, 1);
   __ add(R3, R2, Immediate(Instance::kSize - HeapObject::kTag));
-  __ str(R0, Address(R3, Operand(R1, TIMES_4)));
+  __ add(R3, R3, Operand(R1, TIMES_4));
+  __ str(R0, Address(R3, 0));
   StoreLocal(R0, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(R2, R0);
+  RecordStore(R2, R0, R3);
 
   Dispatch(kInvokeMethodLength);
 }
@@ -1308,12 +1364,13 @@ void InterpreterGeneratorARM::DoIntrinsicListIndexSet() {
   // Store to the array and continue.
   ASSERT(Smi::kTagSize == 1);
   LoadLocal(R0, 0);
-  __ add(R12, R2, Immediate(Array::kSize - HeapObject::kTag));
-  __ str(R0, Address(R12, Operand(R1, TIMES_2)));
+  __ add(R3, R2, Immediate(Array::kSize - HeapObject::kTag));
+  __ add(R3, R3, Operand(R1, TIMES_2));
+  __ str(R0, Address(R3, 0));
   StoreLocal(R0, 2);
   Drop(2);
 
-  AddToStoreBufferSlow(R2, R0);
+  RecordStore(R2, R0, R3);
 
   Dispatch(kInvokeMethodLength);
 }
@@ -1405,11 +1462,10 @@ void InterpreterGeneratorARM::InvokeMethod(bool test) {
 
   // Find the entry in the primary lookup cache.
   Label miss, finish;
-  ASSERT(Utils::IsPowerOfTwo(LookupCache::kPrimarySize));
   ASSERT(sizeof(LookupCache::Entry) == 1 << 4);
   __ Bind(&probe);
   __ eor(R3, R2, R7);
-  __ ldr(R0, Immediate(LookupCache::kPrimarySize - 1));
+  __ ldr(R0, Address(R4, Process::PrimaryLookupCacheMaskOffset()));
   __ and_(R0, R3, R0);
   __ ldr(R3, Address(R4, Process::PrimaryLookupCacheOffset()));
   __ add(R0, R3, Operand(R0, LSL, 4));
@@ -1900,8 +1956,13 @@ void InterpreterGeneratorARM::Allocate(bool unfolded, bool immutable) {
 }
 
 
-void InterpreterGeneratorARM::AddToStoreBufferSlow(Register object,
-                                                   Register value) {
+void InterpreterGeneratorARM::RecordStore(Register object,
+                                          Register value,
+                                          Register slot) {
+  if (slot != R3) {
+    ASSERT(object != R3 && value != R3);
+    __ mov(R3, slot);
+  }
   if (object != R1) {
     ASSERT(value != R1);
     __ mov(R1, object);
@@ -1910,7 +1971,7 @@ void InterpreterGeneratorARM::AddToStoreBufferSlow(Register object,
     __ mov(R2, value);
   }
   __ mov(R0, R4);
-  __ bl("AddToStoreBufferSlow");
+  __ bl("HandleRecordStore");
 }
 
 void InterpreterGeneratorARM::InvokeCompare(const char* fallback,
@@ -1961,6 +2022,12 @@ void InterpreterGeneratorARM::Dispatch(int size) {
   __ GenerateConstantPool();
 }
 
+void InterpreterGeneratorARM::DispatchFused(int size, const char* next) {
+  __ add(R5, R5, Immediate(size));
+  __ b(next);
+  __ GenerateConstantPool();
+}
+
 void InterpreterGeneratorARM::SaveState() {
   // Push the bytecode pointer on the stack.
   Push(R5);
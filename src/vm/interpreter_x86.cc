@@ -209,6 +209,13 @@ class InterpreterGeneratorX86: public InterpreterGenerator {
   virtual void DoExitNoSuchMethod();
 
   virtual void DoFrameSize();
+
+  virtual void DoLoadLocal0LoadField();
+  virtual void DoLoadLocal1LoadField();
+  virtual void DoLoadLocalLoadField();
+  virtual void DoLoadLocal0InvokeMethodVtable();
+  virtual void DoLoadLiteralNullIdentical();
+
   virtual void DoMethodEnd();
 
   virtual void DoIntrinsicObjectEquals();
@@ -239,7 +246,7 @@ class InterpreterGeneratorX86: public InterpreterGenerator {
   // This function
   //   * changes the first three stack slots
   //   * changes caller-saved registers
-  void AddToStoreBufferSlow(Register object, Register value);
+  void RecordStore(Register object, Register value, const Address& slot);
 
   void InvokeMethod(bool test);
   void InvokeMethodFast(bool test);
@@ -274,6 +281,10 @@ class InterpreterGeneratorX86: public InterpreterGenerator {
 
   void Dispatch(int size);
 
+  // Continues a fused bytecode with the bytecode [size] bytes further on,
+  // which is handled by the code at [next].
+  void DispatchFused(int size, const char* next);
+
   void SaveState();
   void RestoreState();
 
@@ -332,15 +343,24 @@ void InterpreterGeneratorX86::GenerateEpilogue() {
   __ jmp(&undo_padding);
 
   // Handle GC and re-interpret current bytecode.
+  Label out_of_memory;
   __ Bind(&gc_);
   SaveState();
   __ movl(Address(ESP, 0 * kWordSize), EBP);
   __ call("HandleGC");
-  __ testl(EAX, EAX);
-  __ j(NOT_ZERO, &immutable_alloc_failure);
+  __ cmpl(EAX, Immediate(1));
+  __ j(EQUAL, &immutable_alloc_failure);
+  __ j(GREATER, &out_of_memory);
   RestoreState();
   Dispatch(0);
 
+  // Throw an out of memory exception if the process heap is still over
+  // its limit after the GC.
+  __ Bind(&out_of_memory);
+  __ movl(EBX, Address(EBP, Process::ProgramOffset()));
+  __ movl(EBX, Address(EBX, Program::raw_out_of_memory_offset()));
+  DoThrowAfterSaveState();
+
   // Stack overflow handling (slow case).
   Label stay_fast, overflow;
   __ Bind(&check_stack_overflow_0_);
@@ -504,9 +524,10 @@ void InterpreterGeneratorX86::DoStoreBoxed() {
   __ movzbl(EAX, Address(ESI, 1));
   __ negl(EAX);
   __ movl(EBX, Address(EDI, EAX, TIMES_4));
-  __ movl(Address(EBX, Boxed::kValueOffset - HeapObject::kTag), ECX);
+  Address slot(EBX, Boxed::kValueOffset - HeapObject::kTag);
+  __ movl(slot, ECX);
 
-  AddToStoreBufferSlow(EBX, ECX);
+  RecordStore(EBX, ECX, slot);
 
   Dispatch(kStoreBoxedLength);
 }
@@ -515,9 +536,10 @@ void InterpreterGeneratorX86::DoStoreStatic() {
   LoadLocal(ECX, 0);
   __ movl(EAX, Address(ESI, 1));
   __ movl(EBX, Address(EBP, Process::StaticsOffset()));
-  __ movl(Address(EBX, EAX, TIMES_4, Array::kSize - HeapObject::kTag), ECX);
+  Address slot(EBX, EAX, TIMES_4, Array::kSize - HeapObject::kTag);
+  __ movl(slot, ECX);
 
-  AddToStoreBufferSlow(EBX, ECX);
+  RecordStore(EBX, ECX, slot);
 
   Dispatch(kStoreStaticLength);
 }
@@ -526,11 +548,12 @@ void InterpreterGeneratorX86::DoStoreField() {
   __ movzbl(EBX, Address(ESI, 1));
   LoadLocal(ECX, 0);
   LoadLocal(EAX, 1);
-  __ movl(Address(EAX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag), ECX);
+  Address slot(EAX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag);
+  __ movl(slot, ECX);
   StoreLocal(ECX, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(EAX, ECX);
+  RecordStore(EAX, ECX, slot);
 
   Dispatch(kStoreFieldLength);
 }
@@ -539,11 +562,12 @@ void InterpreterGeneratorX86::DoStoreFieldWide() {
   __ movl(EBX, Address(ESI, 1));
   LoadLocal(ECX, 0);
   LoadLocal(EAX, 1);
-  __ movl(Address(EAX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag), ECX);
+  Address slot(EAX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag);
+  __ movl(slot, ECX);
   StoreLocal(ECX, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(EAX, ECX);
+  RecordStore(EAX, ECX, slot);
 
   Dispatch(kStoreFieldWideLength);
 }
@@ -1254,6 +1278,39 @@ void InterpreterGeneratorX86::DoFrameSize() {
   __ int3();
 }
 
+void InterpreterGeneratorX86::DoLoadLocal0LoadField() {
+  LoadLocal(EAX, 0);
+  Push(EAX);
+  DispatchFused(kLoadLocal0Length, "BC_LoadField");
+}
+
+void InterpreterGeneratorX86::DoLoadLocal1LoadField() {
+  LoadLocal(EAX, 1);
+  Push(EAX);
+  DispatchFused(kLoadLocal1Length, "BC_LoadField");
+}
+
+void InterpreterGeneratorX86::DoLoadLocalLoadField() {
+  __ movzbl(EAX, Address(ESI, 1));
+  __ negl(EAX);
+  __ movl(EAX, Address(EDI, EAX, TIMES_4));
+  Push(EAX);
+  DispatchFused(kLoadLocalLength, "BC_LoadField");
+}
+
+void InterpreterGeneratorX86::DoLoadLocal0InvokeMethodVtable() {
+  LoadLocal(EAX, 0);
+  Push(EAX);
+  DispatchFused(kLoadLocal0Length, "BC_InvokeMethodVtable");
+}
+
+void InterpreterGeneratorX86::DoLoadLiteralNullIdentical() {
+  __ movl(EAX, Address(EBP, Process::ProgramOffset()));
+  __ movl(EAX, Address(EAX, Program::null_object_offset()));
+  Push(EAX);
+  DispatchFused(kLoadLiteralNullLength, "BC_Identical");
+}
+
 void InterpreterGeneratorX86::DoMethodEnd() {
   __ int3();
 }
@@ -1291,11 +1348,12 @@ void InterpreterGeneratorX86::DoIntrinsicSetField() {
   __ movzbl(EBX, Address(EAX, 3 + Function::kSize - HeapObject::kTag));
   LoadLocal(EAX, 0);
   LoadLocal(ECX, 1);
-  __ movl(Address(ECX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag), EAX);
+  Address slot(ECX, EBX, TIMES_4, Instance::kSize - HeapObject::kTag);
+  __ movl(slot, EAX);
   StoreLocal(EAX, 1);
   Drop(1);
 
-  AddToStoreBufferSlow(ECX, EAX);
+  RecordStore(ECX, EAX, slot);
 
   Dispatch(kInvokeMethodLength);
 }
@@ -1349,11 +1407,12 @@ void InterpreterGeneratorX86::DoIntrinsicListIndexSet() {
   ASSERT(Smi::kTagSize == 1);
   LoadLocal(EAX, 0);
   // TODO(kustermann): Why ist this TIMES_2.
-  __ movl(Address(ECX, EBX, TIMES_2, Array::kSize - HeapObject::kTag), EAX);
+  Address slot(ECX, EBX, TIMES_2, Array::kSize - HeapObject::kTag);
+  __ movl(slot, EAX);
   StoreLocal(EAX, 2);
   Drop(2);
 
-  AddToStoreBufferSlow(ECX, EAX);
+  RecordStore(ECX, EAX, slot);
 
   Dispatch(kInvokeMethodLength);
 }
@@ -1567,12 +1626,16 @@ void InterpreterGeneratorX86::Allocate(bool unfolded, bool immutable) {
   Dispatch(kAllocateLength);
 }
 
-void InterpreterGeneratorX86::AddToStoreBufferSlow(Register object,
-                                                   Register value) {
+void InterpreterGeneratorX86::RecordStore(Register object,
+                                          Register value,
+                                          const Address& slot) {
+  ASSERT(object != EDX && value != EDX);
+  __ leal(EDX, slot);
   __ movl(Address(ESP, 0 * kWordSize), EBP);
   __ movl(Address(ESP, 1 * kWordSize), object);
   __ movl(Address(ESP, 2 * kWordSize), value);
-  __ call("AddToStoreBufferSlow");
+  __ movl(Address(ESP, 3 * kWordSize), EDX);
+  __ call("HandleRecordStore");
 }
 
 void InterpreterGeneratorX86::InvokeMethod(bool test) {
@@ -1602,12 +1665,12 @@ void InterpreterGeneratorX86::InvokeMethod(bool test) {
 
   // Find the entry in the primary lookup cache.
   Label miss, finish;
-  ASSERT(Utils::IsPowerOfTwo(LookupCache::kPrimarySize));
   ASSERT(sizeof(LookupCache::Entry) == 1 << 4);
   __ Bind(&probe);
   __ movl(EAX, EBX);
   __ xorl(EAX, EDX);
-  __ andl(EAX, Immediate(LookupCache::kPrimarySize - 1));
+  __ movl(ECX, Address(EBP, Process::PrimaryLookupCacheMaskOffset()));
+  __ andl(EAX, ECX);
   __ shll(EAX, Immediate(4));
   __ movl(ECX, Address(EBP, Process::PrimaryLookupCacheOffset()));
   __ addl(EAX, ECX);
@@ -2041,6 +2104,11 @@ void InterpreterGeneratorX86::Dispatch(int size) {
   printf("\tjmp *InterpretFast_DispatchTable(,%%ebx,4)\n");
 }
 
+void InterpreterGeneratorX86::DispatchFused(int size, const char* next) {
+  __ addl(ESI, Immediate(size));
+  __ jmp(next);
+}
+
 void InterpreterGeneratorX86::SaveState() {
   // Push the bytecode pointer on the stack.
   Push(ESI);
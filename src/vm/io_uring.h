@@ -0,0 +1,85 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_IO_URING_H_
+#define SRC_VM_IO_URING_H_
+
+#include <stddef.h>
+
+#include "src/shared/globals.h"
+#include "src/shared/platform.h"
+
+namespace fletch {
+
+// A minimal io_uring instance, talking to the kernel through the raw system
+// calls. It only supports the operations the event handler needs: one-shot
+// readiness polls. Reads, writes and accepts are still done synchronously by
+// the Dart code once a poll completes.
+//
+// A submission that fails is taken back out of the ring, so its user data
+// may be released right away.
+//
+// Submitting is thread safe. Completions must only be consumed by a single
+// thread.
+class IoUring {
+ public:
+  // Returns NULL if the kernel does not support io_uring, or lacks a feature
+  // we depend on.
+  static IoUring* Create(int entries);
+  ~IoUring();
+
+  int fd() const { return fd_; }
+
+  // Submit a one-shot poll for the poll(2) [events] on [fd]. The completion
+  // result is the mask of events that were signalled.
+  bool PollAdd(int fd, uint32 events, uint64 user_data);
+
+  // Cancel the poll submitted with [user_data]. If it is still pending, it
+  // completes with -ECANCELED. The remove request itself completes with
+  // [kIgnoredUserData].
+  bool PollRemove(uint64 user_data);
+
+  // Wait until there is at least one completion, or [timeout] milliseconds
+  // have passed. A timeout of -1 means wait forever.
+  void Wait(int timeout);
+
+  // Take the oldest completion. Returns false if there is none.
+  bool NextCompletion(uint64* user_data, int32* result);
+
+  static const uint64 kIgnoredUserData = 0;
+
+ private:
+  IoUring(int fd, Mutex* mutex);
+
+  bool Map(void* params);
+  bool Submit(uint8 opcode,
+              int fd,
+              uint64 address,
+              uint32 flags,
+              uint64 user_data);
+
+  const int fd_;
+  // Protects the submission queue.
+  Mutex* const mutex_;
+
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  void* sqes_;
+  size_t sqes_size_;
+
+  uint32* sq_head_;
+  uint32* sq_tail_;
+  uint32 sq_mask_;
+  uint32* sq_array_;
+  uint32* cq_head_;
+  uint32* cq_tail_;
+  uint32 cq_mask_;
+  void* cqes_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_IO_URING_H_
@@ -0,0 +1,247 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#if defined(FLETCH_TARGET_OS_LINUX)
+
+#include "src/vm/io_uring.h"
+
+#include "src/shared/assert.h"
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FLETCH_HAS_IO_URING
+#endif
+#endif
+
+#ifdef FLETCH_HAS_IO_URING
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fletch {
+
+static int Setup(uint32 entries, struct io_uring_params* params) {
+  return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int Enter(int fd,
+                 uint32 to_submit,
+                 uint32 min_complete,
+                 uint32 flags,
+                 void* argument,
+                 size_t argument_size) {
+  return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                 argument, argument_size);
+}
+
+IoUring* IoUring::Create(int entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = Setup(entries, &params);
+  if (fd < 0) return NULL;
+  // Waiting with a timeout needs IORING_ENTER_EXT_ARG.
+  if ((params.features & IORING_FEAT_EXT_ARG) == 0) {
+    close(fd);
+    return NULL;
+  }
+  IoUring* ring = new IoUring(fd, Platform::CreateMutex());
+  if (!ring->Map(&params)) {
+    delete ring;
+    return NULL;
+  }
+  return ring;
+}
+
+IoUring::IoUring(int fd, Mutex* mutex)
+    : fd_(fd),
+      mutex_(mutex),
+      sq_ring_(MAP_FAILED),
+      sq_ring_size_(0),
+      cq_ring_(MAP_FAILED),
+      cq_ring_size_(0),
+      sqes_(MAP_FAILED),
+      sqes_size_(0),
+      sq_head_(NULL),
+      sq_tail_(NULL),
+      sq_mask_(0),
+      sq_array_(NULL),
+      cq_head_(NULL),
+      cq_tail_(NULL),
+      cq_mask_(0),
+      cqes_(NULL) {
+}
+
+IoUring::~IoUring() {
+  if (sqes_ != MAP_FAILED) munmap(sqes_, sqes_size_);
+  if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != MAP_FAILED) munmap(sq_ring_, sq_ring_size_);
+  close(fd_);
+  delete mutex_;
+}
+
+bool IoUring::Map(void* raw_params) {
+  struct io_uring_params* params =
+      reinterpret_cast<struct io_uring_params*>(raw_params);
+  sq_ring_size_ = params->sq_off.array + params->sq_entries * sizeof(uint32);
+  cq_ring_size_ =
+      params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+  bool single_mmap = (params->features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap && cq_ring_size_ > sq_ring_size_) {
+    sq_ring_size_ = cq_ring_size_;
+  }
+
+  sq_ring_ = mmap(NULL, sq_ring_size_, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) return false;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(NULL, cq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) return false;
+  }
+  sqes_size_ = params->sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = mmap(NULL, sqes_size_, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) return false;
+
+  uint8* sq = reinterpret_cast<uint8*>(sq_ring_);
+  sq_head_ = reinterpret_cast<uint32*>(sq + params->sq_off.head);
+  sq_tail_ = reinterpret_cast<uint32*>(sq + params->sq_off.tail);
+  sq_mask_ = *reinterpret_cast<uint32*>(sq + params->sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<uint32*>(sq + params->sq_off.array);
+
+  uint8* cq = reinterpret_cast<uint8*>(cq_ring_);
+  cq_head_ = reinterpret_cast<uint32*>(cq + params->cq_off.head);
+  cq_tail_ = reinterpret_cast<uint32*>(cq + params->cq_off.tail);
+  cq_mask_ = *reinterpret_cast<uint32*>(cq + params->cq_off.ring_mask);
+  cqes_ = cq + params->cq_off.cqes;
+  return true;
+}
+
+bool IoUring::Submit(uint8 opcode,
+                     int fd,
+                     uint64 address,
+                     uint32 flags,
+                     uint64 user_data) {
+  ScopedLock locker(mutex_);
+  uint32 head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  uint32 tail = *sq_tail_;
+  // Every entry is handed to the kernel right away, so the queue can only be
+  // full if the kernel failed to consume earlier entries.
+  if (tail - head > sq_mask_) return false;
+
+  uint32 index = tail & sq_mask_;
+  struct io_uring_sqe* sqe =
+      reinterpret_cast<struct io_uring_sqe*>(sqes_) + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = address;
+  sqe->poll32_events = flags;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  int result;
+  do {
+    result = Enter(fd_, 1, 0, 0, NULL, 0);
+  } while (result == -1 && errno == EINTR);
+  if (result == 1) return true;
+
+  // The kernel did not take the entry. Retract it, so the next submission
+  // does not hand it over after the caller has released its user data.
+  if (__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == tail) {
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+  // The entry was consumed after all, so it will complete.
+  return true;
+}
+
+bool IoUring::PollAdd(int fd, uint32 events, uint64 user_data) {
+  ASSERT(user_data != kIgnoredUserData);
+  return Submit(IORING_OP_POLL_ADD, fd, 0, events, user_data);
+}
+
+bool IoUring::PollRemove(uint64 user_data) {
+  return Submit(IORING_OP_POLL_REMOVE, -1, user_data, 0, kIgnoredUserData);
+}
+
+void IoUring::Wait(int timeout) {
+  if (*cq_head_ != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return;
+
+  uint32 flags = IORING_ENTER_GETEVENTS;
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg argument;
+  memset(&argument, 0, sizeof(argument));
+  if (timeout >= 0) {
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000;
+    argument.ts = reinterpret_cast<uint64>(&ts);
+    flags |= IORING_ENTER_EXT_ARG;
+  }
+  // Timeouts and interrupts show up as ETIME and EINTR. Either way the
+  // caller looks at the completion queue and starts over.
+  if (timeout >= 0) {
+    Enter(fd_, 0, 1, flags, &argument, sizeof(argument));
+  } else {
+    Enter(fd_, 0, 1, flags, NULL, 0);
+  }
+}
+
+bool IoUring::NextCompletion(uint64* user_data, int32* result) {
+  uint32 head = *cq_head_;
+  if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) return false;
+  struct io_uring_cqe* cqe =
+      reinterpret_cast<struct io_uring_cqe*>(cqes_) + (head & cq_mask_);
+  *user_data = cqe->user_data;
+  *result = cqe->res;
+  __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+}  // namespace fletch
+
+#else  // FLETCH_HAS_IO_URING
+
+namespace fletch {
+
+IoUring* IoUring::Create(int entries) {
+  return NULL;
+}
+
+IoUring::~IoUring() {
+}
+
+bool IoUring::PollAdd(int fd, uint32 events, uint64 user_data) {
+  UNREACHABLE();
+  return false;
+}
+
+bool IoUring::PollRemove(uint64 user_data) {
+  UNREACHABLE();
+  return false;
+}
+
+void IoUring::Wait(int timeout) {
+  UNREACHABLE();
+}
+
+bool IoUring::NextCompletion(uint64* user_data, int32* result) {
+  UNREACHABLE();
+  return false;
+}
+
+}  // namespace fletch
+
+#endif  // FLETCH_HAS_IO_URING
+
+#endif  // defined(FLETCH_TARGET_OS_LINUX)
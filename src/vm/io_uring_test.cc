@@ -0,0 +1,65 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#if defined(FLETCH_TARGET_OS_LINUX)
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/io_uring.h"
+
+namespace fletch {
+
+TEST_CASE(IoUring_Poll) {
+  IoUring* ring = IoUring::Create(8);
+  // Not all kernels support io_uring.
+  if (ring == NULL) return;
+
+  int fds[2];
+  EXPECT_EQ(pipe(fds), 0);
+  EXPECT(ring->PollAdd(fds[0], POLLIN, 42));
+
+  uint64 user_data;
+  int32 result;
+  ring->Wait(0);
+  EXPECT(!ring->NextCompletion(&user_data, &result));
+
+  char byte = 0;
+  EXPECT_EQ(write(fds[1], &byte, 1), 1);
+  ring->Wait(-1);
+  EXPECT(ring->NextCompletion(&user_data, &result));
+  EXPECT_EQ(user_data, static_cast<uint64>(42));
+  EXPECT((result & POLLIN) != 0);
+
+  // Polls are one-shot. Cancel a fresh one.
+  EXPECT(ring->PollAdd(fds[1], 0, 43));
+  EXPECT(ring->PollRemove(43));
+  bool cancelled = false;
+  bool removed = false;
+  while (!cancelled || !removed) {
+    ring->Wait(-1);
+    while (ring->NextCompletion(&user_data, &result)) {
+      if (user_data == IoUring::kIgnoredUserData) {
+        EXPECT_EQ(result, 0);
+        removed = true;
+      } else {
+        EXPECT_EQ(user_data, static_cast<uint64>(43));
+        EXPECT_EQ(result, -ECANCELED);
+        cancelled = true;
+      }
+    }
+  }
+
+  close(fds[0]);
+  close(fds[1]);
+  delete ring;
+}
+
+}  // namespace fletch
+
+#endif  // defined(FLETCH_TARGET_OS_LINUX)
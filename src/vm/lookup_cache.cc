@@ -4,12 +4,17 @@
 
 #include "src/vm/lookup_cache.h"
 
+#include "src/shared/flags.h"
+
 namespace fletch {
 
 LookupCache::LookupCache()
-    : primary_(new Entry[kPrimarySize]),
-      secondary_(new Entry[kSecondarySize]) {
-  Clear();
+    : primary_(NULL),
+      secondary_(NULL),
+      primary_size_(0),
+      secondary_size_(0) {
+  memset(&statistics_, 0, sizeof(statistics_));
+  Resize(kPrimarySize);
 }
 
 LookupCache::~LookupCache() {
@@ -18,8 +23,44 @@ LookupCache::~LookupCache() {
 }
 
 void LookupCache::Clear() {
-  memset(primary_, 0, sizeof(Entry) * kPrimarySize);
-  memset(secondary_, 0, sizeof(Entry) * kSecondarySize);
+  memset(primary_, 0, sizeof(Entry) * primary_size_);
+  memset(secondary_, 0, sizeof(Entry) * secondary_size_);
+  // The misses right after clearing the cache say nothing about its size.
+  interval_misses_ = 0;
+  interval_lookups_ = 0;
+}
+
+bool LookupCache::RecordMiss(bool lookup) {
+  int threshold = Flags::lookup_cache_resize_threshold;
+  if (threshold <= 0 || primary_size_ >= kMaxPrimarySize) return false;
+
+  interval_misses_++;
+  if (lookup) interval_lookups_++;
+  if (interval_misses_ < kResizeInterval) return false;
+
+  // Misses that the secondary cache catches are conflicts in the primary
+  // cache. Misses in both mean that the entries are evicted before they
+  // are used again, so the cache is too small for the program.
+  bool grow = interval_lookups_ * 100 > interval_misses_ * threshold;
+  // The caller of a secondary hit still uses the entry, so growing waits
+  // for the next lookup.
+  if (grow && !lookup) return false;
+  interval_misses_ = 0;
+  interval_lookups_ = 0;
+  if (!grow) return false;
+  Resize(primary_size_ * 2);
+  return true;
+}
+
+void LookupCache::Resize(int primary_size) {
+  ASSERT(Utils::IsPowerOfTwo(primary_size));
+  delete[] primary_;
+  delete[] secondary_;
+  primary_size_ = primary_size;
+  secondary_size_ = kSecondarySize * (primary_size / kPrimarySize);
+  primary_ = new Entry[primary_size_];
+  secondary_ = new Entry[secondary_size_];
+  Clear();
 }
 
 }  // namespace fletch
@@ -17,6 +17,7 @@ class LookupCache {
  public:
   static const int kPrimarySize = 4096;
   static const int kSecondarySize = 2111;
+  static const int kMaxPrimarySize = 32768;
 
   struct Entry {
     Class* clazz;
@@ -25,22 +26,63 @@ class LookupCache {
     word tag;
   };
 
+  // Counters for the lookups that go through the cache, and for the vtable
+  // dispatch of compact programs, which bypasses it. Only updated with
+  // -Xlookup-cache-statistics, which also keeps processes in the C++
+  // interpreter: the generated interpreters probe the primary cache and the
+  // vtable without counting.
+  struct Statistics {
+    uword primary_hits;
+    uword secondary_hits;
+    uword lookups;
+    uword no_such_method;
+    uword vtable_hits;
+    uword vtable_no_such_method;
+  };
+
   LookupCache();
   ~LookupCache();
 
   Entry* primary() const { return primary_; }
   Entry* secondary() const { return secondary_; }
 
+  int primary_size() const { return primary_size_; }
+  uword primary_mask() const { return primary_size_ - 1; }
+
+  Statistics* statistics() { return &statistics_; }
+
   inline void DemotePrimary(Entry* primary);
 
   void Clear();
 
-  static inline uword ComputePrimaryIndex(Class* clazz, int selector);
-  static inline uword ComputeSecondaryIndex(Class* clazz, int selector);
+  // Records a miss in the primary cache, and whether the target had to
+  // be looked up in the class hierarchy. All interpreters handle primary
+  // misses in C++, so the resizing sees every miss, with or without the
+  // statistics. Returns true if the cache has
+  // been made larger, which clears it. Only lookups make the cache
+  // larger, so entries found in the secondary cache stay valid.
+  bool RecordMiss(bool lookup);
+
+  static inline uword ComputePrimaryIndex(Class* clazz,
+                                          int selector,
+                                          uword mask);
+  inline uword ComputeSecondaryIndex(Class* clazz, int selector) const;
 
  private:
-  Entry* const primary_;
-  Entry* const secondary_;
+  // The primary cache is checked after this many misses, and is made
+  // larger if too many of them also missed the secondary cache.
+  static const int kResizeInterval = 8192;
+
+  void Resize(int primary_size);
+
+  Entry* primary_;
+  Entry* secondary_;
+  int primary_size_;
+  int secondary_size_;
+
+  Statistics statistics_;
+  int interval_misses_;
+  int interval_lookups_;
 };
 
 inline void LookupCache::DemotePrimary(LookupCache::Entry* primary) {
@@ -50,16 +92,16 @@ inline void LookupCache::DemotePrimary(LookupCache::Entry* primary) {
   secondary()[index] = *primary;
 }
 
-uword LookupCache::ComputePrimaryIndex(Class* clazz, int selector) {
-  ASSERT(Utils::IsPowerOfTwo(kPrimarySize));
+uword LookupCache::ComputePrimaryIndex(Class* clazz, int selector, uword mask) {
+  ASSERT(Utils::IsPowerOfTwo(mask + 1));
   uword hash = reinterpret_cast<uword>(clazz) ^ selector;
-  return hash & (kPrimarySize - 1);
+  return hash & mask;
 }
 
-uword LookupCache::ComputeSecondaryIndex(Class* clazz, int selector) {
-  ASSERT(!Utils::IsPowerOfTwo(kSecondarySize));
+uword LookupCache::ComputeSecondaryIndex(Class* clazz, int selector) const {
+  ASSERT(!Utils::IsPowerOfTwo(secondary_size_));
   uword hash = reinterpret_cast<uword>(clazz) - selector;
-  return hash % kSecondarySize;
+  return hash % secondary_size_;
 }
 
 }  // namespace fletch
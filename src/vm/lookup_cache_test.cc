@@ -0,0 +1,52 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/lookup_cache.h"
+
+namespace fletch {
+
+// Records misses until the cache grows, giving up after [limit] of them.
+static int MissesUntilResize(LookupCache* cache, bool lookup, int limit) {
+  for (int i = 1; i <= limit; i++) {
+    if (cache->RecordMiss(lookup)) return i;
+  }
+  return -1;
+}
+
+TEST_CASE(LookupCacheResize) {
+  int size = LookupCache::kPrimarySize;
+  int max_size = LookupCache::kMaxPrimarySize;
+  LookupCache cache;
+  EXPECT_EQ(cache.primary_size(), size);
+  EXPECT_EQ(cache.primary_mask(), static_cast<uword>(size - 1));
+
+  // Conflicts caught by the secondary cache never grow the cache.
+  EXPECT_EQ(MissesUntilResize(&cache, false, 100000), -1);
+  EXPECT_EQ(cache.primary_size(), size);
+
+  // Clearing the cache restarts the interval, so the cache grows once a
+  // full interval of misses went all the way to the class hierarchy.
+  cache.Clear();
+  int interval = MissesUntilResize(&cache, true, 100000);
+  EXPECT_GT(interval, 0);
+  EXPECT_EQ(cache.primary_size(), 2 * size);
+  EXPECT_EQ(MissesUntilResize(&cache, true, interval), interval);
+  EXPECT_EQ(cache.primary_size(), 4 * size);
+
+  // Mostly secondary hits keep the size.
+  for (int i = 0; i < 4 * interval; i++) {
+    EXPECT(!cache.RecordMiss(i % 4 == 0));
+  }
+  EXPECT_EQ(cache.primary_size(), 4 * size);
+
+  // The cache stops growing at its maximum size.
+  MissesUntilResize(&cache, true, 100 * interval);
+  EXPECT_EQ(cache.primary_size(), max_size);
+  EXPECT_EQ(MissesUntilResize(&cache, true, 2 * interval), -1);
+}
+
+}  // namespace fletch
@@ -0,0 +1,112 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/mark_sweep.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "src/vm/object_memory.h"
+
+namespace fletch {
+
+MarkSweepCollector::MarkSweepCollector(Space* space)
+    : space_(space), filler_class_(NULL), live_bytes_(0) {
+  for (Chunk* chunk = space->first(); chunk != NULL; chunk = chunk->next()) {
+    // One bit for every word in the chunk.
+    int words = chunk->size() >> kPointerSizeLog2;
+    int length = (words + kBitsPerWord - 1) / kBitsPerWord;
+    ChunkMarks marks;
+    marks.base = chunk->base();
+    marks.limit = chunk->limit();
+    marks.bits = new uword[length];
+    memset(marks.bits, 0, length * kWordSize);
+    chunks_.push_back(marks);
+  }
+  std::sort(chunks_.begin(), chunks_.end());
+}
+
+MarkSweepCollector::~MarkSweepCollector() {
+  for (unsigned i = 0; i < chunks_.size(); i++) {
+    delete[] chunks_[i].bits;
+  }
+}
+
+MarkSweepCollector::ChunkMarks* MarkSweepCollector::MarksFor(uword address) {
+  int low = 0;
+  int high = chunks_.size() - 1;
+  while (low <= high) {
+    int middle = (low + high) / 2;
+    ChunkMarks* marks = &chunks_[middle];
+    if (address < marks->base) {
+      high = middle - 1;
+    } else if (address >= marks->limit) {
+      low = middle + 1;
+    } else {
+      return marks;
+    }
+  }
+  return NULL;
+}
+
+void MarkSweepCollector::VisitBlock(Object** start, Object** end) {
+  for (Object** p = start; p < end; p++) {
+    Object* object = *p;
+    if (!object->IsHeapObject()) continue;
+    uword address = HeapObject::cast(object)->address();
+    ChunkMarks* marks = MarksFor(address);
+    if (marks == NULL) continue;
+    uword index = (address - marks->base) >> kPointerSizeLog2;
+    uword* word = &marks->bits[index / kBitsPerWord];
+    uword mask = static_cast<uword>(1) << (index % kBitsPerWord);
+    if ((*word & mask) != 0) continue;
+    *word |= mask;
+    marking_stack_.push_back(HeapObject::cast(object));
+  }
+}
+
+bool MarkSweepCollector::ProcessMarkingStack(int budget) {
+  while (budget-- > 0 && !marking_stack_.empty()) {
+    HeapObject* object = marking_stack_.back();
+    marking_stack_.pop_back();
+    object->IteratePointers(this);
+  }
+  return marking_stack_.empty();
+}
+
+bool MarkSweepCollector::VisitMarkedObjects(HeapObjectVisitor* visitor) {
+  bool found_work = false;
+  while (!marking_stack_.empty()) {
+    HeapObject* object = marking_stack_.back();
+    marking_stack_.pop_back();
+    visitor->Visit(object);
+    found_work = true;
+  }
+  return found_work;
+}
+
+bool MarkSweepCollector::IsLive(HeapObject* object) {
+  uword address = object->address();
+  ChunkMarks* marks = MarksFor(address);
+  if (marks == NULL) return true;
+  uword index = (address - marks->base) >> kPointerSizeLog2;
+  uword mask = static_cast<uword>(1) << (index % kBitsPerWord);
+  return (marks->bits[index / kBitsPerWord] & mask) != 0;
+}
+
+void MarkSweepCollector::MakeFiller(uword address, int size) {
+  ASSERT(size >= ByteArray::kSize);
+  HeapObject* filler = HeapObject::FromAddress(address);
+  filler->set_class(filler_class_);
+  ByteArray::cast(filler)->set_length(size - ByteArray::kSize);
+}
+
+void MarkSweepCollector::Sweep(Class* filler_class) {
+  ASSERT(marking_stack_.empty());
+  filler_class_ = filler_class;
+  live_bytes_ = space_->Sweep(this);
+}
+
+}  // namespace fletch
@@ -0,0 +1,80 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_MARK_SWEEP_H_
+#define SRC_VM_MARK_SWEEP_H_
+
+#include <vector>
+
+#include "src/shared/globals.h"
+#include "src/vm/object.h"
+
+namespace fletch {
+
+class Space;
+
+// Collects a space without moving its objects. Marking is done in steps,
+// so it can be interleaved with other work, and the marks are kept in side
+// bitmaps so the objects themselves are never written. Sweeping replaces
+// dead objects by byte array fillers, which keeps the space iterable, and
+// frees the chunks that have no live objects left.
+//
+// Only the chunks the space has when the collector is created take part in
+// the collection. Objects in chunks added later are considered live.
+class MarkSweepCollector : public PointerVisitor, public SweepingVisitor {
+ public:
+  explicit MarkSweepCollector(Space* space);
+  virtual ~MarkSweepCollector();
+
+  // Marks the objects of the space that the block points to.
+  void VisitBlock(Object** start, Object** end);
+
+  // Classes are never in a space collected by mark-sweep.
+  void VisitClass(Object** p) { }
+
+  // Scans at most [budget] marked objects for pointers to more objects.
+  // Returns true when there is nothing left to scan.
+  bool ProcessMarkingStack(int budget);
+
+  // Hands the marked objects that have not been scanned to [visitor]
+  // instead of scanning them here. The visitor must pass their pointers on
+  // to this collector, possibly after updating them. Returns false if
+  // there was nothing to hand out.
+  bool VisitMarkedObjects(HeapObjectVisitor* visitor);
+
+  // Sweeps the space, using [filler_class] as the class of the fillers. All
+  // marking must be done.
+  void Sweep(Class* filler_class);
+
+  // Whether [object] survives the collection. Only valid once marking is
+  // done.
+  bool IsLive(HeapObject* object);
+
+  // The number of bytes in live objects, known after sweeping.
+  int live_bytes() const { return live_bytes_; }
+
+  void MakeFiller(uword address, int size);
+
+ private:
+  struct ChunkMarks {
+    uword base;
+    uword limit;
+    uword* bits;
+
+    bool operator<(const ChunkMarks& other) const { return base < other.base; }
+  };
+
+  // Returns the marks for the chunk holding [address], or NULL.
+  ChunkMarks* MarksFor(uword address);
+
+  Space* const space_;
+  std::vector<ChunkMarks> chunks_;  // Sorted by address.
+  std::vector<HeapObject*> marking_stack_;
+  Class* filler_class_;
+  int live_bytes_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_MARK_SWEEP_H_
@@ -5,6 +5,7 @@
 #include "src/vm/natives.h"
 
 #include <errno.h>
+#include <limits.h>
 #include <math.h>
 #include <stdlib.h>
 #include <sys/time.h>
@@ -17,6 +18,7 @@
 #include "src/shared/platform.h"
 
 #include "src/vm/event_handler.h"
+#include "src/vm/heap_census.h"
 #include "src/vm/interpreter.h"
 #include "src/vm/port.h"
 #include "src/vm/process.h"
@@ -812,7 +814,7 @@ NATIVE(ListIndexSet) {
   }
   Object* value = arguments[2];
   array->set(index, value);
-  process->RecordStore(array, value);
+  process->RecordStore(array, Array::kSize + index * kPointerSize, value);
   return value;
 }
 
@@ -829,6 +831,12 @@ NATIVE(ProcessSpawn) {
   Instance* entrypoint = Instance::cast(arguments[0]);
   Instance* closure = Instance::cast(arguments[1]);
   Object* argument = arguments[2];
+  Object* heap_limit = arguments[3];
+
+  if (!heap_limit->IsNull() &&
+      (!heap_limit->IsSmi() || Smi::cast(heap_limit)->value() <= 0)) {
+    return Failure::wrong_argument_type();
+  }
 
   if (!closure->IsImmutable()) {
     // TODO(kasperl): Return a proper failure.
@@ -852,6 +860,10 @@ NATIVE(ProcessSpawn) {
   // Spawn a new process and create a copy of the closure in the
   // new process' heap.
   Process* child = program->SpawnProcess();
+  if (heap_limit->IsSmi()) {
+    word limit = Utils::Minimum<word>(Smi::cast(heap_limit)->value(), INT_MAX);
+    child->SetHeapLimit(static_cast<int>(limit));
+  }
 
   // Set up the stack as a call of the entry with one argument: closure.
   child->SetupExecutionStack();
@@ -1056,8 +1068,11 @@ NATIVE(UriBase) {
 }
 
 NATIVE(SystemGetEventHandler) {
-  int fd = process->program()->event_handler()->GetEventHandler();
-  return process->ToInteger(fd);
+  Object* fd = arguments[0];
+  if (!fd->IsSmi()) return Failure::wrong_argument_type();
+  EventHandler* event_handler =
+      process->program()->EventHandlerForFd(Smi::cast(fd)->value());
+  return process->ToInteger(event_handler->GetEventHandler());
 }
 
 NATIVE(IsImmutable) {
@@ -1065,4 +1080,22 @@ NATIVE(IsImmutable) {
   return ToBool(process, o->IsImmutable());
 }
 
+// Only the calling process is stopped while the census is taken. The merged
+// part of the immutable heap is only changed while all processes are
+// stopped, so it can be walked too. Immutable objects that other processes
+// have allocated since the last immutable collection are left out.
+NATIVE(WriteHeapCensus) {
+  Object* path = arguments[0];
+  if (!path->IsString()) return Failure::wrong_argument_type();
+  Program* program = process->program();
+  HeapCensus census;
+  census.AddProcess(process);
+  census.AddSpace(program->immutable_heap()->heap()->space());
+  if (arguments[1] == program->true_object()) census.ComputeRetainedSizes();
+  char* chars = String::cast(path)->ToCString();
+  bool success = census.PrintJson(program, chars);
+  free(chars);
+  return ToBool(process, success);
+}
+
 }  // namespace fletch
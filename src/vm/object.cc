@@ -41,24 +41,28 @@ static void CopyBlock(Object** dst, Object** src, int byte_size) {
 int HeapObject::Size() {
   // Fast check for non-variable length types.
   ASSERT(forwarding_address() == NULL);
-  InstanceFormat format = raw_class()->instance_format();
+  return SizeForFormat(raw_class()->instance_format());
+}
+
+int HeapObject::SizeForFormat(InstanceFormat format) {
   if (!format.has_variable_part()) return format.fixed_size();
+  // The casts are unchecked, since checking them would read the class.
   int type = format.type();
   switch (type) {
     case InstanceFormat::STRING_TYPE:
-      return String::cast(this)->StringSize();
+      return reinterpret_cast<String*>(this)->StringSize();
     case InstanceFormat::ARRAY_TYPE:
-      return Array::cast(this)->ArraySize();
+      return reinterpret_cast<Array*>(this)->ArraySize();
     case InstanceFormat::BYTE_ARRAY_TYPE:
-      return ByteArray::cast(this)->ByteArraySize();
+      return reinterpret_cast<ByteArray*>(this)->ByteArraySize();
     case InstanceFormat::FUNCTION_TYPE:
-      return Function::cast(this)->FunctionSize();
+      return reinterpret_cast<Function*>(this)->FunctionSize();
     case InstanceFormat::STACK_TYPE:
-      return Stack::cast(this)->StackSize();
+      return reinterpret_cast<Stack*>(this)->StackSize();
     case InstanceFormat::DOUBLE_TYPE:
-      return Double::cast(this)->DoubleSize();
+      return reinterpret_cast<Double*>(this)->DoubleSize();
     case InstanceFormat::LARGE_INTEGER_TYPE:
-      return LargeInteger::cast(this)->LargeIntegerSize();
+      return reinterpret_cast<LargeInteger*>(this)->LargeIntegerSize();
   }
   UNREACHABLE();
   return 0;
@@ -118,19 +122,23 @@ void* Function::ComputeIntrinsic() {
   int length = bytecode_size();
   uint8* bytecodes = bytecode_address_for(0);
   void* result = NULL;
+  // Fused bytecodes only replace the first opcode of a pair.
+  Opcode first = length >= 1
+      ? Bytecode::UnfusedOpcode(static_cast<Opcode>(bytecodes[0]))
+      : kMethodEnd;
   if (length >= 4 &&
-      bytecodes[0] == kLoadLocal1 &&
+      first == kLoadLocal1 &&
       bytecodes[1] == kLoadField &&
       bytecodes[3] == kReturn) {
     result = reinterpret_cast<void*>(&Intrinsic_GetField);
   } else if (length >= 4 &&
-             bytecodes[0] == kLoadLocal2 &&
+             first == kLoadLocal2 &&
              bytecodes[1] == kLoadLocal2 &&
              bytecodes[2] == kIdenticalNonNumeric &&
              bytecodes[3] == kReturn) {
     result = reinterpret_cast<void*>(&Intrinsic_ObjectEquals);
   } else if (length >= 5 &&
-             bytecodes[0] == kLoadLocal2 &&
+             first == kLoadLocal2 &&
              bytecodes[1] == kLoadLocal2 &&
              bytecodes[2] == kStoreField &&
              bytecodes[4] == kReturn) {
@@ -513,6 +521,39 @@ HeapObject* HeapObject::CloneInToSpace(Space* to) {
   return target;
 }
 
+HeapObject* HeapObject::CloneInToSpaceConcurrently(Space* to, bool* copied) {
+  ASSERT(!to->Includes(this->address()));
+  // While an object is being copied, its class field holds a marker that is
+  // neither a class nor a forwarding address.
+  Object* const busy = reinterpret_cast<Object*>(kTag);
+  Object** header = reinterpret_cast<Object**>(address() + kClassOffset);
+  Object* klass = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+  while (true) {
+    if (klass == busy) {
+      klass = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+    } else if (klass->IsSmi()) {
+      *copied = false;
+      return HeapObject::FromAddress(reinterpret_cast<word>(klass));
+    } else if (__atomic_compare_exchange_n(header, &klass, busy, false,
+                                           __ATOMIC_ACQ_REL,
+                                           __ATOMIC_ACQUIRE)) {
+      break;
+    }
+  }
+
+  int object_size =
+      SizeForFormat(reinterpret_cast<Class*>(klass)->instance_format());
+  HeapObject* target = HeapObject::FromAddress(to->Allocate(object_size));
+  CopyBlock(reinterpret_cast<Object**>(target->address()),
+            reinterpret_cast<Object**>(address()),
+            object_size);
+  target->set_class(reinterpret_cast<Class*>(klass));
+  Object* forward = reinterpret_cast<Smi*>(target->address());
+  __atomic_store_n(header, forward, __ATOMIC_RELEASE);
+  *copied = true;
+  return target;
+}
+
 Function* Function::UnfoldInToSpace(Space* to, int number_of_literals) {
   ASSERT(forwarding_address() == NULL);
   int current_object_size = Size();
@@ -301,6 +301,12 @@ class HeapObject: public Object {
   // Uses a forwarding_address to ensure only one clone.
   HeapObject* CloneInToSpace(Space* to);
 
+  // Like [CloneInToSpace], but several threads can clone the same object
+  // at the same time. The thread that claims the object copies it, and
+  // the others wait for the forwarding address. [copied] tells whether this
+  // thread made the copy.
+  HeapObject* CloneInToSpaceConcurrently(Space* to, bool* copied);
+
   // Sizing.
   int FixedSize();
   int Size();
@@ -329,11 +335,13 @@ class HeapObject: public Object {
   void RawPrint(const char* title);
   // Returns the class field without checks.
   inline Class* raw_class();
+  // Returns the size of the object, given its instance format. Does not look
+  // at the class field, which may be in use for forwarding.
+  int SizeForFormat(InstanceFormat format);
 
   friend class Heap;
   friend class Program;
   friend class SnapshotWriter;
-  friend class StoreBuffer;
 
  private:
   DISALLOW_IMPLICIT_CONSTRUCTORS(HeapObject);
@@ -991,6 +999,15 @@ class HeapObjectVisitor {
   virtual void Visit(HeapObject* object) = 0;
 };
 
+// Class for sweeping a space: tells which objects are live, and fills in
+// the memory of the dead ones.
+class SweepingVisitor {
+ public:
+  virtual ~SweepingVisitor() {}
+  virtual bool IsLive(HeapObject* object) = 0;
+  virtual void MakeFiller(uword address, int size) = 0;
+};
+
 // Class for visiting pointers inside heap objects.
 //
 // NOTE: This class does not protect against raw bytecode pointers on the stack.
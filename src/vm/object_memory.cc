@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "src/shared/assert.h"
 #include "src/shared/platform.h"
@@ -13,7 +14,7 @@
 
 #include "src/vm/heap.h"
 #include "src/vm/object.h"
-#include "src/vm/storebuffer.h"
+#include "src/vm/remembered_set.h"
 #include "src/vm/stack_walker.h"
 
 namespace fletch {
@@ -24,17 +25,21 @@ static bool HasSentinelAt(uword address) {
   return *reinterpret_cast<Object**>(address) == chunk_end_sentinel();
 }
 
-Chunk::~Chunk() {
-  free(reinterpret_cast<void*>(base()));
-}
-
 Space::Space(int maximum_initial_size)
     : first_(NULL),
       last_(NULL),
       used_(0),
       top_(0),
       limit_(0),
-      no_allocation_nesting_(0) {
+      allocation_budget_(0),
+      allocation_limit_(kNoAllocationLimit),
+      limit_request_(0),
+      bytes_until_sample_(kNoSample),
+      sample_base_(0),
+      sample_pending_(false),
+      no_allocation_nesting_(0),
+      scan_chunk_(NULL),
+      scan_current_(0) {
   if (maximum_initial_size > 0) {
     int size = Utils::Minimum(maximum_initial_size, kDefaultMaximumChunkSize);
     Chunk* chunk = ObjectMemory::AllocateChunk(this, size);
@@ -72,6 +77,14 @@ uword Space::TryAllocate(int size) {
   }
 
   if (!is_empty()) {
+    // The limit may have been lowered to take an allocation sample, in
+    // which case the chunk is not full yet.
+    bool lowered = limit_ != last()->limit();
+    limit_ = last()->limit();
+    if (!in_no_allocation_failure_scope() && ReachesSample(size)) return 0;
+    if (lowered) return TryAllocate(size);
+
+    RebaseSample();
     // Update the accounting.
     used_ += top() - last()->base();
     // Make the last chunk consistent with a sentinel.
@@ -82,23 +95,33 @@ uword Space::TryAllocate(int size) {
 }
 
 uword Space::AllocateInNewChunk(int size) {
+  if (!in_no_allocation_failure_scope() && ExceedsAllocationLimit(size)) {
+    return 0;
+  }
+
   // Allocate new chunk that is big enough to fit the object.
   int default_chunk_size = DefaultChunkSize(Used());
   int chunk_size = size >= default_chunk_size
       ? (size + kPointerSize)  // Make sure there is room for sentinel.
       : default_chunk_size;
+  if (allocation_limit_ != kNoAllocationLimit) {
+    int room = Utils::Maximum(allocation_limit_ - Used(), size);
+    chunk_size = Utils::Minimum(chunk_size, room + kPointerSize);
+  }
 
   Chunk* chunk = ObjectMemory::AllocateChunk(this, chunk_size);
   if (chunk != NULL) {
     allocation_budget_ -= chunk->size();
     top_ = chunk->base();
     limit_ = chunk->limit();
+    sample_base_ = top_;
 
     // Link it into the space.
     Append(chunk);
 
     // Allocate.
     uword result = TryAllocate(size);
+    LowerLimitForSample();
     if (result != 0) return result;
   }
 
@@ -111,10 +134,41 @@ uword Space::Allocate(int size) {
   ASSERT(Utils::IsAligned(size, kPointerSize));
   uword result = TryAllocate(size);
   if (result != 0) return result;
-  if (!in_no_allocation_failure_scope() && needs_garbage_collection()) return 0;
+  if (!in_no_allocation_failure_scope() &&
+      (sample_pending_ || needs_garbage_collection())) {
+    return 0;
+  }
   return AllocateInNewChunk(size);
 }
 
+uword Space::AllocateLarge(int size) {
+  ASSERT(size >= HeapObject::kSize);
+  ASSERT(Utils::IsAligned(size, kPointerSize));
+  if (!in_no_allocation_failure_scope()) {
+    if (needs_garbage_collection()) return 0;
+    if (sample_pending_ || ReachesSample(size)) return 0;
+    if (ExceedsAllocationLimit(size)) return 0;
+  }
+
+  if (!is_empty()) {
+    // Close the current chunk, so nothing else is allocated next to the
+    // object.
+    RebaseSample();
+    used_ += top() - last()->base();
+    Flush();
+  }
+
+  // Make sure there is room for sentinel.
+  Chunk* chunk = ObjectMemory::AllocateChunk(this, size + kPointerSize);
+  if (chunk == NULL) FATAL1("Failed to allocate memory of size %d\n", size);
+  allocation_budget_ -= chunk->size();
+  top_ = chunk->base();
+  limit_ = chunk->limit();
+  sample_base_ = top_;
+  Append(chunk);
+  return TryAllocate(size);
+}
+
 void Space::TryDealloc(uword location, int size) {
   if (top_ == location) top_ -= size;
 }
@@ -128,17 +182,64 @@ void Space::SetAllocationBudget(int new_budget) {
   allocation_budget_ = new_budget;
 }
 
+void Space::SetAllocationLimit(int limit) {
+  allocation_limit_ = limit;
+  limit_request_ = 0;
+}
+
+bool Space::ExceedsAllocationLimit(int size) {
+  if (allocation_limit_ == kNoAllocationLimit) return false;
+  if (Used() + size <= allocation_limit_) return false;
+  limit_request_ = size;
+  return true;
+}
+
+void Space::ScheduleSample(int bytes) {
+  ASSERT(bytes > 0);
+  if (!is_empty()) limit_ = last()->limit();
+  bytes_until_sample_ = bytes;
+  sample_base_ = top_;
+  LowerLimitForSample();
+}
+
+void Space::RebaseSample() {
+  if (bytes_until_sample_ == kNoSample) return;
+  bytes_until_sample_ = BytesUntilSample();
+  sample_base_ = top_;
+}
+
+void Space::LowerLimitForSample() {
+  if (bytes_until_sample_ == kNoSample || is_empty()) return;
+  // The sample point may already have been passed by an object that
+  // started a new chunk. Keep room for the chunk end sentinel either way.
+  uword point = Utils::Maximum(sample_base_ + bytes_until_sample_,
+                               top_ + kPointerSize);
+  if (point < limit_) limit_ = point;
+}
+
+bool Space::ReachesSample(int size) {
+  if (bytes_until_sample_ == kNoSample || size < BytesUntilSample()) {
+    return false;
+  }
+  bytes_until_sample_ = kNoSample;
+  sample_pending_ = true;
+  return true;
+}
+
 void Space::PrependSpace(Space* space) {
   bool was_empty = is_empty();
 
-  if (space->is_empty()) return;
+  if (space->is_empty()) {
+    delete space;
+    return;
+  }
 
   space->Flush();
 
   Chunk* first = space->first();
   Chunk* chunk = first;
   while (chunk != NULL) {
-    ObjectMemory::SetSpaceForPages(chunk->base(), chunk->limit(), this);
+    ObjectMemory::SetSpaceForPages(chunk->base(), chunk->limit(), this, chunk);
     chunk->set_owner(this);
     chunk = chunk->next();
   }
@@ -149,7 +250,9 @@ void Space::PrependSpace(Space* space) {
   if (was_empty) {
     last_ = space->last();
     top_ = space->top_;
-    limit_ = space->limit_;
+    limit_ = space->last()->limit();
+    sample_base_ = top_;
+    LowerLimitForSample();
   }
 
   // NOTE: The destructor of [Space] will use some of the fields, so we just
@@ -202,36 +305,141 @@ void Space::CompleteScavenge(PointerVisitor* visitor) {
   }
 }
 
-void Space::CompleteScavengeMutable(PointerVisitor* visitor,
-                                    Space* program_space,
-                                    StoreBuffer* store_buffer) {
-  ASSERT(store_buffer->is_empty());
-
-  Flush();
+void Space::StartScavenge() {
+  if (is_empty()) {
+    scan_chunk_ = NULL;
+    scan_current_ = 0;
+  } else {
+    scan_chunk_ = last();
+    scan_current_ = top();
+  }
+}
 
-  // NOTE: This finder is only called on objects which have been forwarded and
-  // whos fields have been forwarded.
-  FindImmutablePointerVisitor finder(this, program_space);
+bool Space::CompleteScavengeGenerational(PointerVisitor* visitor,
+                                         CardMarkingVisitor* marker) {
+  if (is_empty()) return false;
+  if (scan_chunk_ == NULL) {
+    scan_chunk_ = first();
+    scan_current_ = first()->base();
+  }
 
-  for (Chunk* chunk = first(); chunk != NULL; chunk = chunk->next()) {
-    uword current = chunk->base();
-    // TODO(kasperl): I don't like the repeated checks to see if p is
-    // the last chunk. Can't we just make sure to write the sentinel
-    // whenever we've copied over an object, so this check becomes
-    // simpler like in IterateObjects?
+  Flush();
+  bool found_work = false;
+  while (true) {
+    Chunk* chunk = scan_chunk_;
+    uword current = scan_current_;
+    // Visiting an object can copy more objects into this space, so the
+    // last chunk and its top must be read again for every object.
     while ((chunk == last()) ? (current < top()) : !HasSentinelAt(current)) {
       HeapObject* object = HeapObject::FromAddress(current);
       object->IteratePointers(visitor);
+      marker->MarkCards(chunk, object);
+      current += object->Size();
+      found_work = true;
+    }
+    if (chunk == last()) {
+      scan_current_ = current;
+      return found_work;
+    }
+    scan_chunk_ = chunk->next();
+    scan_current_ = scan_chunk_->base();
+  }
+}
+
+void Space::VisitDirtyCards(PointerVisitor* visitor,
+                            CardMarkingVisitor* marker) {
+  if (is_empty()) return;
+  Flush();
 
-      // We build up a new StoreBuffer, containing all mutable heap objects
-      // pointing to the immutable space.
-      if (finder.ContainsImmutablePointer(object)) {
-        store_buffer->Insert(object);
+  // Visiting the pointers can allocate in this space, so remember where
+  // the objects to visit end.
+  Chunk* last_chunk = last();
+  uword end = top();
+  DirtyCardVisitor dirty_cards(visitor, marker);
+  std::vector<uint8> copy;
+  for (Chunk* chunk = first(); chunk != NULL; chunk = chunk->next()) {
+    bool is_last = (chunk == last_chunk);
+    if (chunk->HasDirtyCards()) {
+      const uint8* cards = chunk->cards();
+      if (marker != NULL) {
+        copy.assign(cards, cards + chunk->NumberOfCards());
+        cards = &copy[0];
+        chunk->ClearCards(chunk->base(), chunk->limit());
+      }
+      dirty_cards.set_chunk(chunk, cards);
+      uword current = chunk->base();
+      while (is_last ? (current < end) : !HasSentinelAt(current)) {
+        HeapObject* object = HeapObject::FromAddress(current);
+        int size = object->Size();
+        if (dirty_cards.HasDirtyCards(current, current + size)) {
+          object->IteratePointers(&dirty_cards);
+        }
+        current += size;
       }
+    }
+    if (is_last) break;
+  }
+}
 
-      current += object->Size();
+int Space::Sweep(SweepingVisitor* visitor) {
+  Flush();
+  int live_bytes = 0;
+  used_ = 0;
+  Chunk* previous = NULL;
+  uword previous_top = 0;
+  Chunk* chunk = first();
+  while (chunk != NULL) {
+    Chunk* next = chunk->next();
+    bool is_last = (chunk == last());
+    uword current = chunk->base();
+    uword dead_start = 0;
+    bool has_live_objects = false;
+    while (is_last ? (current < top()) : !HasSentinelAt(current)) {
+      HeapObject* object = HeapObject::FromAddress(current);
+      int size = object->Size();
+      if (visitor->IsLive(object)) {
+        if (dead_start != 0) {
+          visitor->MakeFiller(dead_start, current - dead_start);
+          dead_start = 0;
+        }
+        has_live_objects = true;
+        live_bytes += size;
+      } else if (dead_start == 0) {
+        dead_start = current;
+      }
+      current += size;
     }
+    if (dead_start != 0) visitor->MakeFiller(dead_start, current - dead_start);
+
+    if (has_live_objects) {
+      if (!is_last) used_ += current - chunk->base();
+      previous = chunk;
+      previous_top = current;
+    } else {
+      if (previous == NULL) {
+        first_ = next;
+      } else {
+        previous->set_next(next);
+      }
+      if (is_last) {
+        // Continue allocating where the previous chunk ends. Its objects
+        // are no longer accounted for in [used_].
+        last_ = previous;
+        RebaseSample();
+        if (previous == NULL) {
+          top_ = limit_ = 0;
+        } else {
+          used_ -= previous_top - previous->base();
+          top_ = previous_top;
+          limit_ = previous->limit();
+        }
+        sample_base_ = top_;
+      }
+      ObjectMemory::FreeChunk(chunk);
+    }
+    chunk = next;
   }
+  return live_bytes;
 }
 
 void Space::CompleteTransformations(PointerVisitor* visitor, Process* process) {
@@ -280,6 +488,7 @@ void PageDirectory::Delete() {
 }
 
 Mutex* ObjectMemory::mutex_;
+ChunkCache* ObjectMemory::chunk_cache_;
 #ifdef FLETCH32
 PageDirectory ObjectMemory::page_directory_;
 #else
@@ -289,6 +498,7 @@ PageDirectory* ObjectMemory::page_directories_[1 << 13];
 
 void ObjectMemory::Setup() {
   mutex_ = Platform::CreateMutex();
+  chunk_cache_ = new ChunkCache();
 #ifdef FLETCH32
   page_directory_.Clear();
 #else
@@ -308,9 +518,28 @@ void ObjectMemory::TearDown() {
     delete directory;
   }
 #endif
+  delete chunk_cache_;
   delete mutex_;
 }
 
+void Chunk::MarkCards(uword start, uword end) {
+  ASSERT(Includes(start) && end > start && end <= limit());
+  int first = (start - base_) >> kCardBits;
+  int last = (end - 1 - base_) >> kCardBits;
+  memset(cards_ + first, 1, last - first + 1);
+}
+
+void Chunk::ClearCards(uword start, uword end) {
+  ASSERT(Includes(start) && end > start && end <= limit());
+  int first = (start - base_) >> kCardBits;
+  int last = (end - 1 - base_) >> kCardBits;
+  memset(cards_ + first, 0, last - first + 1);
+}
+
+bool Chunk::HasDirtyCards() const {
+  return memchr(cards_, 1, NumberOfCards()) != NULL;
+}
+
 #ifdef DEBUG
 void Chunk::Scramble() {
   void* p = reinterpret_cast<void*>(base());
@@ -318,26 +547,94 @@ void Chunk::Scramble() {
 }
 #endif
 
+ChunkCache::ChunkCache()
+    : hits_(0),
+      misses_(0),
+      cached_size_(0),
+      released_size_(0),
+      next_release_(0) {
+}
+
+ChunkCache::~ChunkCache() {
+  for (int i = 0; i < kNumberOfClasses; i++) {
+    int size = (i + 1) * kPageSize;
+    for (unsigned j = 0; j < classes_[i].size(); j++) {
+      Platform::FreePages(reinterpret_cast<void*>(classes_[i][j].base), size);
+    }
+  }
+}
+
+uword ChunkCache::Take(int size, int* cached_size) {
+  int pages = size / kPageSize;
+  // Chunks this large are never cached, so they do not count as misses.
+  if (pages > kNumberOfClasses) return 0;
+  int max_pages = pages + pages / 4;
+  if (max_pages > kNumberOfClasses) max_pages = kNumberOfClasses;
+  for (int i = pages; i <= max_pages; i++) {
+    std::vector<Entry>* entries = &classes_[i - 1];
+    if (entries->empty()) continue;
+    // Take the most recently freed chunk. It is the least likely to have
+    // been released.
+    Entry entry = entries->back();
+    entries->pop_back();
+    *cached_size = i * kPageSize;
+    cached_size_ -= *cached_size;
+    if (entry.released) released_size_ -= *cached_size;
+    hits_++;
+    return entry.base;
+  }
+  misses_++;
+  return 0;
+}
+
+bool ChunkCache::Put(uword base, int size, uint64 now) {
+  if (size > kMaximumChunkSize) return false;
+  if (cached_size_ + size > kMaximumCachedSize) return false;
+  Entry entry = { base, now, false };
+  classes_[size / kPageSize - 1].push_back(entry);
+  cached_size_ += size;
+  return true;
+}
+
+void ChunkCache::ReleaseIdleChunks(uint64 now) {
+  if (now < next_release_) return;
+  next_release_ = now + kReleaseDelay / 4;
+  for (int i = 0; i < kNumberOfClasses; i++) {
+    int size = (i + 1) * kPageSize;
+    std::vector<Entry>* entries = &classes_[i];
+    for (unsigned j = 0; j < entries->size(); j++) {
+      Entry* entry = &(*entries)[j];
+      if (entry->freed_at + kReleaseDelay > now) break;
+      if (entry->released) continue;
+      Platform::ReleasePages(reinterpret_cast<void*>(entry->base), size);
+      entry->released = true;
+      released_size_ += size;
+    }
+  }
+}
+
 Chunk* ObjectMemory::AllocateChunk(Space* owner, int size) {
   ASSERT(owner != NULL);
 
   size = Utils::RoundUp(size, kPageSize);
-  void* memory;
-#ifdef ANDROID
-  // posix_memalign doesn't exist on Android. We fallback to
-  // memalign.
-  memory = memalign(kPageSize, size);
-  if (memory == NULL) return NULL;
-#else
-  if (posix_memalign(&memory, kPageSize, size) != 0) return NULL;
-#endif
+  uword base;
+  {
+    ScopedLock locker(mutex_);
+    int cached_size;
+    base = chunk_cache_->Take(size, &cached_size);
+    if (base != 0) size = cached_size;
+  }
+  if (base == 0) {
+    void* memory = Platform::AllocatePages(size);
+    if (memory == NULL) return NULL;
+    base = reinterpret_cast<uword>(memory);
+  }
 
-  uword base = reinterpret_cast<uword>(memory);
   Chunk* chunk = new Chunk(owner, base, size);
 #ifdef DEBUG
   chunk->Scramble();
 #endif
-  SetSpaceForPages(chunk->base(), chunk->limit(), owner);
+  SetSpaceForPages(chunk->base(), chunk->limit(), owner, chunk);
   return chunk;
 }
 
@@ -345,8 +642,33 @@ void ObjectMemory::FreeChunk(Chunk* chunk) {
 #ifdef DEBUG
   chunk->Scramble();
 #endif
-  SetSpaceForPages(chunk->base(), chunk->limit(), NULL);
+  SetSpaceForPages(chunk->base(), chunk->limit(), NULL, NULL);
+  uword base = chunk->base();
+  int size = chunk->size();
   delete chunk;
+
+  bool cached;
+  {
+    ScopedLock locker(mutex_);
+    uint64 now = Platform::GetMicroseconds();
+    cached = chunk_cache_->Put(base, size, now);
+    chunk_cache_->ReleaseIdleChunks(now);
+  }
+  if (!cached) Platform::FreePages(reinterpret_cast<void*>(base), size);
+}
+
+void ObjectMemory::PrintStatistics() {
+  ScopedLock locker(mutex_);
+  int hits = chunk_cache_->hits();
+  int total = hits + chunk_cache_->misses();
+  Print::Out("Chunk cache: %d of %d chunks reused (%d%%), %d bytes cached, "
+             "%d bytes released, resident memory %d KB\n",
+             hits,
+             total,
+             (total == 0) ? 0 : static_cast<int>(100LL * hits / total),
+             chunk_cache_->cached_size(),
+             chunk_cache_->released_size(),
+             static_cast<int>(Platform::GetResidentMemory() / KB));
 }
 
 bool ObjectMemory::IsAddressInSpace(uword address, const Space* space) {
@@ -356,6 +678,13 @@ bool ObjectMemory::IsAddressInSpace(uword address, const Space* space) {
       : false;
 }
 
+Chunk* ObjectMemory::ChunkFor(uword address) {
+  PageTable* table = GetPageTable(address);
+  return (table != NULL)
+      ? table->GetChunk((address >> 12) & 0x3ff)
+      : NULL;
+}
+
 PageTable* ObjectMemory::GetPageTable(uword address) {
 #ifdef FLETCH32
   return page_directory_.Get(address >> 22);
@@ -380,7 +709,10 @@ void ObjectMemory::SetPageTable(uword address, PageTable* table) {
 #endif
 }
 
-void ObjectMemory::SetSpaceForPages(uword base, uword limit, Space* space) {
+void ObjectMemory::SetSpaceForPages(uword base,
+                                    uword limit,
+                                    Space* space,
+                                    Chunk* chunk) {
   ASSERT(Utils::IsAligned(base, kPageSize));
   ASSERT(Utils::IsAligned(limit, kPageSize));
   for (uword address = base; address < limit; address += kPageSize) {
@@ -395,7 +727,7 @@ void ObjectMemory::SetSpaceForPages(uword base, uword limit, Space* space) {
         SetPageTable(address, table = new PageTable(address & ~0x3fffff));
       }
     }
-    table->Set((address >> 12) & 0x3ff, space);
+    table->Set((address >> 12) & 0x3ff, space, chunk);
   }
 }
 
@@ -5,6 +5,8 @@
 #ifndef SRC_VM_OBJECT_MEMORY_H_
 #define SRC_VM_OBJECT_MEMORY_H_
 
+#include <vector>
+
 #include "src/shared/globals.h"
 #include "src/shared/platform.h"
 #include "src/shared/utils.h"
@@ -15,9 +17,10 @@ class Heap;
 class HeapObject;
 class HeapObjectVisitor;
 class PointerVisitor;
+class CardMarkingVisitor;
 class Process;
 class Space;
-class StoreBuffer;
+class SweepingVisitor;
 
 const int kPageSize = 4 * KB;
 
@@ -44,6 +47,31 @@ class Chunk {
     return (address >= base()) && (address < limit());
   }
 
+  // Card marking. Every kCardSize bytes of the chunk have a card, which is
+  // dirty if the slots in them may hold pointers a process heap needs to
+  // remember. See src/vm/remembered_set.h.
+  static const int kCardBits = 9;
+  static const int kCardSize = 1 << kCardBits;
+
+  int NumberOfCards() const { return size() >> kCardBits; }
+  const uint8* cards() const { return cards_; }
+
+  void MarkCard(uword address) {
+    ASSERT(Includes(address));
+    cards_[(address - base_) >> kCardBits] = 1;
+  }
+
+  bool IsCardDirty(uword address) const {
+    ASSERT(Includes(address));
+    return cards_[(address - base_) >> kCardBits] != 0;
+  }
+
+  // Marks or clears the cards of the bytes in [start, end).
+  void MarkCards(uword start, uword end);
+  void ClearCards(uword start, uword end);
+
+  bool HasDirtyCards() const;
+
 #ifdef DEBUG
   // Fill the space with garbage.
   void Scramble();
@@ -53,13 +81,17 @@ class Chunk {
   Space* owner_;
   const uword base_;
   const uword limit_;
+  uint8* const cards_;
 
   Chunk* next_;
 
   Chunk(Space* owner, uword base, uword size)
-      : owner_(owner), base_(base), limit_(base + size) { }
+      : owner_(owner),
+        base_(base),
+        limit_(base + size),
+        cards_(new uint8[size >> kCardBits]()) { }
 
-  ~Chunk();
+  ~Chunk() { delete[] cards_; }
 
   void set_next(Chunk* value) { next_ = value; }
   void set_owner(Space* value) { owner_ = value; }
@@ -74,6 +106,7 @@ class Space {
  public:
   static const int kDefaultMinimumChunkSize = 4 * KB;
   static const int kDefaultMaximumChunkSize = 256 * KB;
+  static const int kNoAllocationLimit = -1;
 
   explicit Space(int maximum_initial_size = 0);
 
@@ -82,6 +115,10 @@ class Space {
   // Allocate raw object.
   uword Allocate(int size);
 
+  // Allocate raw object in a chunk of its own, so the chunk can be freed
+  // as soon as the object dies. Used for large objects.
+  uword AllocateLarge(int size);
+
   // Rewind allocation top by size bytes if location is equal to current
   // allocation top.
   void TryDealloc(uword location, int size);
@@ -101,13 +138,33 @@ class Space {
 
   // Scavenge loop.
   void CompleteScavenge(PointerVisitor* visitor);
-  void CompleteScavengeMutable(PointerVisitor* visitor,
-                               Space* program_space,
-                               StoreBuffer* store_buffer);
+
+  // Generational scavenge support. A scavenge can copy objects into more
+  // than one space, so each space remembers how far it has been scanned.
+  // [StartScavenge] marks the current allocation top. Each call to
+  // [CompleteScavengeGenerational] visits the objects allocated past the
+  // mark, lets [marker] mark the cards of the copied objects and moves the
+  // mark along. Returns false if there was nothing to visit.
+  void StartScavenge();
+  bool CompleteScavengeGenerational(PointerVisitor* visitor,
+                                    CardMarkingVisitor* marker);
+
+  // Visits the pointers in the dirty cards of this space. Only the objects
+  // allocated before the call are visited. If [marker] is given, the cards
+  // are cleaned and [marker] marks them again if the visited pointers still
+  // need to be remembered.
+  void VisitDirtyCards(PointerVisitor* visitor,
+                       CardMarkingVisitor* marker = NULL);
 
   // Schema change support.
   void CompleteTransformations(PointerVisitor* visitor, Process* process);
 
+  // Mark-sweep support. Replaces every run of dead objects by a single
+  // filler and frees the chunks without live objects. If the last chunk is
+  // freed, allocation continues in the chunk before it. Returns the number
+  // of bytes in live objects.
+  int Sweep(SweepingVisitor* visitor);
+
   // Returns true if the address is inside this space.
   inline bool Includes(uword address) const;
 
@@ -117,7 +174,28 @@ class Space {
   void SetAllocationBudget(int new_budget);
 
   // Tells whether garbage collection is needed.
-  bool needs_garbage_collection() { return allocation_budget_ <= 0; }
+  bool needs_garbage_collection() {
+    return allocation_budget_ <= 0 || limit_request_ != 0;
+  }
+
+  // Allocation limit. An allocation that would take [Used] past [limit]
+  // fails as if the space needed a garbage collection, and its size is
+  // kept in [limit_request] until the limit is set again. Only the slow
+  // path checks the limit. New chunks are made no larger than the room
+  // that is left, so the space stays within a page of the limit.
+  void SetAllocationLimit(int limit);
+  int limit_request() const { return limit_request_; }
+  void ClearLimitRequest() { limit_request_ = 0; }
+
+  // Allocation sampling. Takes a sample once [bytes] more bytes have been
+  // allocated: the allocation that gets there fails as if the space needed
+  // a garbage collection, and the sample stays pending until the owner of
+  // the space has recorded it and cleared it. The limit of the allocation
+  // fast path is lowered to the sample point, so only the slow path checks
+  // for samples.
+  void ScheduleSample(int bytes);
+  bool sample_pending() const { return sample_pending_; }
+  void ClearSamplePending() { sample_pending_ = false; }
 
   bool in_no_allocation_failure_scope() { return no_allocation_nesting_ != 0; }
 
@@ -129,7 +207,7 @@ class Space {
   }
 
   // Takes all chunks inside [space] and prepends it to this space.
-  // The given [space] will be deleted.
+  // The given [space] will be deleted, even if it is empty.
   void PrependSpace(Space* space);
 
   bool is_empty() const { return first_ == NULL; }
@@ -144,10 +222,24 @@ class Space {
   }
 
  private:
+  friend class MarkSweepCollector;
   friend class NoAllocationFailureScope;
 
+  static const int kNoSample = -1;
+
   uword TryAllocate(int size);
   uword AllocateInNewChunk(int size);
+  bool ExceedsAllocationLimit(int size);
+
+  int BytesUntilSample() const {
+    return bytes_until_sample_ - static_cast<int>(top_ - sample_base_);
+  }
+
+  // Makes the allocation top the point the sample distance is counted
+  // from. Called before the top moves to another chunk.
+  void RebaseSample();
+  void LowerLimitForSample();
+  bool ReachesSample(int size);
 
   void Append(Chunk* chunk);
 
@@ -164,7 +256,14 @@ class Space {
   uword top_;  // Allocation top in last chunk.
   uword limit_;  // Allocation limit in last chunk.
   int allocation_budget_;  // Budget before needing a GC.
+  int allocation_limit_;  // Limit of [Used], or kNoAllocationLimit.
+  int limit_request_;  // Size of the allocation that hit the limit.
+  int bytes_until_sample_;  // Counted from [sample_base_], or kNoSample.
+  uword sample_base_;
+  bool sample_pending_;
   int no_allocation_nesting_;
+  Chunk* scan_chunk_;  // Scavenge scan mark, NULL for the first chunk.
+  uword scan_current_;
 };
 
 class NoAllocationFailureScope {
@@ -185,15 +284,22 @@ class PageTable {
  public:
   explicit PageTable(uword base) : base_(base) {
     memset(spaces_, 0, kPointerSize * ARRAY_SIZE(spaces_));
+    memset(chunks_, 0, kPointerSize * ARRAY_SIZE(chunks_));
   }
 
   uword base() const { return base_; }
 
   Space* Get(int index) const { return spaces_[index]; }
-  void Set(int index, Space* space) { spaces_[index] = space; }
+  Chunk* GetChunk(int index) const { return chunks_[index]; }
+
+  void Set(int index, Space* space, Chunk* chunk) {
+    spaces_[index] = space;
+    chunks_[index] = chunk;
+  }
 
  private:
   Space* spaces_[1 << 10];
+  Chunk* chunks_[1 << 10];
   uword base_;
 };
 
@@ -213,17 +319,74 @@ class PageDirectory {
 #endif
 };
 
+// Keeps the memory of freed chunks, so the next scavenge can reuse it
+// instead of mapping fresh memory. There is a size class for every number
+// of pages up to [kMaximumChunkSize]. Chunks that have been in the cache
+// for [kReleaseDelay] microseconds give their physical memory back to the
+// OS, but they stay mapped and can still be reused. The cache is not
+// thread-safe.
+class ChunkCache {
+ public:
+  static const int kMaximumChunkSize = Space::kDefaultMaximumChunkSize;
+  static const int kMaximumCachedSize = 16 * MB;
+  static const uint64 kReleaseDelay = 1000000;
+
+  ChunkCache();
+  ~ChunkCache();
+
+  // Take memory for a chunk of [size] bytes. The memory can be up to a
+  // quarter larger than asked for, and its real size is returned in
+  // [cached_size]. Returns 0 if there is no suitable memory in the cache.
+  // Sizes above [kMaximumChunkSize] are neither hits nor misses.
+  uword Take(int size, int* cached_size);
+
+  // Put the memory of a freed chunk in the cache. Returns false if the
+  // chunk is too large or the cache is full, in which case the caller must
+  // unmap the memory.
+  bool Put(uword base, int size, uint64 now);
+
+  // Release the physical memory of the chunks that have been in the cache
+  // for long enough.
+  void ReleaseIdleChunks(uint64 now);
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+  int cached_size() const { return cached_size_; }
+  int released_size() const { return released_size_; }
+
+ private:
+  struct Entry {
+    uword base;
+    uint64 freed_at;
+    bool released;
+  };
+
+  static const int kNumberOfClasses = kMaximumChunkSize / kPageSize;
+
+  // The entries of each size class are sorted by the time they were freed.
+  std::vector<Entry> classes_[kNumberOfClasses];
+  int hits_;
+  int misses_;
+  int cached_size_;
+  int released_size_;
+  uint64 next_release_;
+};
+
 // ObjectMemory controls all memory used by object heaps.
 class ObjectMemory {
  public:
   // Allocate a new chunk for a given space. All chunk sizes are
   // rounded up the page size and the allocated memory is aligned
-  // to a page boundary.
+  // to a page boundary. The chunk can be larger than asked for if
+  // its memory comes from the chunk cache.
   static Chunk* AllocateChunk(Space* space, int size);
 
-  // Release the chunk.
+  // Release the chunk. Its memory goes to the chunk cache if it fits.
   static void FreeChunk(Chunk* chunk);
 
+  // Print the chunk cache hit rate and the resident memory size.
+  static void PrintStatistics();
+
   // Determine if the address is in the given space using page tables
   // mapping an address to the space containing it.
   //
@@ -250,6 +413,13 @@ class ObjectMemory {
   // 64-bit: [ 16: zeros | 13: directory | 13: table | 10 space | 12: zeros ]
   static bool IsAddressInSpace(uword address, const Space* space);
 
+  // Returns the chunk containing the address, or NULL. Uses the same page
+  // tables as [IsAddressInSpace].
+  static Chunk* ChunkFor(uword address);
+
+  // Marks the card of the address, which must be in a chunk.
+  static void MarkCard(uword address) { ChunkFor(address)->MarkCard(address); }
+
   // Setup and tear-down support.
   static void Setup();
   static void TearDown();
@@ -260,8 +430,11 @@ class ObjectMemory {
   static PageTable* GetPageTable(uword address);
   static void SetPageTable(uword address, PageTable* table);
 
-  // Associate a range of pages with a given space.
-  static void SetSpaceForPages(uword base, uword limit, Space* space);
+  // Associate a range of pages with a given space and chunk.
+  static void SetSpaceForPages(uword base,
+                               uword limit,
+                               Space* space,
+                               Chunk* chunk);
 
 #ifdef FLETCH32
   static PageDirectory page_directory_;
@@ -269,6 +442,7 @@ class ObjectMemory {
   static PageDirectory* page_directories_[1 << 13];
 #endif
   static Mutex* mutex_;    // Mutex used for synchronized chunk allocation.
+  static ChunkCache* chunk_cache_;
 
   friend class Space;
 };
@@ -3,8 +3,12 @@
 // BSD-style license that can be found in the LICENSE.md file.
 
 #include "src/shared/assert.h"
+#include "src/shared/random.h"
 #include "src/vm/heap.h"
+#include "src/vm/mark_sweep.h"
 #include "src/vm/object_memory.h"
+#include "src/vm/parallel_scavenger.h"
+#include "src/vm/remembered_set.h"
 #include "src/shared/test_case.h"
 
 namespace fletch {
@@ -68,4 +72,433 @@ TEST_CASE(Space_PrependSpace) {
   }
 }
 
+static Array* NewArray(Heap* heap, Class* array_class, int length) {
+  return Array::cast(heap->CreateArray(array_class, length, Smi::zero()));
+}
+
+TEST_CASE(ChunkCache) {
+  ChunkCache cache;
+  int size = 0;
+  EXPECT(cache.Take(4 * KB, &size) == 0);
+
+  // Cached memory is only handed out for chunks of about the same size.
+  uword base = reinterpret_cast<uword>(Platform::AllocatePages(8 * KB));
+  EXPECT(cache.Put(base, 8 * KB, 0));
+  EXPECT_EQ(cache.cached_size(), 8 * KB);
+  EXPECT(cache.Take(4 * KB, &size) == 0);
+  EXPECT_EQ(cache.Take(8 * KB, &size), base);
+  EXPECT_EQ(size, 8 * KB);
+  EXPECT_EQ(cache.hits(), 1);
+  EXPECT_EQ(cache.misses(), 2);
+  EXPECT_EQ(cache.cached_size(), 0);
+
+  // Idle chunks are released, but they can still be reused.
+  EXPECT(cache.Put(base, 8 * KB, 0));
+  cache.ReleaseIdleChunks(ChunkCache::kReleaseDelay - 1);
+  EXPECT_EQ(cache.released_size(), 0);
+  cache.ReleaseIdleChunks(2 * ChunkCache::kReleaseDelay);
+  EXPECT_EQ(cache.released_size(), 8 * KB);
+  EXPECT_EQ(cache.Take(8 * KB, &size), base);
+  EXPECT_EQ(cache.released_size(), 0);
+  memset(reinterpret_cast<void*>(base), 0, size);
+
+  // Chunks for large objects are never cached.
+  int large = ChunkCache::kMaximumChunkSize + kPageSize;
+  EXPECT(!cache.Put(base, large, 0));
+  EXPECT(cache.Take(large, &size) == 0);
+  EXPECT_EQ(cache.misses(), 2);
+  Platform::FreePages(reinterpret_cast<void*>(base), 8 * KB);
+}
+
+class ObjectCounter : public HeapObjectVisitor {
+ public:
+  ObjectCounter() : count_(0) { }
+
+  void Visit(HeapObject* object) { count_++; }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+};
+
+TEST_CASE(Space_GenerationalScavenge) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+
+  Heap nursery(&random);
+  Heap survivors(&random);
+  Heap old_heap(&random);
+
+  // The root points to a new object and to a survivor. The survivor and
+  // an old object both point to new objects.
+  Array* root = NewArray(&nursery, array_class, 2);
+  Array* young = NewArray(&nursery, array_class, 1);
+  Array* survivor = NewArray(&survivors, array_class, 1);
+  Array* old = NewArray(&old_heap, array_class, 1);
+  root->set(0, young);
+  root->set(1, survivor);
+  survivor->set(0, NewArray(&nursery, array_class, 1));
+  old->set(0, NewArray(&nursery, array_class, 1));
+
+  Heap to_heap(&random);
+  Space* to = to_heap.space();
+  Space* old_space = old_heap.space();
+  NoAllocationFailureScope scope(to);
+  NoAllocationFailureScope old_scope(old_space);
+  to->StartScavenge();
+  old_space->StartScavenge();
+
+  GenerationalScavengeVisitor visitor(
+      nursery.space(), survivors.space(), to, old_space);
+  visitor.Visit(reinterpret_cast<Object**>(&root));
+  old->IteratePointers(&visitor);
+
+  CardMarkingVisitor survivor_marker(
+      to, old_space, program_heap.space(), false);
+  CardMarkingVisitor old_marker(to, old_space, program_heap.space(), true);
+  int rounds = 0;
+  bool found_work = true;
+  while (found_work) {
+    found_work = to->CompleteScavengeGenerational(&visitor, &survivor_marker);
+    if (old_space->CompleteScavengeGenerational(&visitor, &old_marker)) {
+      found_work = true;
+    }
+    rounds++;
+  }
+  // Promoting the survivor finds another new object, so the survivors have
+  // to be scanned again.
+  EXPECT_EQ(rounds, 3);
+
+  EXPECT(to->Includes(root->address()));
+  Object* promoted = root->get(1);
+  EXPECT(old_space->Includes(HeapObject::cast(promoted)->address()));
+  Object* promoted_child = Array::cast(promoted)->get(0);
+  EXPECT(to->Includes(HeapObject::cast(promoted_child)->address()));
+  EXPECT(to->Includes(HeapObject::cast(root->get(0))->address()));
+  EXPECT(to->Includes(HeapObject::cast(old->get(0))->address()));
+
+  // Only the promoted survivor points from the old space to the young
+  // generation; it is the only object the scan remembers.
+  Array* promoted_array = Array::cast(promoted);
+  EXPECT(ObjectMemory::ChunkFor(promoted_array->address())->IsCardDirty(
+      promoted_array->address() + Array::kSize));
+  EXPECT(!ObjectMemory::ChunkFor(root->address())->HasDirtyCards());
+}
+
+class SlotCounter : public PointerVisitor {
+ public:
+  SlotCounter() : count_(0) { }
+
+  void VisitBlock(Object** start, Object** end) { count_ += end - start; }
+
+  int count() const { return count_; }
+
+ private:
+  int count_;
+};
+
+TEST_CASE(Space_DirtyCards) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+
+  Heap heap(&random);
+  Space* space = heap.space();
+  NoAllocationFailureScope scope(space);
+  int length = 4 * Chunk::kCardSize / kPointerSize;
+  Array* array = NewArray(&heap, array_class, length);
+  Chunk* chunk = ObjectMemory::ChunkFor(array->address());
+  EXPECT(!chunk->HasDirtyCards());
+
+  // Only the slots in the dirty card are visited.
+  uword slot = array->address() + Array::kSize + Chunk::kCardSize;
+  ObjectMemory::MarkCard(slot);
+  EXPECT(chunk->HasDirtyCards());
+  EXPECT(chunk->IsCardDirty(slot));
+  EXPECT(!chunk->IsCardDirty(array->address()));
+  SlotCounter counter;
+  space->VisitDirtyCards(&counter);
+  EXPECT_EQ(counter.count(), Chunk::kCardSize / kPointerSize);
+  EXPECT(chunk->HasDirtyCards());
+
+  // With a marker, the cards are cleaned unless the slots in them still
+  // need to be remembered.
+  Heap young(&random);
+  CardMarkingVisitor marker(
+      young.space(), space, program_heap.space(), true);
+  space->VisitDirtyCards(&counter, &marker);
+  EXPECT(!chunk->HasDirtyCards());
+
+  array->set(length - 1, NewArray(&young, array_class, 0));
+  ObjectMemory::MarkCard(array->address() + Array::kSize);
+  ObjectMemory::MarkCard(
+      array->address() + Array::kSize + (length - 1) * kPointerSize);
+  space->VisitDirtyCards(&counter, &marker);
+  EXPECT(!chunk->IsCardDirty(array->address() + Array::kSize));
+  EXPECT(chunk->IsCardDirty(
+      array->address() + Array::kSize + (length - 1) * kPointerSize));
+}
+
+class ByteArrayCounter : public HeapObjectVisitor {
+ public:
+  ByteArrayCounter() : count_(0), size_(0) { }
+
+  void Visit(HeapObject* object) {
+    if (!object->IsByteArray()) return;
+    count_++;
+    size_ += object->Size();
+  }
+
+  int count() const { return count_; }
+  int size() const { return size_; }
+
+ private:
+  int count_;
+  int size_;
+};
+
+TEST_CASE(Space_MarkSweep) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+  Class* byte_array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::byte_array_format(), meta_class, NULL));
+
+  // A list of live arrays, each followed by two dead ones, and then enough
+  // dead arrays to fill a few chunks.
+  Heap heap(&random);
+  Space* space = heap.space();
+  NoAllocationFailureScope scope(space);
+  Array* root = NULL;
+  for (int i = 0; i < 100; i++) {
+    Array* live = NewArray(&heap, array_class, 1);
+    live->set(0, root == NULL ? static_cast<Object*>(Smi::zero()) : root);
+    root = live;
+    NewArray(&heap, array_class, 1);
+    NewArray(&heap, array_class, 2);
+  }
+  for (int i = 0; i < 4 * Space::kDefaultMaximumChunkSize / KB; i++) {
+    NewArray(&heap, array_class, KB / kPointerSize);
+  }
+  Array* last = NewArray(&heap, array_class, 0);
+  int used_before = space->Used();
+
+  MarkSweepCollector collector(space);
+  collector.Visit(reinterpret_cast<Object**>(&root));
+  collector.Visit(reinterpret_cast<Object**>(&last));
+  while (!collector.ProcessMarkingStack(10)) { }
+  EXPECT(collector.IsLive(root));
+  EXPECT(collector.IsLive(last));
+  collector.Sweep(byte_array_class);
+
+  int live_array_size = Array::AllocationSize(1);
+  EXPECT_EQ(collector.live_bytes(),
+            100 * live_array_size + Array::AllocationSize(0));
+  EXPECT(space->Used() < used_before);
+
+  // The live objects are untouched, and every run of dead objects became a
+  // single filler.
+  int length = 0;
+  Object* list = root;
+  while (list != Smi::zero()) {
+    list = Array::cast(list)->get(0);
+    length++;
+  }
+  EXPECT_EQ(length, 100);
+  ByteArrayCounter counter;
+  space->IterateObjects(&counter);
+  EXPECT(counter.count() >= 100);
+  EXPECT_EQ(counter.size() + collector.live_bytes(), space->Used());
+}
+
+TEST_CASE(Space_LargeObjects) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+  Class* byte_array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::byte_array_format(), meta_class, NULL));
+
+  Heap heap(&random);
+  Space large_space;
+  heap.set_large_object_space(&large_space);
+  NoAllocationFailureScope scope(heap.space());
+  NoAllocationFailureScope large_scope(&large_space);
+
+  // Small arrays stay in the heap's own space, and every large array gets
+  // a chunk of its own.
+  int length = Heap::kLargeObjectSize / kPointerSize;
+  int size = Array::AllocationSize(length);
+  Array* small = NewArray(&heap, array_class, 1);
+  EXPECT(heap.space()->Includes(small->address()));
+  Array* first = NewArray(&heap, array_class, length);
+  Array* dead = NewArray(&heap, array_class, length);
+  Array* child = NewArray(&heap, array_class, length);
+  Array* last = NewArray(&heap, array_class, length);
+  EXPECT(large_space.Includes(first->address()));
+  EXPECT(large_space.Includes(last->address()));
+  EXPECT_EQ(large_space.Used(), 4 * size);
+  first->set(0, child);
+
+  // Sweeping frees the chunks of the dead arrays, including the last one,
+  // and leaves the live arrays where they are.
+  MarkSweepCollector collector(&large_space);
+  collector.Visit(reinterpret_cast<Object**>(&small));
+  collector.Visit(reinterpret_cast<Object**>(&first));
+  while (!collector.ProcessMarkingStack(10)) { }
+  EXPECT(collector.IsLive(child));
+  EXPECT(!collector.IsLive(dead));
+  EXPECT(!collector.IsLive(last));
+  collector.Sweep(byte_array_class);
+  EXPECT_EQ(collector.live_bytes(), 2 * size);
+  EXPECT_EQ(large_space.Used(), 2 * size);
+  EXPECT(large_space.Includes(first->address()));
+  EXPECT(large_space.Includes(child->address()));
+  EXPECT(!large_space.Includes(last->address()));
+  EXPECT_EQ(first->get(0), child);
+  ByteArrayCounter counter;
+  large_space.IterateObjects(&counter);
+  EXPECT_EQ(counter.count(), 0);
+
+  // Allocation continues after the sweep.
+  NewArray(&heap, array_class, length);
+  EXPECT_EQ(large_space.Used(), 3 * size);
+}
+
+TEST_CASE(Space_AllocationSampling) {
+  Space space(4 * KB);
+  space.SetAllocationBudget(MB);
+  space.Allocate(8 * kPointerSize);
+
+  // The allocation that reaches the sample point fails.
+  space.ScheduleSample(4 * kPointerSize);
+  uword last = space.Allocate(2 * kPointerSize);
+  EXPECT(last != 0);
+  EXPECT(!space.sample_pending());
+  int used = space.Used();
+  EXPECT(space.Allocate(2 * kPointerSize) == 0);
+  EXPECT(space.sample_pending());
+
+  // The failed allocation took no memory, and the retry continues right
+  // after the last object.
+  space.ClearSamplePending();
+  space.ScheduleSample(64 * kPointerSize);
+  EXPECT_EQ(space.Used(), used);
+  EXPECT_EQ(space.Allocate(2 * kPointerSize), last + 2 * kPointerSize);
+  EXPECT_EQ(space.Used(), used + 2 * kPointerSize);
+  EXPECT(!space.sample_pending());
+
+  // Objects larger than the distance to the sample point are sampled too.
+  EXPECT(space.Allocate(64 * kPointerSize) == 0);
+  EXPECT(space.sample_pending());
+  space.ClearSamplePending();
+  EXPECT(space.Allocate(64 * kPointerSize) != 0);
+}
+
+TEST_CASE(Space_AllocationLimit) {
+  Space space;
+  space.SetAllocationBudget(MB);
+  space.SetAllocationLimit(16 * KB);
+
+  // Allocation fails once the next object would go past the limit, and
+  // the failed request makes the space ask for a collection.
+  int size = KB;
+  int count = 0;
+  while (count < 100 && space.Allocate(size) != 0) count++;
+  EXPECT(count < 100);
+  EXPECT(space.Used() + size > 16 * KB);
+  EXPECT(space.Used() < 16 * KB + kPageSize);
+  EXPECT_EQ(space.limit_request(), size);
+  EXPECT(space.needs_garbage_collection());
+  EXPECT(space.AllocateLarge(size) == 0);
+
+  // Setting the limit again forgets the request.
+  space.SetAllocationLimit(Space::kNoAllocationLimit);
+  EXPECT(!space.needs_garbage_collection());
+  EXPECT(space.Allocate(size) != 0);
+  EXPECT(space.AllocateLarge(16 * KB) != 0);
+
+  // Allocations that must not fail ignore the limit.
+  space.SetAllocationLimit(space.Used());
+  NoAllocationFailureScope scope(&space);
+  EXPECT(space.AllocateLarge(size) != 0);
+  EXPECT_EQ(space.limit_request(), 0);
+}
+
+class ArrayRoots : public ScavengeRoots {
+ public:
+  ArrayRoots(Array** roots, int count) : roots_(roots), count_(count) { }
+
+  int NumberOfPartitions() { return count_; }
+
+  void VisitPartition(int index, PointerVisitor* visitor) {
+    visitor->Visit(reinterpret_cast<Object**>(&roots_[index]));
+  }
+
+ private:
+  Array** roots_;
+  int count_;
+};
+
+TEST_CASE(Space_ParallelScavenge) {
+  static const int kRoots = 16;
+  static const int kListLength = 1000;
+
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+
+  // Every root is a long linked list of arrays, and all the lists share
+  // their last element. The garbage array is not reachable.
+  Heap from(&random);
+  NoAllocationFailureScope scope(from.space());
+  NewArray(&from, array_class, 10);
+  Array* shared = NewArray(&from, array_class, 1);
+  Array* roots[kRoots];
+  for (int i = 0; i < kRoots; i++) {
+    Array* list = shared;
+    for (int j = 0; j < kListLength; j++) {
+      Array* next = NewArray(&from, array_class, 2);
+      next->set(0, list);
+      next->set(1, Smi::FromWord(j));
+      list = next;
+    }
+    roots[i] = list;
+  }
+
+  ArrayRoots array_roots(roots, kRoots);
+  ParallelScavenger scavenger(from.space(), 4);
+  Space* to = scavenger.Scavenge(&array_roots);
+
+  ObjectCounter counter;
+  to->IterateObjects(&counter);
+  EXPECT_EQ(counter.count(), kRoots * kListLength + 1);
+
+  Object* last = NULL;
+  for (int i = 0; i < kRoots; i++) {
+    Array* list = roots[i];
+    for (int j = kListLength - 1; j >= 0; j--) {
+      EXPECT(to->Includes(list->address()));
+      EXPECT_EQ(list->get(1), Smi::FromWord(j));
+      list = Array::cast(list->get(0));
+    }
+    EXPECT(to->Includes(list->address()));
+    if (last != NULL) EXPECT_EQ(list, last);
+    last = list;
+  }
+
+  delete to;
+}
+
 }  // namespace fletch
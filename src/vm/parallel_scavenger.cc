@@ -0,0 +1,199 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/parallel_scavenger.h"
+
+#include <vector>
+
+#include "src/shared/platform.h"
+
+#include "src/vm/object.h"
+#include "src/vm/object_memory.h"
+#include "src/vm/thread.h"
+#include "src/vm/work_stealing_queue.h"
+
+namespace fletch {
+
+// Idle workers spin for a short while and then start yielding, so they do
+// not take the processor away from the workers that still have work.
+class Backoff {
+ public:
+  Backoff() : spins_(0) { }
+
+  void Wait() {
+    if (spins_ < kMaxSpins) {
+      spins_++;
+      Platform::Pause();
+    } else {
+      Platform::Yield();
+    }
+  }
+
+ private:
+  static const int kMaxSpins = 64;
+
+  int spins_;
+};
+
+class ScavengeWorker : public PointerVisitor {
+ public:
+  ScavengeWorker(ParallelScavenger* scavenger, Space* from, Space* to)
+      : scavenger_(scavenger), from_(from), to_(to) { }
+
+  void VisitBlock(Object** start, Object** end) {
+    for (Object** p = start; p < end; p++) ScavengePointer(p);
+  }
+
+  void Run();
+
+  Space* to() const { return to_; }
+  WorkStealingQueue<HeapObject>* deque() { return &deque_; }
+
+ private:
+  void ScavengePointer(Object** p) {
+    Object* object = *p;
+    if (!object->IsHeapObject()) return;
+    if (!from_->Includes(reinterpret_cast<uword>(object))) return;
+    bool copied;
+    HeapObject* target =
+        HeapObject::cast(object)->CloneInToSpaceConcurrently(to_, &copied);
+    *p = target;
+    if (copied && !deque_.Push(target)) overflow_.push_back(target);
+  }
+
+  // Returns the next grey object of this worker, or NULL.
+  HeapObject* Next();
+
+  ParallelScavenger* const scavenger_;
+  Space* const from_;
+  Space* const to_;
+  WorkStealingQueue<HeapObject> deque_;
+  // Grey objects that did not fit in the deque. Only this worker sees them,
+  // so they are moved to the deque as it drains.
+  std::vector<HeapObject*> overflow_;
+};
+
+HeapObject* ScavengeWorker::Next() {
+  HeapObject* object = deque_.Pop();
+  if (object != NULL) return object;
+  if (overflow_.empty()) return NULL;
+  object = overflow_.back();
+  overflow_.pop_back();
+  while (!overflow_.empty() && deque_.Push(overflow_.back())) {
+    overflow_.pop_back();
+  }
+  return object;
+}
+
+void ScavengeWorker::Run() {
+  // Workers never fail allocation; they grow their to-space instead.
+  NoAllocationFailureScope scope(to_);
+
+  int partition;
+  while ((partition = scavenger_->NextPartition()) >= 0) {
+    scavenger_->roots_->VisitPartition(partition, this);
+  }
+
+  while (true) {
+    HeapObject* object = Next();
+    if (object == NULL) object = scavenger_->Steal(this);
+    if (object != NULL) {
+      object->IteratePointers(this);
+      continue;
+    }
+    if (scavenger_->WaitForWork(this)) return;
+  }
+}
+
+ParallelScavenger::ParallelScavenger(Space* from, int number_of_workers)
+    : from_(from),
+      number_of_workers_(number_of_workers),
+      workers_(new ScavengeWorker*[number_of_workers]),
+      roots_(NULL),
+      next_partition_(0),
+      active_workers_(0) {
+  ASSERT(number_of_workers > 0);
+  int initial_size = from->Used() / 10 / number_of_workers;
+  for (int i = 0; i < number_of_workers_; i++) {
+    workers_[i] = new ScavengeWorker(this, from, new Space(initial_size));
+  }
+}
+
+ParallelScavenger::~ParallelScavenger() {
+  for (int i = 0; i < number_of_workers_; i++) {
+    delete workers_[i];
+  }
+  delete[] workers_;
+}
+
+void* ParallelScavenger::RunWorker(void* data) {
+  reinterpret_cast<ScavengeWorker*>(data)->Run();
+  return NULL;
+}
+
+Space* ParallelScavenger::Scavenge(ScavengeRoots* roots) {
+  roots_ = roots;
+  next_partition_ = 0;
+  active_workers_ = number_of_workers_;
+
+  ThreadIdentifier* threads = new ThreadIdentifier[number_of_workers_];
+  for (int i = 1; i < number_of_workers_; i++) {
+    threads[i] = Thread::Run(RunWorker, workers_[i]);
+  }
+  workers_[0]->Run();
+  for (int i = 1; i < number_of_workers_; i++) {
+    threads[i].Join();
+  }
+  delete[] threads;
+
+  Space* to = workers_[0]->to();
+  for (int i = 1; i < number_of_workers_; i++) {
+    to->PrependSpace(workers_[i]->to());
+  }
+  return to;
+}
+
+int ParallelScavenger::NextPartition() {
+  int partition = next_partition_++;
+  return (partition < roots_->NumberOfPartitions()) ? partition : -1;
+}
+
+HeapObject* ParallelScavenger::Steal(ScavengeWorker* thief) {
+  Backoff backoff;
+  while (true) {
+    // Stealing fails spuriously when racing with the owner or another
+    // thief, so only give up once every deque was seen empty.
+    bool retry = false;
+    for (int i = 0; i < number_of_workers_; i++) {
+      ScavengeWorker* victim = workers_[i];
+      if (victim == thief) continue;
+      HeapObject* object = NULL;
+      if (!victim->deque()->TrySteal(&object)) {
+        retry = true;
+      } else if (object != NULL) {
+        return object;
+      }
+    }
+    if (!retry) return NULL;
+    backoff.Wait();
+  }
+}
+
+bool ParallelScavenger::WaitForWork(ScavengeWorker* worker) {
+  --active_workers_;
+  Backoff backoff;
+  while (true) {
+    for (int i = 0; i < number_of_workers_; i++) {
+      if (workers_[i]->deque()->is_empty()) continue;
+      // Become active again before stealing, so the others do not decide
+      // that all the work is done while we scan what we stole.
+      ++active_workers_;
+      return false;
+    }
+    if (active_workers_ == 0) return true;
+    backoff.Wait();
+  }
+}
+
+}  // namespace fletch
@@ -0,0 +1,75 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PARALLEL_SCAVENGER_H_
+#define SRC_VM_PARALLEL_SCAVENGER_H_
+
+#include "src/shared/atomic.h"
+#include "src/shared/globals.h"
+
+namespace fletch {
+
+class HeapObject;
+class PointerVisitor;
+class ScavengeWorker;
+class Space;
+
+// The roots of a parallel scavenge, split into partitions. Each partition
+// is visited by exactly one worker, so no two workers ever update the same
+// root slot.
+class ScavengeRoots {
+ public:
+  virtual ~ScavengeRoots() { }
+
+  virtual int NumberOfPartitions() = 0;
+  virtual void VisitPartition(int index, PointerVisitor* visitor) = 0;
+};
+
+// Copies everything in a from-space that is reachable from a set of roots,
+// using several threads. Every worker copies into its own to-space, so
+// allocation needs no synchronization. Copied objects that still have to
+// be scanned are pushed on the worker's work-stealing deque, and idle
+// workers steal from the others.
+//
+// The objects must only contain pointers that are safe to update from any
+// thread, which is true for the immutable heap.
+class ParallelScavenger {
+ public:
+  ParallelScavenger(Space* from, int number_of_workers);
+  ~ParallelScavenger();
+
+  // Scavenge the objects reachable from [roots]. The calling thread works
+  // as one of the workers. Returns a new space with all the copied objects,
+  // owned by the caller.
+  Space* Scavenge(ScavengeRoots* roots);
+
+  int number_of_workers() const { return number_of_workers_; }
+
+ private:
+  friend class ScavengeWorker;
+
+  static void* RunWorker(void* data);
+
+  // Claim the next root partition. Returns -1 when there are no more.
+  int NextPartition();
+
+  // Take a grey object from another worker than [thief]. Returns NULL if
+  // all deques are empty.
+  HeapObject* Steal(ScavengeWorker* thief);
+
+  // Called by a worker that has run out of work. Returns true when all the
+  // workers are done, and false if there might be something to steal.
+  bool WaitForWork(ScavengeWorker* worker);
+
+  Space* const from_;
+  const int number_of_workers_;
+  ScavengeWorker** workers_;
+  ScavengeRoots* roots_;
+  Atomic<int> next_partition_;
+  Atomic<int> active_workers_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_PARALLEL_SCAVENGER_H_
@@ -0,0 +1,41 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/pause_histogram.h"
+
+#include "src/shared/utils.h"
+
+namespace fletch {
+
+PauseHistogram::PauseHistogram() : count_(0), total_(0), max_(0) {
+  for (int i = 0; i < kBuckets; i++) buckets_[i] = 0;
+}
+
+void PauseHistogram::Record(uint64 microseconds) {
+  int index = 0;
+  while (index < kBuckets - 1 && (microseconds >> index) != 0) index++;
+  buckets_[index]++;
+  count_++;
+  total_ += microseconds;
+  if (microseconds > max_) max_ = microseconds;
+}
+
+void PauseHistogram::PrintStatistics(const char* name) {
+  if (count_ == 0) return;
+  Print::Out("%s: %d pauses, %d us average, %d us max\n",
+             name,
+             count_,
+             static_cast<int>(total_ / count_),
+             static_cast<int>(max_));
+  for (int i = 0; i < kBuckets; i++) {
+    if (buckets_[i] == 0) continue;
+    if (i == kBuckets - 1) {
+      Print::Out("  >= %d us: %d\n", 1 << (i - 1), buckets_[i]);
+    } else {
+      Print::Out("  < %d us: %d\n", 1 << i, buckets_[i]);
+    }
+  }
+}
+
+}  // namespace fletch
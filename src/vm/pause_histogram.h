@@ -0,0 +1,40 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PAUSE_HISTOGRAM_H_
+#define SRC_VM_PAUSE_HISTOGRAM_H_
+
+#include "src/shared/globals.h"
+
+namespace fletch {
+
+// Histogram of pause times in microseconds. Bucket i counts the pauses
+// that took less than 2^i microseconds, but not less than 2^(i-1); the last
+// bucket also counts everything longer.
+class PauseHistogram {
+ public:
+  static const int kBuckets = 24;
+
+  PauseHistogram();
+
+  void Record(uint64 microseconds);
+
+  int count() const { return count_; }
+  int bucket(int index) const { return buckets_[index]; }
+  uint64 total() const { return total_; }
+  uint64 max() const { return max_; }
+
+  // Print the non-empty buckets, preceded by [name].
+  void PrintStatistics(const char* name);
+
+ private:
+  int buckets_[kBuckets];
+  int count_;
+  uint64 total_;
+  uint64 max_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_PAUSE_HISTOGRAM_H_
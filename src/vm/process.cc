@@ -5,20 +5,27 @@
 #include "src/vm/process.h"
 
 #include <errno.h>
+#include <math.h>
 #include <stdlib.h>
 
 #include "src/shared/bytecodes.h"
 #include "src/shared/flags.h"
 #include "src/shared/names.h"
+#include "src/shared/platform.h"
 #include "src/shared/selectors.h"
 
+#include "src/vm/finalizer_queue.h"
 #include "src/vm/heap_validator.h"
+#include "src/vm/mark_sweep.h"
 #include "src/vm/natives.h"
 #include "src/vm/object_memory.h"
 #include "src/vm/port.h"
 #include "src/vm/process_queue.h"
+#include "src/vm/profiler.h"
+#include "src/vm/remembered_set.h"
 #include "src/vm/session.h"
 #include "src/vm/stack_walker.h"
+#include "src/vm/work_stealing_queue.h"
 
 namespace fletch {
 
@@ -28,11 +35,10 @@ static Object** kProfileMarker = reinterpret_cast<Object**>(2);
 class ExitReference {
  public:
   ExitReference(Process* exiting_process, Object* message)
-      : mutable_heap_(NULL, reinterpret_cast<WeakPointer*>(NULL)),
-        store_buffer_(true),
+      : mutable_heap_(static_cast<Space*>(NULL)),
         message_(message) {
+    exiting_process->MergeGenerations();
     mutable_heap_.MergeInOtherHeap(exiting_process->heap());
-    store_buffer_.Prepend(exiting_process->store_buffer());
   }
 
   Object* message() const { return message_; }
@@ -43,11 +49,8 @@ class ExitReference {
 
   Heap* mutable_heap() { return &mutable_heap_; }
 
-  StoreBuffer* store_buffer() { return &store_buffer_; }
-
  private:
   Heap mutable_heap_;
-  StoreBuffer store_buffer_;
   Object* message_;
 };
 
@@ -112,7 +115,12 @@ class PortQueue {
 ThreadState::ThreadState()
     : thread_id_(-1),
       queue_(new ProcessQueue()),
+      deque_(new WorkStealingQueue<Process>()),
+      random_(static_cast<uint32>(reinterpret_cast<uword>(this) >> 4)),
+      dispatch_count_(0),
       cache_(NULL),
+      inline_cache_(NULL),
+      profile_buffer_(NULL),
       idle_monitor_(Platform::CreateMonitor()),
       next_idle_thread_(NULL) {
 }
@@ -126,15 +134,34 @@ LookupCache* ThreadState::EnsureCache() {
   return cache_;
 }
 
+InlineCache* ThreadState::EnsureInlineCache() {
+  if (inline_cache_ == NULL) inline_cache_ = new InlineCache();
+  return inline_cache_;
+}
+
+ProfileBuffer* ThreadState::EnsureProfileBuffer() {
+  if (profile_buffer_ == NULL) profile_buffer_ = new ProfileBuffer();
+  return profile_buffer_;
+}
+
 ThreadState::~ThreadState() {
   delete idle_monitor_;
   delete queue_;
+  delete deque_;
   delete cache_;
+  delete inline_cache_;
+  delete profile_buffer_;
 }
 
 Process::Process(Program* program)
     : random_(program->random()->NextUInt32() + 1),
       heap_(&random_, 4 * KB),
+      survivor_space_(new Space()),
+      old_space_(new Space()),
+      large_space_(new Space()),
+      heap_limit_(Flags::process_heap_limit),
+      out_of_memory_(false),
+      uncaught_out_of_memory_(false),
       immutable_heap_(NULL),
       program_(program),
       statics_(NULL),
@@ -143,6 +170,8 @@ Process::Process(Program* program)
       state_(kSleeping),
       thread_state_(NULL),
       primary_lookup_cache_(NULL),
+      primary_lookup_cache_mask_(0),
+      inline_cache_(NULL),
       next_(NULL),
       queue_(NULL),
       queue_next_(NULL),
@@ -154,12 +183,18 @@ Process::Process(Program* program)
       process_list_prev_(NULL),
       errno_cache_(0),
       debug_info_(NULL) {
+  old_space_->AdjustAllocationBudget();
+  large_space_->AdjustAllocationBudget();
+  heap_.set_large_object_space(large_space_);
   Array* static_fields = program->static_fields();
   int length = static_fields->length();
   statics_ = Array::cast(NewArray(length));
   for (int i = 0; i < length; i++) {
     statics_->set(i, static_fields->get(i));
   }
+  ScheduleAllocationSample(heap_.space());
+  ScheduleAllocationSample(large_space_);
+  UpdateHeapLimit();
 #ifdef DEBUG
   true_then_false_ = true;
 #endif
@@ -170,6 +205,13 @@ Process::~Process() {
 
   ASSERT(next_ == NULL);
   ASSERT(cooked_stack_deltas_.is_empty());
+  // The weak pointer callbacks run when [heap_] is deleted, and they may
+  // look at objects in any of the generations. The heap is gone if the
+  // process exited with a message.
+  if (heap_.space() != NULL) MergeGenerations();
+  delete survivor_space_;
+  delete old_space_;
+  delete large_space_;
   // Clear out the process pointer from all the ports.
   heap_.ProcessWeakPointers();
   ASSERT(immutable_heap_ == NULL);
@@ -200,7 +242,7 @@ void Process::UpdateCoroutine(Coroutine* coroutine) {
   ASSERT(coroutine->has_stack());
   coroutine_ = coroutine;
   UpdateStackLimit();
-  store_buffer_.Insert(coroutine->stack());
+  RememberObject(coroutine->stack());
 }
 
 Process::StackCheckResult Process::HandleStackOverflow(int addition) {
@@ -209,6 +251,8 @@ Process::StackCheckResult Process::HandleStackOverflow(int addition) {
   if (current_limit == kProfileMarker) {
     stack_limit_ = NULL;
     UpdateStackLimit();
+    ThreadState* state = thread_state_;
+    if (state != NULL) state->EnsureProfileBuffer()->RecordSample(this);
     return kStackCheckContinue;
   }
 
@@ -226,8 +270,16 @@ Process::StackCheckResult Process::HandleStackOverflow(int addition) {
   if (new_size > 128 * KB) return kStackCheckOverflow;
 
   Object* new_stack_object = NewStack(new_size);
+  if (new_stack_object == Failure::retry_after_gc() &&
+      allocation_sample_pending()) {
+    RecordAllocationSample();
+    new_stack_object = NewStack(new_size);
+  }
   if (new_stack_object == Failure::retry_after_gc()) {
     CollectMutableGarbage();
+    // The stack cannot grow if there is no room for it under the heap
+    // limit.
+    if (TakeOutOfMemory()) return kStackCheckOverflow;
     new_stack_object = NewStack(new_size);
     if (new_stack_object->IsFailure()) {
       FATAL("Failed to increase stack size");
@@ -242,7 +294,8 @@ Process::StackCheckResult Process::HandleStackOverflow(int addition) {
   }
   ASSERT(coroutine_->has_stack());
   coroutine_->set_stack(new_stack);
-  store_buffer_.Insert(coroutine_->stack());
+  RecordStore(coroutine_, Coroutine::kStackOffset, new_stack);
+  RememberObject(new_stack);
   UpdateStackLimit();
   return kStackCheckContinue;
 }
@@ -251,6 +304,12 @@ Object* Process::NewArray(int length) {
   Class* array_class = program()->array_class();
   Object* null = program()->null_object();
   Object* result = heap_.CreateArray(array_class, length, null);
+  // Large arrays are old right away. Natives fill in new arrays without
+  // recording the stores, so make sure the array is remembered.
+  if (!result->IsFailure() &&
+      Array::AllocationSize(length) >= Heap::kLargeObjectSize) {
+    RememberObject(HeapObject::cast(result));
+  }
   return result;
 }
 
@@ -343,33 +402,282 @@ Object* Process::NewStack(int length) {
   Object* result = heap_.CreateStack(stack_class, length);
 
   if (result->IsFailure()) return result;
-  store_buffer_.Insert(HeapObject::cast(result));
+  RememberObject(HeapObject::cast(result));
   return result;
 }
 
 
+void Process::IterateHeapObjects(HeapObjectVisitor* visitor) {
+  large_space_->IterateObjects(visitor);
+  old_space_->IterateObjects(visitor);
+  survivor_space_->IterateObjects(visitor);
+  heap_.IterateObjects(visitor);
+}
+
+void Process::MergeGenerations() {
+  MergeCopiedGenerations();
+  heap_.space()->PrependSpace(large_space_);
+  large_space_ = new Space();
+  large_space_->AdjustAllocationBudget();
+  heap_.set_large_object_space(large_space_);
+  ScheduleAllocationSample(large_space_);
+  UpdateHeapLimit();
+}
+
+void Process::MergeCopiedGenerations() {
+  Space* nursery = heap_.space();
+  nursery->PrependSpace(survivor_space_);
+  nursery->PrependSpace(old_space_);
+  heap_.UntenureWeakPointers();
+  survivor_space_ = new Space();
+  old_space_ = new Space();
+  old_space_->AdjustAllocationBudget();
+}
+
+void Process::ReplaceNursery() {
+  int live = survivor_space_->Used() + old_space_->Used();
+  int size = Space::DefaultChunkSize(live);
+  heap_.ReplaceSpace(new Space(size));
+  heap_.space()->SetAllocationBudget(size);
+  ScheduleAllocationSample(heap_.space());
+  UpdateHeapLimit();
+}
+
+void Process::SetHeapLimit(int limit) {
+  ASSERT(limit >= 0);
+  heap_limit_ = limit;
+  UpdateHeapLimit();
+}
+
+void Process::UpdateHeapLimit() {
+  if (heap_limit_ == 0) {
+    heap_.space()->SetAllocationLimit(Space::kNoAllocationLimit);
+    large_space_->SetAllocationLimit(Space::kNoAllocationLimit);
+    return;
+  }
+  // Both spaces get all of the room, since either may need it. Whichever
+  // uses it first makes the other one fail and trigger a collection.
+  int room = Utils::Maximum(heap_limit_ - HeapUsed(), 0);
+  heap_.space()->SetAllocationLimit(heap_.space()->Used() + room);
+  large_space_->SetAllocationLimit(large_space_->Used() + room);
+}
+
+bool Process::NeedsImmutableGarbageCollection() {
+  Space* space = immutable_heap_->space();
+  int request = space->limit_request();
+  if (request != 0 && program()->immutable_heap()->ExceedsLimit(request)) {
+    space->ClearLimitRequest();
+    out_of_memory_ = true;
+    return false;
+  }
+  return immutable_heap_->needs_garbage_collection();
+}
+
+void Process::RecordAllocationSample() {
+  Space* spaces[] = { heap_.space(), large_space_ };
+  for (int i = 0; i < 2; i++) {
+    Space* space = spaces[i];
+    if (!space->sample_pending()) continue;
+    program()->allocation_profile()->RecordSample(this);
+    space->ClearSamplePending();
+    ScheduleAllocationSample(space);
+  }
+}
+
+void Process::ScheduleAllocationSample(Space* space) {
+  if (program()->allocation_profile() == NULL) return;
+  // The distances between samples are exponentially distributed, so the
+  // samples form a Poisson process over the allocated bytes and large
+  // objects are sampled in proportion to their size.
+  double uniform = (random_.NextUInt32() + 1.0) / 4294967296.0;
+  double distance = -log(uniform) * Flags::allocation_sample_interval;
+  if (distance < kPointerSize) distance = kPointerSize;
+  if (distance > GB) distance = GB;
+  space->ScheduleSample(static_cast<int>(distance));
+}
+
+// Scavenges all the pointers of objects that stay where they are, like the
+// large objects in a full collection, and marks their cards again from
+// scratch.
+class RememberedObjectVisitor: public HeapObjectVisitor {
+ public:
+  RememberedObjectVisitor(PointerVisitor* scavenger,
+                          CardMarkingVisitor* marker)
+      : scavenger_(scavenger), marker_(marker) { }
+
+  void Visit(HeapObject* object) {
+    object->IteratePointers(scavenger_);
+    uword address = object->address();
+    Chunk* chunk = ObjectMemory::ChunkFor(address);
+    chunk->ClearCards(address, address + object->Size());
+    marker_->MarkCards(chunk, object);
+  }
+
+ private:
+  PointerVisitor* scavenger_;
+  CardMarkingVisitor* marker_;
+};
+
+// Scavenges pointers with [scavenger], and marks the large objects they
+// point to with [large_objects].
+class LargeObjectMarkingVisitor: public PointerVisitor {
+ public:
+  LargeObjectMarkingVisitor(PointerVisitor* scavenger,
+                            MarkSweepCollector* large_objects)
+      : scavenger_(scavenger), large_objects_(large_objects) { }
+
+  void VisitBlock(Object** start, Object** end) {
+    scavenger_->VisitBlock(start, end);
+    large_objects_->VisitBlock(start, end);
+  }
+
+  void VisitClass(Object** p) { scavenger_->VisitClass(p); }
+
+ private:
+  PointerVisitor* scavenger_;
+  MarkSweepCollector* large_objects_;
+};
+
 void Process::CollectMutableGarbage() {
   TakeChildHeaps();
 
+  GcEvent event(GcEvent::kProcessYoung,
+                reinterpret_cast<uword>(this),
+                Platform::GetMicroseconds());
+  event.size_before = HeapUsed();
+  // An allocation that hit the heap limit needs a full collection, since
+  // a young one cannot make room under the limit.
+  int request = Utils::Maximum(heap_.space()->limit_request(),
+                               large_space_->limit_request());
+  if (request == 0 &&
+      !old_space_->needs_garbage_collection() &&
+      !large_space_->needs_garbage_collection()) {
+    event.promoted = CollectYoungGarbage();
+  } else {
+    event.kind = GcEvent::kProcessFull;
+    CollectFullGarbage();
+  }
+  event.size_after = HeapUsed();
+  out_of_memory_ = request != 0 && heap_limit_ != 0 &&
+      event.size_after + request > heap_limit_;
+  event.end = Platform::GetMicroseconds();
+  program()->gc_events()->Record(event);
+}
+
+void Process::CollectFullGarbage() {
+  MergeCopiedGenerations();
   Space* from = heap_.space();
   Space* to = new Space(from->Used() / 10);
-  StoreBuffer sb;
 
   // While garbage collecting, do not fail allocations. Instead grow
   // the to-space as needed.
   NoAllocationFailureScope scope(to);
+  to->StartScavenge();
 
-  ScavengeVisitor visitor(from, to);
+  MarkSweepCollector large_objects(large_space_);
+  ScavengeVisitor scavenger(from, to);
+  LargeObjectMarkingVisitor visitor(&scavenger, &large_objects);
   IterateRoots(&visitor);
 
   ASSERT(!to->is_empty());
+  CompleteFullGarbageCollection(&visitor, &large_objects, from, to);
+}
+
+int Process::CollectYoungGarbage() {
+  Space* nursery = heap_.space();
+  Space* to = new Space(nursery->Used() / 10);
+  int old_used = old_space_->Used();
+
+  // While garbage collecting, do not fail allocations. Instead grow
+  // the to-space and the old space as needed.
+  NoAllocationFailureScope scope(to);
+  NoAllocationFailureScope old_scope(old_space_);
+  to->StartScavenge();
+  old_space_->StartScavenge();
+
+  // Survivors only need to be remembered if they point to the immutable
+  // heap. Old objects also need to be remembered if they point to young
+  // objects.
+  Space* program_space = program()->heap()->space();
+  CardMarkingVisitor survivor_marker(
+      to, old_space_, program_space, false, large_space_);
+  CardMarkingVisitor old_marker(
+      to, old_space_, program_space, true, large_space_);
+
+  // The dirty cards of the old generation are roots. The cards of the
+  // young generation do not matter, since all the young objects are
+  // copied.
+  GenerationalScavengeVisitor visitor(nursery, survivor_space_, to, old_space_);
+  old_space_->VisitDirtyCards(&visitor, &old_marker);
+  large_space_->VisitDirtyCards(&visitor, &old_marker);
+  IterateRoots(&visitor);
+
+  // Promoting objects while scanning the survivors can find more
+  // survivors, so keep going until neither space has anything left to scan.
+  bool found_work = true;
+  while (found_work) {
+    found_work = to->CompleteScavengeGenerational(&visitor, &survivor_marker);
+    if (old_space_->CompleteScavengeGenerational(&visitor, &old_marker)) {
+      found_work = true;
+    }
+  }
+
+  // The nursery and the old survivor space are both garbage now.
+  Space* from = nursery;
+  from->PrependSpace(survivor_space_);
+  survivor_space_ = to;
+
+  heap_.ProcessWeakPointers(to);
+  set_ports(Port::CleanupPorts(from, ports()));
+
+  int promoted = old_space_->Used() - old_used;
+  if (Flags::print_gc_statistics) {
+    Print::Out("Process GC (young): copied %d bytes, promoted %d bytes, "
+               "heap %d bytes\n", to->Used() + promoted, promoted,
+               to->Used() + old_space_->Used());
+  }
+
+  ReplaceNursery();
+  UpdateStackLimit();
+  return promoted;
+}
+
+void Process::CompleteFullGarbageCollection(PointerVisitor* visitor,
+                                            MarkSweepCollector* large_objects,
+                                            Space* from,
+                                            Space* to) {
+  // Only pointers to the immutable heap need to be remembered after a full
+  // collection, because there are no young objects left.
   Space* program_space = program()->heap()->space();
-  to->CompleteScavengeMutable(&visitor, program_space, &sb);
-  store_buffer_.ReplaceAfterMutableGC(&sb);
+  CardMarkingVisitor marker(from, to, program_space, false, large_space_);
+  RememberedObjectVisitor marked(visitor, &marker);
+
+  // Scanning the copied objects can mark more large objects, and scanning
+  // the marked large objects can copy more objects, so keep going until
+  // neither has anything left to scan.
+  bool found_work = true;
+  while (found_work) {
+    found_work = to->CompleteScavengeGenerational(visitor, &marker);
+    if (large_objects->VisitMarkedObjects(&marked)) found_work = true;
+  }
 
+  // The finalizers of dead large objects must run before they are swept.
   heap_.ProcessWeakPointers();
+  heap_.ProcessWeakPointers(large_objects);
   set_ports(Port::CleanupPorts(from, ports()));
-  heap_.ReplaceSpace(to);
+  large_objects->Sweep(program()->byte_array_class());
+
+  if (Flags::print_gc_statistics) {
+    Print::Out("Process GC (full): copied %d bytes, large objects %d bytes, "
+               "heap %d bytes\n", to->Used(), large_objects->live_bytes(),
+               to->Used() + large_objects->live_bytes());
+  }
+
+  delete old_space_;
+  old_space_ = to;
+  old_space_->AdjustAllocationBudget();
+  large_space_->AdjustAllocationBudget();
+  ReplaceNursery();
   UpdateStackLimit();
 }
 
@@ -425,28 +733,26 @@ class ScavengeAndChainStacksVisitor: public PointerVisitor {
 };
 
 int Process::CollectMutableGarbageAndChainStacks() {
+  // All the stacks have to be found, so this always collects all the
+  // generations. Stacks are never large objects.
+  MergeCopiedGenerations();
   Space* from = heap_.space();
   Space* to = new Space(from->Used() / 10);
-  StoreBuffer sb;
 
   // While garbage collecting, do not fail allocations. Instead grow
   // the to-space as needed.
   NoAllocationFailureScope scope(to);
-  ScavengeAndChainStacksVisitor visitor(this, from, to);
+  to->StartScavenge();
+  MarkSweepCollector large_objects(large_space_);
+  ScavengeAndChainStacksVisitor scavenger(this, from, to);
+  LargeObjectMarkingVisitor visitor(&scavenger, &large_objects);
 
   // Visit the current coroutine stack first and chain the rest of the
   // stacks starting from there.
   visitor.Visit(reinterpret_cast<Object**>(coroutine_->stack_address()));
   IterateRoots(&visitor);
-  Space* program_space = program()->heap()->space();
-  to->CompleteScavengeMutable(&visitor, program_space, &sb);
-  store_buffer_.ReplaceAfterMutableGC(&sb);
-
-  heap_.ProcessWeakPointers();
-  set_ports(Port::CleanupPorts(from, ports()));
-  heap_.ReplaceSpace(to);
-  UpdateStackLimit();
-  return visitor.number_of_stacks();
+  CompleteFullGarbageCollection(&visitor, &large_objects, from, to);
+  return scavenger.number_of_stacks();
 }
 
 int Process::CollectGarbageAndChainStacks() {
@@ -480,11 +786,17 @@ void Process::IterateRoots(PointerVisitor* visitor) {
   IteratePortQueuesPointers(visitor);
 }
 
+void Process::IterateRememberedPointers(PointerVisitor* visitor) {
+  heap_.space()->VisitDirtyCards(visitor);
+  survivor_space_->VisitDirtyCards(visitor);
+  old_space_->VisitDirtyCards(visitor);
+  large_space_->VisitDirtyCards(visitor);
+}
+
 void Process::IterateProgramPointers(PointerVisitor* visitor) {
   ASSERT(stacks_are_cooked());
   HeapObjectPointerVisitor program_pointer_visitor(visitor);
-  heap()->IterateObjects(&program_pointer_visitor);
-  store_buffer_.IteratePointersToImmutableSpace(visitor);
+  IterateHeapObjects(&program_pointer_visitor);
   if (debug_info_ != NULL) debug_info_->VisitProgramPointers(visitor);
   IteratePortQueuesPointers(visitor);
 }
@@ -501,6 +813,9 @@ void Process::TakeLookupCache() {
   ASSERT(state != NULL);
   LookupCache* cache = state->EnsureCache();
   primary_lookup_cache_ = cache->primary();
+  primary_lookup_cache_mask_ = cache->primary_mask();
+  inline_cache_ = state->EnsureInlineCache();
+  inline_cache_->Validate();
 }
 
 void Process::Preempt() {
@@ -715,7 +1030,7 @@ void Process::TakeQueue() {
 void Process::RegisterFinalizer(HeapObject* object,
                                 WeakPointerCallback callback) {
   uword address = object->address();
-  if (heap()->space()->Includes(address)) {
+  if (HeapIncludes(address)) {
     heap()->AddWeakPointer(object, callback);
   } else {
     ASSERT(immutable_heap()->space()->Includes(address));
@@ -727,14 +1042,15 @@ void Process::UnregisterFinalizer(HeapObject* object) {
   uword address = object->address();
   // We do not support unregistering weak pointers for the immutable heap (and
   // it is currently also not used for immutable objects).
-  ASSERT(heap()->space()->Includes(address));
+  ASSERT(HeapIncludes(address));
   heap()->RemoveWeakPointer(object);
 }
 
 void Process::FinalizeForeign(HeapObject* foreign) {
   Instance* instance = Instance::cast(foreign);
   word value = AsForeignWord(instance->GetInstanceField(0));
-  free(reinterpret_cast<void*>(value));
+  word length = AsForeignWord(instance->GetInstanceField(1));
+  FinalizerQueue::Enqueue(free, reinterpret_cast<void*>(value), length);
 }
 
 #ifdef DEBUG
@@ -767,7 +1083,6 @@ void Process::AdvanceCurrentMessage() {
 static void TakeExitReferenceHeaps(ExitReference* ref,
                                    Process* destination_process) {
   destination_process->heap()->MergeInOtherHeap(ref->mutable_heap());
-  destination_process->store_buffer()->Prepend(ref->store_buffer());
 }
 
 static void TakePortQueueHeaps(PortQueue* queue, Process* destination_process) {
@@ -821,9 +1136,13 @@ LookupCache::Entry* Process::LookupEntrySlow(LookupCache::Entry* primary,
   ASSERT(state != NULL);
   LookupCache* cache = state->cache();
 
-  uword index = LookupCache::ComputeSecondaryIndex(clazz, selector);
+  LookupCache::Statistics* statistics = cache->statistics();
+
+  uword index = cache->ComputeSecondaryIndex(clazz, selector);
   LookupCache::Entry* secondary = &(cache->secondary()[index]);
   if (secondary->clazz == clazz && secondary->selector == selector) {
+    if (Flags::lookup_cache_statistics) statistics->secondary_hits++;
+    cache->RecordMiss(false);
     return secondary;
   }
 
@@ -832,13 +1151,24 @@ LookupCache::Entry* Process::LookupEntrySlow(LookupCache::Entry* primary,
   if (target == NULL) {
     static const Names::Id name = Names::kNoSuchMethodTrampoline;
     target = clazz->LookupMethod(Selector::Encode(name, Selector::METHOD, 0));
+    if (Flags::lookup_cache_statistics) statistics->no_such_method++;
   } else {
     void* intrinsic = target->ComputeIntrinsic();
     tag = (intrinsic == NULL) ? 1 : reinterpret_cast<uword>(intrinsic);
   }
+  if (Flags::lookup_cache_statistics) statistics->lookups++;
 
   ASSERT(target != NULL);
-  cache->DemotePrimary(primary);
+  if (cache->RecordMiss(true)) {
+    // The cache has grown, so the primary entry is gone.
+    primary_lookup_cache_ = cache->primary();
+    primary_lookup_cache_mask_ = cache->primary_mask();
+    index = LookupCache::ComputePrimaryIndex(
+        clazz, selector, primary_lookup_cache_mask_);
+    primary = &(primary_lookup_cache_[index]);
+  } else {
+    cache->DemotePrimary(primary);
+  }
   primary->clazz = clazz;
   primary->selector = selector;
   primary->target = target;
@@ -846,6 +1176,15 @@ LookupCache::Entry* Process::LookupEntrySlow(LookupCache::Entry* primary,
   return primary;
 }
 
+InlineCache::Entry* Process::LookupInlineCacheEntrySlow(uint8* bcp,
+                                                        Class* clazz,
+                                                        int selector) {
+  ASSERT(!program()->is_compact());
+  inline_cache_->IncrementMisses();
+  LookupCache::Entry* entry = LookupEntry(clazz, selector);
+  return inline_cache_->Insert(bcp, clazz, entry->target, entry->tag);
+}
+
 NATIVE(ProcessQueueGetMessage) {
   PortQueue* queue = process->CurrentMessage();
   PortQueue::Kind kind = queue->kind();
@@ -871,7 +1210,7 @@ NATIVE(ProcessQueueGetMessage) {
       if (object == Failure::retry_after_gc()) return object;
       foreign->SetInstanceField(0, object);
       foreign->SetInstanceField(1, Smi::FromWord(queue->size()));
-      process->RecordStore(foreign, object);
+      process->RecordStore(foreign, Instance::kSize, object);
       if (kind == PortQueue::FOREIGN_FINALIZED) {
         process->RegisterFinalizer(foreign, Process::FinalizeForeign);
       }
@@ -6,13 +6,15 @@
 #define SRC_VM_PROCESS_H_
 
 #include "src/shared/atomic.h"
+#include "src/shared/flags.h"
 #include "src/shared/random.h"
 
 #include "src/vm/debug_info.h"
 #include "src/vm/heap.h"
+#include "src/vm/inline_cache.h"
 #include "src/vm/lookup_cache.h"
+#include "src/vm/object_memory.h"
 #include "src/vm/program.h"
-#include "src/vm/storebuffer.h"
 #include "src/vm/thread.h"
 
 namespace fletch {
@@ -20,10 +22,14 @@ namespace fletch {
 class Engine;
 class Interpreter;
 class ImmutableHeap;
+class MarkSweepCollector;
 class Port;
 class PortQueue;
+class Process;
 class ProcessQueue;
 class ProcessVisitor;
+class ProfileBuffer;
+template<typename T> class WorkStealingQueue;
 
 class ThreadState {
  public:
@@ -41,21 +47,52 @@ class ThreadState {
   // Update the thread field to point to the current thread.
   void AttachToCurrentThread();
 
+  // Queue of processes handed to this thread by other threads, or preempted
+  // on it. Processes in this queue are run in FIFO order.
   ProcessQueue* queue() { return queue_; }
 
+  // Processes made runnable by the process this thread is interpreting. Only
+  // the owning thread pushes and pops (LIFO); idle threads steal from it.
+  WorkStealingQueue<Process>* deque() { return deque_; }
+
+  RandomLCG* random() { return &random_; }
+
+  // Returns true every [kQueueCheckInterval] calls. Used to make sure the
+  // FIFO queue is not starved by the LIFO deque.
+  bool ShouldCheckQueueFirst() {
+    if (++dispatch_count_ < kQueueCheckInterval) return false;
+    dispatch_count_ = 0;
+    return true;
+  }
+
   LookupCache* cache() const { return cache_; }
   LookupCache* EnsureCache();
 
+  InlineCache* inline_cache() const { return inline_cache_; }
+  InlineCache* EnsureInlineCache();
+
+  // Samples taken while this thread was interpreting. Only used when
+  // profiling.
+  ProfileBuffer* profile_buffer() const { return profile_buffer_; }
+  ProfileBuffer* EnsureProfileBuffer();
+
   Monitor* idle_monitor() const { return idle_monitor_; }
 
   ThreadState* next_idle_thread() const { return next_idle_thread_; }
   void set_next_idle_thread(ThreadState* value) { next_idle_thread_ = value; }
 
  private:
+  static const int kQueueCheckInterval = 61;
+
   int thread_id_;
   ThreadIdentifier thread_;
   ProcessQueue* const queue_;
+  WorkStealingQueue<Process>* const deque_;
+  RandomLCG random_;
+  int dispatch_count_;
   LookupCache* cache_;
+  InlineCache* inline_cache_;
+  ProfileBuffer* profile_buffer_;
   Monitor* idle_monitor_;
   Atomic<ThreadState*> next_idle_thread_;
 };
@@ -89,10 +126,95 @@ class Process {
   int main_arity() { return program_->main_arity(); }
   Program* program() { return program_; }
   Array* statics() const { return statics_; }
+
+  // The process heap is split into generations. All objects are allocated
+  // in the nursery, which is the space of [heap]. Objects that survive a
+  // scavenge are copied to the survivor space, and objects that survive
+  // a second one are promoted to the old space. Large arrays are allocated
+  // in the large object space instead. They belong to the old generation,
+  // but they are never copied; full collections mark and sweep them. Weak
+  // pointers for all the generations are kept in [heap].
   Heap* heap() { return &heap_; }
+  Space* survivor_space() { return survivor_space_; }
+  Space* old_space() { return old_space_; }
+  Space* large_space() { return large_space_; }
+
+  // Returns true if the address is in any of the generations.
+  bool HeapIncludes(uword address) {
+    return heap_.space()->Includes(address) ||
+        survivor_space_->Includes(address) ||
+        old_space_->Includes(address) ||
+        large_space_->Includes(address);
+  }
+
+  bool IsOld(HeapObject* object) {
+    uword address = object->address();
+    return old_space_->Includes(address) || large_space_->Includes(address);
+  }
+
+  bool IsYoung(HeapObject* object) {
+    uword address = object->address();
+    return heap_.space()->Includes(address) ||
+        survivor_space_->Includes(address);
+  }
+
+  // Returns the total size of the objects in all the generations.
+  int HeapUsed() {
+    return heap_.Used() + survivor_space_->Used() + old_space_->Used() +
+        large_space_->Used();
+  }
+
+  // The limit of [HeapUsed], or 0 for no limit. An allocation that would
+  // go past it triggers a full collection, and if it still does not fit
+  // the process is out of memory.
+  int heap_limit() const { return heap_limit_; }
+  void SetHeapLimit(int limit);
+
+  // Tells whether the last collection left the process out of memory.
+  // [TakeOutOfMemory] also clears it. The interpreter then throws an out
+  // of memory exception instead of retrying the allocation.
+  bool out_of_memory() const { return out_of_memory_; }
+  bool TakeOutOfMemory() {
+    bool result = out_of_memory_;
+    out_of_memory_ = false;
+    return result;
+  }
+
+  // Set when an out of memory exception is not caught. The scheduler then
+  // terminates the process instead of the whole VM.
+  bool uncaught_out_of_memory() const { return uncaught_out_of_memory_; }
+  void set_uncaught_out_of_memory() { uncaught_out_of_memory_ = true; }
+
+  // Allocation profiling. A sample is pending when an allocation failed
+  // because it reached a sample point, see [Space::ScheduleSample]. The
+  // sample must be recorded before the allocation is retried.
+  bool allocation_sample_pending() {
+    return heap_.space()->sample_pending() || large_space_->sample_pending();
+  }
+  void RecordAllocationSample();
+
+  // Tells whether allocating in the process heap may fail.
+  bool needs_garbage_collection() {
+    return heap_.needs_garbage_collection() ||
+        large_space_->needs_garbage_collection();
+  }
+
+  void IterateHeapObjects(HeapObjectVisitor* visitor);
+
+  // Move all objects into the nursery, leaving the survivor, old and large
+  // object spaces empty.
+  void MergeGenerations();
+
   Heap* immutable_heap() { return immutable_heap_; }
   void set_immutable_heap(Heap* heap) { immutable_heap_ = heap; }
 
+  // Tells whether the immutable heap must be collected before a failed
+  // allocation is retried. If the allocation hit the limit of the
+  // immutable heap, and it would not fit even if only the objects that
+  // survived the last immutable collection were left, the process is out
+  // of memory instead.
+  bool NeedsImmutableGarbageCollection();
+
   Coroutine* coroutine() const { return coroutine_; }
   void UpdateCoroutine(Coroutine* coroutine);
 
@@ -106,12 +228,24 @@ class Process {
   StackCheckResult HandleStackOverflow(int addition);
 
   inline LookupCache::Entry* LookupEntry(Object* receiver, int selector);
+  inline LookupCache::Entry* LookupEntry(Class* clazz, int selector);
+
+  // Lookup the target of the invoke at [bcp] through its inline cache.
+  inline InlineCache::Entry* LookupInlineCacheEntry(uint8* bcp,
+                                                    Object* receiver,
+                                                    int selector);
 
     // Lookup and update the primary cache entry.
   LookupCache::Entry* LookupEntrySlow(LookupCache::Entry* primary,
                                       Class* clazz,
                                       int selector);
 
+  // Lookup the target through the lookup cache and add it to the inline
+  // cache of the invoke at [bcp].
+  InlineCache::Entry* LookupInlineCacheEntrySlow(uint8* bcp,
+                                                 Class* clazz,
+                                                 int selector);
+
   Object* NewArray(int length);
   Object* NewDouble(double value);
   Object* NewInteger(int64 value);
@@ -155,6 +289,10 @@ class Process {
   // Iterate all pointers reachable from this process object.
   void IterateRoots(PointerVisitor* visitor);
 
+  // Iterate the pointers in the dirty cards of all the generations. They
+  // include all the pointers to the immutable heap.
+  void IterateRememberedPointers(PointerVisitor* visitor);
+
   // Iterate all pointers in the process heap and stack. Used for
   // program garbage collection.
   void IterateProgramPointers(PointerVisitor* visitor);
@@ -178,7 +316,10 @@ class Process {
   void set_next(Process* process) { next_ = process; }
 
   void TakeLookupCache();
-  void ReleaseLookupCache() { primary_lookup_cache_ = NULL; }
+  void ReleaseLookupCache() {
+    primary_lookup_cache_ = NULL;
+    inline_cache_ = NULL;
+  }
 
   // Program GC support. Cook the stack to rewrite bytecode pointers
   // to a pair of a function pointer and a delta. Uncook the stack to
@@ -244,24 +385,34 @@ class Process {
   static uword PrimaryLookupCacheOffset() {
     return OFFSET_OF(Process, primary_lookup_cache_);
   }
+  static uword PrimaryLookupCacheMaskOffset() {
+    return OFFSET_OF(Process, primary_lookup_cache_mask_);
+  }
 
   void StoreErrno();
   void RestoreErrno();
 
   RandomLCG* random() { return &random_; }
 
-  StoreBuffer* store_buffer() { return &store_buffer_; }
-
-  void RecordStore(HeapObject* object, Object* value) {
-    if (value->IsHeapObject() && value->IsImmutable()) {
-      ASSERT(!program()->heap()->space()->Includes(
-          object->address()));
-      ASSERT(heap()->space()->Includes(
-          object->address()));
-      store_buffer_.Insert(object);
+  // Write barrier for storing [value] in the field at [offset] in
+  // [object]. Marks the card of the field if it has to be remembered: if
+  // [value] is in the immutable heap, or if [object] is old and [value] is
+  // young.
+  void RecordStore(HeapObject* object, int offset, Object* value) {
+    if (NeedsRemembering(object, value)) {
+      ObjectMemory::MarkCard(object->address() + offset);
     }
   }
 
+  // Marks all the cards of [object]. Used for objects that are written
+  // without write barriers, like stacks and newly initialized objects.
+  void RememberObject(HeapObject* object) {
+    ASSERT(HeapIncludes(object->address()));
+    uword address = object->address();
+    ObjectMemory::ChunkFor(address)->MarkCards(address,
+                                               address + object->Size());
+  }
+
  private:
   friend class Interpreter;
   friend class Engine;
@@ -273,6 +424,39 @@ class Process {
 
   void UpdateStackLimit();
 
+  // Schedules the next allocation sample in [space], if allocations are
+  // profiled.
+  void ScheduleAllocationSample(Space* space);
+
+  // Scavenge the young generation, promoting the objects that have already
+  // survived a scavenge. Returns the number of bytes promoted.
+  int CollectYoungGarbage();
+
+  // Collect all the generations.
+  void CollectFullGarbage();
+
+  // Move the survivor and old spaces into the nursery, so a full
+  // collection can copy them. The large object space stays where it is.
+  void MergeCopiedGenerations();
+
+  // Finish a collection of all the generations. The copied generations
+  // have been merged into [from], and the roots have been scavenged into
+  // [to] by [visitor], which also marks the large objects it finds with
+  // [large_objects]. All the survivors end up in the old space, except for
+  // the large objects which are swept in place.
+  void CompleteFullGarbageCollection(PointerVisitor* visitor,
+                                     MarkSweepCollector* large_objects,
+                                     Space* from,
+                                     Space* to);
+
+  // Give the nursery a fresh space with room for a young generation
+  // proportional to the heap size.
+  void ReplaceNursery();
+
+  // Limit the nursery and the large object space to the room left under
+  // the heap limit.
+  void UpdateHeapLimit();
+
   // Put 'entry' at the end of the port's queue. This function is thread safe.
   void EnqueueEntry(PortQueue* entry);
 
@@ -281,11 +465,27 @@ class Process {
   void set_process_list_prev(Process* process) { process_list_prev_ = process; }
   Process* process_list_prev() { return process_list_prev_; }
 
+  bool NeedsRemembering(HeapObject* object, Object* value) {
+    if (!value->IsHeapObject()) return false;
+    if (value->IsImmutable() ||
+        (IsOld(object) && IsYoung(HeapObject::cast(value)))) {
+      ASSERT(!program()->heap()->space()->Includes(object->address()));
+      ASSERT(HeapIncludes(object->address()));
+      return true;
+    }
+    return false;
+  }
+
   RandomLCG random_;
 
   Heap heap_;
+  Space* survivor_space_;
+  Space* old_space_;
+  Space* large_space_;
+  int heap_limit_;
+  bool out_of_memory_;
+  bool uncaught_out_of_memory_;
   Heap* immutable_heap_;
-  StoreBuffer store_buffer_;
   Program* program_;
   Array* statics_;
 
@@ -295,10 +495,12 @@ class Process {
   Atomic<State> state_;
   Atomic<ThreadState*> thread_state_;
 
-  // We need extremely fast access to the primary lookup cache, so we
-  // store a reference to it in the process whenever we're interpreting
-  // code in this process.
+  // We need extremely fast access to the primary lookup cache and the
+  // inline caches, so we store references to them in the process
+  // whenever we're interpreting code in this process.
   LookupCache::Entry* primary_lookup_cache_;
+  uword primary_lookup_cache_mask_;
+  InlineCache* inline_cache_;
 
   List<List<int>> cooked_stack_deltas_;
 
@@ -345,13 +547,39 @@ inline LookupCache::Entry* Process::LookupEntry(Object* receiver,
   Class* clazz = receiver->IsSmi()
       ? program()->smi_class()
       : HeapObject::cast(receiver)->get_class();
+  return LookupEntry(clazz, selector);
+}
+
+inline LookupCache::Entry* Process::LookupEntry(Class* clazz, int selector) {
   ASSERT(primary_lookup_cache_ != NULL);
 
-  uword index = LookupCache::ComputePrimaryIndex(clazz, selector);
+  uword index = LookupCache::ComputePrimaryIndex(
+      clazz, selector, primary_lookup_cache_mask_);
   LookupCache::Entry* primary = &(primary_lookup_cache_[index]);
-  return (primary->clazz == clazz && primary->selector == selector)
-      ? primary
-      : LookupEntrySlow(primary, clazz, selector);
+  if (primary->clazz != clazz || primary->selector != selector) {
+    return LookupEntrySlow(primary, clazz, selector);
+  }
+  if (Flags::lookup_cache_statistics) {
+    ThreadState* state = thread_state_;
+    state->cache()->statistics()->primary_hits++;
+  }
+  return primary;
+}
+
+inline InlineCache::Entry* Process::LookupInlineCacheEntry(uint8* bcp,
+                                                           Object* receiver,
+                                                           int selector) {
+  ASSERT(!program()->is_compact());
+
+  Class* clazz = receiver->IsSmi()
+      ? program()->smi_class()
+      : HeapObject::cast(receiver)->get_class();
+  ASSERT(inline_cache_ != NULL);
+
+  InlineCache::Entry* entry = inline_cache_->Lookup(bcp, clazz);
+  if (entry == NULL) return LookupInlineCacheEntrySlow(bcp, clazz, selector);
+  inline_cache_->IncrementHits();
+  return entry;
 }
 
 inline bool Process::ChangeState(State from, State to) {
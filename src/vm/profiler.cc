@@ -0,0 +1,213 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/profiler.h"
+
+#include <stdio.h>
+
+#include "src/shared/utils.h"
+#include "src/vm/object.h"
+#include "src/vm/process.h"
+#include "src/vm/stack_walker.h"
+
+namespace fletch {
+
+// Walks at most [ProfileBuffer::kMaxDepth] frames of the stack of
+// [process], innermost first. Returns the number of frames.
+static int WalkStack(Process* process,
+                     Function** functions,
+                     int* bytecode_indices) {
+  int depth = 0;
+  StackWalker walker(process, process->stack());
+  while (depth < ProfileBuffer::kMaxDepth && walker.MoveNext()) {
+    Function* function = walker.function();
+    uint8* start = function->bytecode_address_for(0);
+    functions[depth] = function;
+    bytecode_indices[depth] = walker.return_address() - start;
+    depth++;
+  }
+  return depth;
+}
+
+void ProfileBuffer::RecordSample(Process* process) {
+  if (used_ + 1 + 2 * kMaxDepth > kCapacity) {
+    dropped_++;
+    return;
+  }
+  Function* functions[kMaxDepth];
+  int bytecode_indices[kMaxDepth];
+  int depth = WalkStack(process, functions, bytecode_indices);
+  uword* sample = words_ + used_;
+  sample[0] = depth;
+  for (int i = 0; i < depth; i++) {
+    sample[1 + 2 * i] = reinterpret_cast<uword>(functions[i]);
+    sample[2 + 2 * i] = bytecode_indices[i];
+  }
+  used_ += 1 + 2 * depth;
+}
+
+void ProfileBuffer::FlushTo(Profile* profile) {
+  Function* functions[kMaxDepth];
+  int bytecode_indices[kMaxDepth];
+  int position = 0;
+  while (position < used_) {
+    int depth = words_[position++];
+    for (int i = 0; i < depth; i++) {
+      functions[i] = reinterpret_cast<Function*>(words_[position++]);
+      bytecode_indices[i] = words_[position++];
+    }
+    profile->AddSample(functions, bytecode_indices, depth);
+  }
+  if (dropped_ > 0) profile->AddDroppedSamples(dropped_);
+  used_ = 0;
+  dropped_ = 0;
+}
+
+ProfileNode::~ProfileNode() {
+  ProfileNode* child = first_child_;
+  while (child != NULL) {
+    ProfileNode* next = child->next_sibling_;
+    delete child;
+    child = next;
+  }
+}
+
+ProfileNode* ProfileNode::FindOrAddChild(Function* function,
+                                         int bytecode_index) {
+  ProfileNode* previous = NULL;
+  for (ProfileNode* child = first_child_;
+       child != NULL;
+       child = child->next_sibling_) {
+    if (child->function_ == function &&
+        child->bytecode_index_ == bytecode_index) {
+      // Keep hot children at the front of the list.
+      if (previous != NULL) {
+        previous->next_sibling_ = child->next_sibling_;
+        child->next_sibling_ = first_child_;
+        first_child_ = child;
+      }
+      return child;
+    }
+    previous = child;
+  }
+  ProfileNode* child = new ProfileNode(function, bytecode_index, this);
+  child->next_sibling_ = first_child_;
+  first_child_ = child;
+  return child;
+}
+
+Profile::Profile(int sample_weight)
+    : mutex_(Platform::CreateMutex()),
+      sample_weight_(sample_weight),
+      root_(new ProfileNode(NULL, 0, NULL)),
+      sample_count_(0),
+      dropped_count_(0) {
+}
+
+Profile::~Profile() {
+  delete root_;
+  delete mutex_;
+}
+
+void Profile::AddSample(Function** functions,
+                        int* bytecode_indices,
+                        int depth) {
+  ScopedLock locker(mutex_);
+  ProfileNode* node = root_;
+  for (int i = depth - 1; i >= 0; i--) {
+    node = node->FindOrAddChild(functions[i], bytecode_indices[i]);
+  }
+  node->count_++;
+  sample_count_++;
+}
+
+void Profile::RecordSample(Process* process) {
+  Function* functions[ProfileBuffer::kMaxDepth];
+  int bytecode_indices[ProfileBuffer::kMaxDepth];
+  int depth = WalkStack(process, functions, bytecode_indices);
+  AddSample(functions, bytecode_indices, depth);
+}
+
+void Profile::AddDroppedSamples(int count) {
+  ScopedLock locker(mutex_);
+  dropped_count_ += count;
+}
+
+void Profile::IteratePointers(PointerVisitor* visitor) {
+  ProfileNode* node = root_->first_child_;
+  while (node != NULL) {
+    visitor->Visit(reinterpret_cast<Object**>(&node->function_));
+    if (node->first_child_ != NULL) {
+      node = node->first_child_;
+      continue;
+    }
+    while (node != root_ && node->next_sibling_ == NULL) {
+      node = node->parent_;
+    }
+    node = (node == root_) ? NULL : node->next_sibling_;
+  }
+}
+
+static void VisitNode(ProfileNode* node,
+                      ProfileNode** frames,
+                      int depth,
+                      ProfileStackVisitor* visitor) {
+  if (node->count() > 0) visitor->VisitStack(frames, depth, node->count());
+  for (ProfileNode* child = node->first_child();
+       child != NULL;
+       child = child->next_sibling()) {
+    frames[depth] = child;
+    VisitNode(child, frames, depth + 1, visitor);
+  }
+}
+
+void Profile::VisitStacks(ProfileStackVisitor* visitor) {
+  ScopedLock locker(mutex_);
+  ProfileNode* frames[ProfileBuffer::kMaxDepth];
+  VisitNode(root_, frames, 0, visitor);
+}
+
+class FoldedStackPrinter : public ProfileStackVisitor {
+ public:
+  FoldedStackPrinter(FILE* file, int sample_weight)
+      : file_(file), sample_weight_(sample_weight) { }
+
+  void VisitStack(ProfileNode** frames, int depth, int count) {
+    // Each frame takes up at most 19 characters: a separator and a 64-bit
+    // address in hex.
+    char line[ProfileBuffer::kMaxDepth * 20 + 1];
+    int length = 0;
+    line[0] = '\0';
+    for (int i = 0; i < depth; i++) {
+      length += snprintf(line + length, sizeof(line) - length, "%s%p",
+                         i == 0 ? "" : ";",
+                         reinterpret_cast<void*>(frames[i]->function()));
+    }
+    long long weight = count;  // NOLINT
+    weight *= sample_weight_;
+    if (file_ != NULL) {
+      fprintf(file_, "%s %lld\n", line, weight);
+    } else {
+      Print::Out("%s %lld\n", line, weight);
+    }
+  }
+
+ private:
+  FILE* const file_;
+  const int sample_weight_;
+};
+
+bool Profile::PrintFoldedStacks(const char* path) {
+  FILE* file = NULL;
+  if (path != NULL) {
+    file = fopen(path, "w");
+    if (file == NULL) return false;
+  }
+  FoldedStackPrinter printer(file, sample_weight_);
+  VisitStacks(&printer);
+  if (file != NULL) fclose(file);
+  return true;
+}
+
+}  // namespace fletch
@@ -0,0 +1,140 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_PROFILER_H_
+#define SRC_VM_PROFILER_H_
+
+#include "src/shared/globals.h"
+#include "src/shared/platform.h"
+
+namespace fletch {
+
+class Function;
+class PointerVisitor;
+class Process;
+class Profile;
+
+// Samples recorded by a single interpreter thread. Each sample is the
+// interpreter stack of the process that was running when the profile
+// interrupt hit, as (function, bytecode index) pairs. The buffer is only
+// touched by the thread that owns it, so recording a sample never takes a
+// lock. The samples are moved into the program-wide [Profile] when the
+// thread is done interpreting the process.
+class ProfileBuffer {
+ public:
+  // Deeper stacks are cut off, keeping the innermost frames.
+  static const int kMaxDepth = 64;
+
+  ProfileBuffer() : used_(0), dropped_(0) { }
+
+  // Record the stack of [process], which must be stopped in a stack check.
+  void RecordSample(Process* process);
+
+  // Add all the samples to [profile] and empty the buffer.
+  void FlushTo(Profile* profile);
+
+  bool is_empty() const { return used_ == 0 && dropped_ == 0; }
+
+ private:
+  // Each sample takes up one word for its depth followed by two words per
+  // frame.
+  static const int kCapacity = 32 * (1 + 2 * kMaxDepth);
+
+  uword words_[kCapacity];
+  int used_;
+  // Samples that did not fit.
+  int dropped_;
+};
+
+class ProfileNode {
+ public:
+  Function* function() const { return function_; }
+  int bytecode_index() const { return bytecode_index_; }
+
+  // Number of samples where this was the innermost frame.
+  int count() const { return count_; }
+
+  ProfileNode* first_child() const { return first_child_; }
+  ProfileNode* next_sibling() const { return next_sibling_; }
+
+ private:
+  friend class Profile;
+
+  ProfileNode(Function* function, int bytecode_index, ProfileNode* parent)
+      : function_(function), bytecode_index_(bytecode_index), count_(0),
+        parent_(parent), first_child_(NULL), next_sibling_(NULL) { }
+  ~ProfileNode();
+
+  ProfileNode* FindOrAddChild(Function* function, int bytecode_index);
+
+  Function* function_;
+  int bytecode_index_;
+  int count_;
+  ProfileNode* parent_;
+  ProfileNode* first_child_;
+  ProfileNode* next_sibling_;
+};
+
+class ProfileStackVisitor {
+ public:
+  virtual ~ProfileStackVisitor() { }
+
+  // Called once for each distinct stack that was sampled. The [depth]
+  // frames are ordered outermost first.
+  virtual void VisitStack(ProfileNode** frames, int depth, int count) = 0;
+};
+
+// Aggregated call tree of all the samples taken in a program. Every path
+// from the root is a distinct stack, outermost frame first.
+//
+// The nodes point to functions in the program heap, so the tree must be
+// visited by program GCs. Samples can be added concurrently from all the
+// interpreter threads.
+//
+// Each sample stands for [sample_weight] units of whatever is sampled: one
+// tick for the execution profile, and the mean distance between samples in
+// bytes for the allocation profile.
+class Profile {
+ public:
+  explicit Profile(int sample_weight = 1);
+  ~Profile();
+
+  // Add a sample of [depth] frames, innermost first.
+  void AddSample(Function** functions, int* bytecode_indices, int depth);
+  void AddDroppedSamples(int count);
+
+  // Add a sample of the stack of [process], which must have saved its
+  // state. Takes the lock for every sample, so it is only for samples
+  // that are rare.
+  void RecordSample(Process* process);
+
+  int sample_weight() const { return sample_weight_; }
+
+  int sample_count() const { return sample_count_; }
+  int dropped_count() const { return dropped_count_; }
+
+  // Visit all the stacks. No samples can be added while visiting.
+  void VisitStacks(ProfileStackVisitor* visitor);
+
+  void IteratePointers(PointerVisitor* visitor);
+
+  // Print the stacks in the folded format used by flame graph tools: one
+  // line per stack, with the frames separated by ';' and followed by the
+  // number of samples times the sample weight. The VM does not know the
+  // names of functions, so they are printed as addresses; a session can
+  // get the stacks with function ids instead. Prints to [path], or to
+  // stdout if it is NULL. Returns false if the file could not be written.
+  bool PrintFoldedStacks(const char* path);
+
+ private:
+  Mutex* const mutex_;
+  const int sample_weight_;
+  ProfileNode* root_;
+  int sample_count_;
+  int dropped_count_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_PROFILER_H_
@@ -0,0 +1,73 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/object.h"
+#include "src/vm/profiler.h"
+
+namespace fletch {
+
+// The profile never dereferences the functions, so any distinct values will
+// do.
+static Function* FakeFunction(int i) {
+  return reinterpret_cast<Function*>(static_cast<uword>(i + 1) << 4);
+}
+
+class StackCollector : public ProfileStackVisitor {
+ public:
+  StackCollector() : stacks_(0), samples_(0), deepest_(0) { }
+
+  void VisitStack(ProfileNode** frames, int depth, int count) {
+    stacks_++;
+    samples_ += count;
+    if (depth > deepest_) deepest_ = depth;
+    // The outermost frame is always main.
+    EXPECT_EQ(frames[0]->function(), FakeFunction(0));
+    if (depth == 3) {
+      EXPECT_EQ(frames[1]->function(), FakeFunction(1));
+      EXPECT_EQ(frames[1]->bytecode_index(), 5);
+      EXPECT_EQ(frames[2]->function(), FakeFunction(2));
+      EXPECT_EQ(count, frames[0]->bytecode_index() == 3 ? 2 : 1);
+    }
+  }
+
+  int stacks() const { return stacks_; }
+  int samples() const { return samples_; }
+  int deepest() const { return deepest_; }
+
+ private:
+  int stacks_;
+  int samples_;
+  int deepest_;
+};
+
+TEST_CASE(Profile_Aggregate) {
+  Profile profile;
+
+  // Samples are added innermost frame first.
+  Function* functions[3] = { FakeFunction(2), FakeFunction(1),
+                             FakeFunction(0) };
+  int indices[3] = { 7, 5, 3 };
+  profile.AddSample(functions, indices, 3);
+  profile.AddSample(functions, indices, 3);
+  // Same functions, but called from a different bytecode in main.
+  indices[2] = 9;
+  profile.AddSample(functions, indices, 3);
+  // Only main.
+  profile.AddSample(functions + 2, indices + 2, 1);
+  profile.AddDroppedSamples(4);
+
+  EXPECT_EQ(profile.sample_count(), 4);
+  EXPECT_EQ(profile.dropped_count(), 4);
+
+  StackCollector collector;
+  profile.VisitStacks(&collector);
+  EXPECT_EQ(collector.stacks(), 3);
+  EXPECT_EQ(collector.samples(), 4);
+  EXPECT_EQ(collector.deepest(), 3);
+}
+
+}  // namespace fletch
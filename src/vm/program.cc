@@ -7,6 +7,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <vector>
+
+#include "src/shared/bytecodes.h"
 #include "src/shared/flags.h"
 #include "src/shared/globals.h"
 #include "src/shared/names.h"
@@ -15,9 +19,13 @@
 #include "src/shared/utils.h"
 
 #include "src/vm/heap_validator.h"
+#include "src/vm/inline_cache.h"
+#include "src/vm/mark_sweep.h"
 #include "src/vm/object.h"
+#include "src/vm/parallel_scavenger.h"
 #include "src/vm/process.h"
 #include "src/vm/port.h"
+#include "src/vm/profiler.h"
 #include "src/vm/session.h"
 
 namespace fletch {
@@ -39,6 +47,15 @@ Program::Program()
       random_(0),
       heap_(&random_),
       scheduler_(NULL),
+      event_handler_count_(
+          Flags::event_handlers > 0 ? Flags::event_handlers : 1),
+      event_handlers_(new EventHandler[event_handler_count_]),
+      profile_(Flags::profile ? new Profile() : NULL),
+      allocation_profile_(Flags::profile_allocations
+          ? new Profile(Flags::allocation_sample_interval)
+          : NULL),
+      gc_mutex_(Platform::CreateMutex()),
+      compact_immutable_heap_(false),
       session_(NULL),
       entry_(NULL),
       classes_(NULL),
@@ -51,7 +68,18 @@ Program::Program()
 }
 
 Program::~Program() {
+  if (Flags::print_gc_statistics) {
+    immutable_scavenge_pauses_.PrintStatistics("Immutable scavenge pauses");
+    immutable_marking_pauses_.PrintStatistics("Immutable marking pauses");
+    ObjectMemory::PrintStatistics();
+  }
+  delete[] event_handlers_;
+  delete profile_;
+  delete allocation_profile_;
+  delete gc_mutex_;
   delete process_list_mutex_;
+  // The addresses of the program's objects may be reused.
+  InlineCache::FlushAll();
   ASSERT(process_list_head_ == NULL);
 }
 
@@ -65,6 +93,7 @@ Process* Program::ProcessSpawnForMain() {
   if (Flags::print_program_statistics) {
     PrintStatistics();
   }
+  if (Flags::print_bytecode_pairs) PrintBytecodePairs();
 
 #ifdef DEBUG
   // TODO(ager): GC for testing only.
@@ -202,6 +231,9 @@ void Program::PrepareProgramGC(bool disable_heap_validation_before_gc) {
 }
 
 void Program::PerformProgramGC(Space* to, PointerVisitor* visitor) {
+  // Inline caches refer to bytecodes, literals and classes by address.
+  InlineCache::FlushAll();
+
   {
     NoAllocationFailureScope scope(to);
 
@@ -219,6 +251,11 @@ void Program::PerformProgramGC(Space* to, PointerVisitor* visitor) {
       current = current->process_list_next();
     }
 
+    if (profile_ != NULL) profile_->IteratePointers(visitor);
+    if (allocation_profile_ != NULL) {
+      allocation_profile_->IteratePointers(visitor);
+    }
+
     // Finish collection.
     ASSERT(!to->is_empty());
     to->CompleteScavenge(visitor);
@@ -274,20 +311,27 @@ void Program::ValidateHeapsAreConsistent() {
 }
 
 void Program::CollectGarbage() {
+  ScopedLock locker(gc_mutex_);
+  GcEvent event(GcEvent::kProgram, 0, Platform::GetMicroseconds());
   if (scheduler() != NULL) {
     scheduler()->StopProgram(this);
+    event.wait = Platform::GetMicroseconds() - event.start;
   }
 
-  Space* to = new Space(heap_.space()->Used() / 10);
+  event.size_before = heap_.space()->Used();
+  Space* to = new Space(event.size_before / 10);
   ScavengeVisitor scavenger(heap_.space(), to);
 
   PrepareProgramGC();
   PerformProgramGC(to, &scavenger);
   FinishProgramGC();
+  event.size_after = heap_.space()->Used();
 
   if (scheduler() != NULL) {
     scheduler()->ResumeProgram(this);
   }
+  event.end = Platform::GetMicroseconds();
+  gc_events_.Record(event);
 }
 
 void Program::AddToProcessList(Process* process) {
@@ -319,13 +363,43 @@ void Program::RemoveFromProcessList(Process* process) {
   process->set_process_list_prev(NULL);
 }
 
+// The roots of the immutable heap are all in the processes: their own roots
+// and the pointers in the dirty cards of their heaps. Each process is a
+// partition, so a process is only ever scanned by one scavenger thread.
+class ProcessRoots : public ScavengeRoots {
+ public:
+  void Add(Process* process) { processes_.push_back(process); }
+
+  int NumberOfPartitions() { return processes_.size(); }
+
+  void VisitPartition(int index, PointerVisitor* visitor) {
+    Process* process = processes_[index];
+    process->IterateRoots(visitor);
+    process->IterateRememberedPointers(visitor);
+  }
+
+ private:
+  std::vector<Process*> processes_;
+};
+
+// Starting threads costs more than it saves on small heaps.
+static int NumberOfImmutableGCThreads(int heap_size) {
+  static const int kMinimumParallelHeapSize = 1 * MB;
+  if (heap_size < kMinimumParallelHeapSize) return 1;
+  if (Flags::gc_threads > 0) return Flags::gc_threads;
+  return Platform::GetNumberOfHardwareThreads();
+}
+
 void Program::CollectImmutableGarbage() {
   Scheduler* scheduler = this->scheduler();
   ASSERT(scheduler != NULL);
 
+  uint64 start = Platform::GetMicroseconds();
+
   // This will make sure all partial immutable heaps got merged into
   // [program_->immutable_heap()].
   scheduler->StopProgram(this);
+  uint64 wait = Platform::GetMicroseconds() - start;
 
   // All threads are stopped and have given their parts back to the
   // [ImmutableHeap], so we can merge them now.
@@ -335,51 +409,144 @@ void Program::CollectImmutableGarbage() {
     ValidateHeapsAreConsistent();
   }
 
-  // Pass 1: Storebuffer compaction.
-  // We do this as a separate pass to ensure the mutable collection can access
-  // all objects (including immutable ones) and for example do
-  // "ASSERT(object->IsImmutable()". If we did everthing in one pass some
-  // immutable objects will contain forwarding pointers and others won't, which
-  // can make the mentioned assert just crash the program.
-  {
-    Process* current = process_list_head_;
-    while (current != NULL) {
-      current->store_buffer()->Deduplicate();
-      current = current->process_list_next();
-    }
+  // Iterate all process roots to immutable heap.
+  if (Flags::concurrent_immutable_gc && !compact_immutable_heap_) {
+    MarkAndSweepImmutableHeap(start, wait);
+  } else {
+    ScavengeImmutableHeap(start, wait);
   }
+}
 
-  // Pass 2: Iterate all process roots to immutable heap.
-  {
-    Heap* heap = immutable_heap()->heap();
-    Space* from = heap->space();
-    Space* to = new Space(from->Used() / 10);
-    NoAllocationFailureScope alloc(to);
+void Program::ScavengeImmutableHeap(uint64 start, uint64 wait) {
+  Heap* heap = immutable_heap()->heap();
+  Space* from = heap->space();
+  int used_before = from->Used();
 
-    ScavengeVisitor scavenger(from, to);
+  int process_heap_sizes = 0;
+  ProcessRoots roots;
+  Process* current = process_list_head_;
+  while (current != NULL) {
+    current->TakeChildHeaps();
+    roots.Add(current);
+    process_heap_sizes += current->HeapUsed();
+    current = current->process_list_next();
+  }
 
-    int process_heap_sizes = 0;
-    Process* current = process_list_head_;
-    while (current != NULL) {
-      current->TakeChildHeaps();
-      current->IterateRoots(&scavenger);
-      current->store_buffer()->IteratePointersToImmutableSpace(&scavenger);
-      process_heap_sizes += current->heap()->space()->Used();
-      current = current->process_list_next();
-    }
+  ParallelScavenger scavenger(from, NumberOfImmutableGCThreads(used_before));
+  Space* to = scavenger.Scavenge(&roots);
+  heap->ProcessWeakPointers();
+  heap->ReplaceSpace(to);
+  compact_immutable_heap_ = false;
 
-    to->CompleteScavenge(&scavenger);
-    heap->ProcessWeakPointers();
-    heap->ReplaceSpace(to);
+  immutable_heap()->UpdateLimitAfterImmutableGC(process_heap_sizes);
 
-    immutable_heap()->UpdateLimitAfterImmutableGC(process_heap_sizes);
+  if (Flags::validate_heaps) {
+    ValidateHeapsAreConsistent();
   }
 
+  scheduler()->ResumeProgram(this);
+
+  uint64 end = Platform::GetMicroseconds();
+  uint64 pause = end - start;
+  immutable_scavenge_pauses_.Record(pause);
+  GcEvent event(GcEvent::kImmutableScavenge, 0, start);
+  event.end = end;
+  event.size_before = used_before;
+  event.size_after = to->Used();
+  event.wait = wait;
+  gc_events_.Record(event);
+  if (Flags::print_gc_statistics) {
+    Print::Out("Immutable scavenge: %d -> %d bytes, %d threads, %d us\n",
+               used_before,
+               to->Used(),
+               scavenger.number_of_workers(),
+               static_cast<int>(pause));
+    ObjectMemory::PrintStatistics();
+  }
+}
+
+// The immutable heap is collected with a mark-sweep collection that does
+// most of its marking while the program runs. Immutable objects are never
+// written after they have been allocated, so the only pointers into the
+// heap that can change are the ones in process roots and mutable objects.
+// They are all marked in the first pause, which makes that pause the
+// snapshot of everything that is live: no write barrier is needed to keep
+// it, and the rest of the marking only follows pointers between immutable
+// objects. Objects allocated during marking go to heap parts that are not
+// merged until the final pause, so they all survive.
+void Program::MarkAndSweepImmutableHeap(uint64 start, uint64 wait) {
+  // Scanning this many objects between checks keeps the gc mutex from
+  // being held for long.
+  static const int kMarkingStepSize = 1024;
+
+  Heap* heap = immutable_heap()->heap();
+  Space* space = heap->space();
+  int used_before = space->Used();
+
+  int process_heap_sizes = 0;
+  MarkSweepCollector collector(space);
+  Process* current = process_list_head_;
+  while (current != NULL) {
+    current->TakeChildHeaps();
+    current->IterateRoots(&collector);
+    current->IterateRememberedPointers(&collector);
+    process_heap_sizes += current->HeapUsed();
+    current = current->process_list_next();
+  }
+
+  Scheduler* scheduler = this->scheduler();
+  scheduler->ResumeProgram(this);
+  uint64 first_pause = Platform::GetMicroseconds() - start;
+  immutable_marking_pauses_.Record(first_pause);
+
+  bool done = false;
+  while (!done) {
+    // Give up if the GC thread is asked to pause, since whoever asks will
+    // have stopped the program and might change the classes.
+    if (scheduler->IsGcThreadPauseRequested()) return;
+    ScopedLock locker(gc_mutex_);
+    done = collector.ProcessMarkingStack(kMarkingStepSize);
+  }
+  uint64 marking = Platform::GetMicroseconds() - start - first_pause;
+
+  uint64 final_start = Platform::GetMicroseconds();
+  scheduler->StopProgram(this);
+  wait += Platform::GetMicroseconds() - final_start;
+
+  // The parts allocated since the first pause are still unmerged, so their
+  // weak pointers and objects are left alone.
+  heap->ProcessWeakPointers(&collector);
+  collector.Sweep(byte_array_class());
+  compact_immutable_heap_ = collector.live_bytes() < space->Used() / 2;
+  immutable_heap()->MergeParts();
+
+  immutable_heap()->UpdateLimitAfterImmutableGC(process_heap_sizes);
+
   if (Flags::validate_heaps) {
     ValidateHeapsAreConsistent();
   }
 
   scheduler->ResumeProgram(this);
+
+  uint64 end = Platform::GetMicroseconds();
+  uint64 final_pause = end - final_start;
+  immutable_marking_pauses_.Record(final_pause);
+  GcEvent event(GcEvent::kImmutableMarkSweep, 0, start);
+  event.end = end;
+  event.size_before = used_before;
+  event.size_after = collector.live_bytes();
+  event.wait = wait;
+  gc_events_.Record(event);
+  if (Flags::print_gc_statistics) {
+    Print::Out("Immutable mark-sweep: %d -> %d live bytes, "
+               "pauses %d + %d us, marking %d us\n",
+               used_before,
+               collector.live_bytes(),
+               static_cast<int>(first_pause),
+               static_cast<int>(final_pause),
+               static_cast<int>(marking));
+    ObjectMemory::PrintStatistics();
+  }
 }
 
 class StatisticsVisitor : public HeapObjectVisitor {
@@ -484,6 +651,105 @@ void Program::PrintStatistics() {
   Print::Out("    - bytecode size = %d bytes\n", statistics.bytecode_size());
 }
 
+// Counts how often each bytecode directly follows another in the
+// functions of the program, to find candidates for fused bytecodes.
+// Fused bytecodes are counted as the pairs they were made from.
+class BytecodePairVisitor : public HeapObjectVisitor {
+ public:
+  struct Pair {
+    Opcode first;
+    Opcode second;
+    int count;
+  };
+
+  BytecodePairVisitor()
+      : counts_(Bytecode::kNumBytecodes * Bytecode::kNumBytecodes, 0),
+        total_(0) { }
+
+  int total() const { return total_; }
+
+  void Visit(HeapObject* object) {
+    if (!object->IsFunction()) return;
+    uint8* bcp = Function::cast(object)->bytecode_address_for(0);
+    Opcode opcode = Bytecode::UnfusedOpcode(static_cast<Opcode>(*bcp));
+    while (opcode != kMethodEnd) {
+      bcp += Bytecode::Size(opcode);
+      Opcode next = Bytecode::UnfusedOpcode(static_cast<Opcode>(*bcp));
+      if (next != kMethodEnd && FallsThrough(opcode)) {
+        counts_[opcode * Bytecode::kNumBytecodes + next]++;
+        total_++;
+      }
+      opcode = next;
+    }
+  }
+
+  // Returns the pairs that were seen, most common first.
+  std::vector<Pair> SortedPairs() const {
+    std::vector<Pair> pairs;
+    for (size_t i = 0; i < counts_.size(); i++) {
+      if (counts_[i] == 0) continue;
+      Pair pair;
+      pair.first = static_cast<Opcode>(i / Bytecode::kNumBytecodes);
+      pair.second = static_cast<Opcode>(i % Bytecode::kNumBytecodes);
+      pair.count = counts_[i];
+      pairs.push_back(pair);
+    }
+    std::sort(pairs.begin(), pairs.end(), CompareCount);
+    return pairs;
+  }
+
+ private:
+  std::vector<int> counts_;
+  int total_;
+
+  static bool FallsThrough(Opcode opcode) {
+    switch (opcode) {
+      case kReturn:
+      case kReturnWide:
+      case kBranchWide:
+      case kBranchBack:
+      case kBranchBackWide:
+      case kPopAndBranchWide:
+      case kPopAndBranchBackWide:
+      case kThrow:
+      case kSubroutineReturn:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+  static bool CompareCount(const Pair& a, const Pair& b) {
+    return a.count > b.count;
+  }
+};
+
+void Program::PrintBytecodePairs() {
+  static const char* kNames[] = {
+#define BYTECODE_NAME(name, branching, format, size, stack_diff, print) #name,
+    BYTECODES_DO(BYTECODE_NAME)
+#undef BYTECODE_NAME
+  };
+  static const int kMaxPairs = 40;
+
+  BytecodePairVisitor visitor;
+  heap_.space()->IterateObjects(&visitor);
+  std::vector<BytecodePairVisitor::Pair> pairs = visitor.SortedPairs();
+  Print::Out("Bytecode pairs\n");
+  Print::Out("  - count = %d\n", visitor.total());
+  int length = static_cast<int>(pairs.size());
+  for (int i = 0; i < length && i < kMaxPairs; i++) {
+    BytecodePairVisitor::Pair pair = pairs[i];
+    bool fused = Bytecode::FusedOpcode(pair.first, pair.second) != pair.first;
+    Print::Out("  %8d %5.1f%%  %s %s%s\n",
+               pair.count,
+               pair.count * 100.0 / visitor.total(),
+               kNames[pair.first],
+               kNames[pair.second],
+               fused ? " (fused)" : "");
+  }
+}
+
 void Program::Initialize() {
   // Create root set for the Program. During setup, do not fail
   // allocations, instead allocate new chunks.
@@ -702,6 +968,9 @@ void Program::Initialize() {
   raw_stack_overflow_ =
       String::cast(CreateStringFromAscii(StringFromCharZ("Stack overflow.")));
 
+  raw_out_of_memory_ =
+      String::cast(CreateStringFromAscii(StringFromCharZ("Out of memory.")));
+
   native_failure_result_ = null_object_;
 }
 
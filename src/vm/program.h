@@ -8,8 +8,10 @@
 #include "src/shared/globals.h"
 #include "src/shared/random.h"
 #include "src/vm/event_handler.h"
+#include "src/vm/gc_events.h"
 #include "src/vm/heap.h"
 #include "src/vm/immutable_heap.h"
+#include "src/vm/pause_histogram.h"
 #include "src/vm/program_folder.h"
 
 namespace fletch {
@@ -17,8 +19,10 @@ namespace fletch {
 class Class;
 class Function;
 class Method;
+class Port;
 class Process;
 class ProcessVisitor;
+class Profile;
 class ProgramTableRewriter;
 class Scheduler;
 class Session;
@@ -59,6 +63,7 @@ class Session;
   V(HeapObject, raw_index_out_of_bounds)         \
   V(HeapObject, raw_illegal_state)               \
   V(HeapObject, raw_stack_overflow)              \
+  V(HeapObject, raw_out_of_memory)               \
   V(Object, native_failure_result)
 
 class ProgramState {
@@ -140,7 +145,26 @@ class Program {
 
   ProgramState* program_state() { return &program_state_; }
 
-  EventHandler* event_handler() { return &event_handler_; }
+  // The event handler is split into shards, each with its own thread. A
+  // file descriptor or timer port is always handled by the same shard.
+  int event_handler_count() const { return event_handler_count_; }
+  EventHandler* event_handler(int index) {
+    ASSERT(index >= 0 && index < event_handler_count_);
+    return &event_handlers_[index];
+  }
+  EventHandler* EventHandlerForFd(int fd) {
+    return event_handler(fd % event_handler_count_);
+  }
+  EventHandler* EventHandlerForPort(Port* port) {
+    uword hash = reinterpret_cast<uword>(port) >> 4;
+    return event_handler(hash % event_handler_count_);
+  }
+
+  // Samples taken by the profiler. NULL unless profiling is enabled.
+  Profile* profile() const { return profile_; }
+
+  // Stacks of sampled allocations. NULL unless allocations are profiled.
+  Profile* allocation_profile() const { return allocation_profile_; }
 
   // TODO(ager): Support more than one active session at a time.
   void AddSession(Session* session) {
@@ -197,6 +221,13 @@ class Program {
 
   void PrintStatistics();
 
+  // Prints the most common pairs of adjacent bytecodes in the program, to
+  // find candidates for fused bytecodes. Enabled by -Xprint-bytecode-pairs
+  // when running a snapshot.
+  void PrintBytecodePairs();
+
+  GcEventLog* gc_events() { return &gc_events_; }
+
   // Iterates over all roots in the program.
   void IterateRoots(PointerVisitor* visitor);
 
@@ -239,6 +270,12 @@ class Program {
 
   void ValidateGlobalHeapsAreConsistent();
 
+  // The two ways of collecting the immutable heap. Both are called with the
+  // program stopped and resume it before returning. [wait] is the time it
+  // took to stop the program.
+  void ScavengeImmutableHeap(uint64 start, uint64 wait);
+  void MarkAndSweepImmutableHeap(uint64 start, uint64 wait);
+
   // Chaining of all processes of this program.
   void AddToProcessList(Process* process);
   void RemoveFromProcessList(Process* process);
@@ -255,7 +292,27 @@ class Program {
   Scheduler* scheduler_;
   ProgramState program_state_;
 
-  EventHandler event_handler_;
+  int event_handler_count_;
+  EventHandler* event_handlers_;
+
+  Profile* profile_;
+  Profile* allocation_profile_;
+
+  // Held while the program heap is collected, and while the immutable heap
+  // is marked concurrently, since marking reads the classes of immutable
+  // objects.
+  Mutex* gc_mutex_;
+
+  // Set when sweeping has left too much of the immutable heap as fillers,
+  // so the next immutable collection scavenges to compact it.
+  bool compact_immutable_heap_;
+
+  // Stop-the-world pauses of the immutable collections.
+  PauseHistogram immutable_scavenge_pauses_;
+  PauseHistogram immutable_marking_pauses_;
+
+  // The most recent collections of the program and its processes.
+  GcEventLog gc_events_;
 
   // Session operating on this program.
   Session* session_;
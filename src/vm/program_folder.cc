@@ -222,7 +222,10 @@ class FunctionPostprocessVisitor: public HeapObjectVisitor {
       : rewriter_(rewriter) { }
 
   virtual void Visit(HeapObject* object) {
-    if (object->IsFunction()) Process(Function::cast(object));
+    if (!object->IsFunction()) return;
+    Function* function = Function::cast(object);
+    Process(function);
+    if (Flags::fuse_bytecodes) ProgramFolder::FuseBytecodes(function);
   }
 
  private:
@@ -509,6 +512,21 @@ void ProgramFolder::FoldFunction(Function* old_function,
   UNREACHABLE();
 }
 
+void ProgramFolder::FuseBytecodes(Function* function) {
+  // Only the first bytecode of a pair is rewritten, so the bytecode
+  // after it can be the first bytecode of another pair.
+  uint8_t* bcp = function->bytecode_address_for(0);
+  Opcode opcode = static_cast<Opcode>(*bcp);
+  while (opcode != kMethodEnd) {
+    ASSERT(!Bytecode::IsFused(opcode));
+    uint8_t* next_bcp = bcp + Bytecode::Size(opcode);
+    Opcode next = static_cast<Opcode>(*next_bcp);
+    *bcp = Bytecode::FusedOpcode(opcode, next);
+    bcp = next_bcp;
+    opcode = next;
+  }
+}
+
 class LiteralsRewriter {
  public:
   LiteralsRewriter(Space* space, Function* function)
@@ -548,7 +566,9 @@ Object* ProgramFolder::UnfoldFunction(Function* function,
   uint8_t* bcp = function->bytecode_address_for(0);
 
   while (true) {
-    Opcode opcode = static_cast<Opcode>(*bcp);
+    // Fused bytecodes are recreated when the program is folded again.
+    Opcode opcode = Bytecode::UnfusedOpcode(static_cast<Opcode>(*bcp));
+    *bcp = opcode;
 
     switch (opcode) {
       case kLoadConst:
@@ -38,6 +38,10 @@ class ProgramFolder {
   // Will fold the program if not overridden by -Xunfold-program.
   static void FoldProgramByDefault(Program* program);
 
+  // Rewrites the common pairs of bytecodes in [function] to fused
+  // bytecodes. Unfolding turns them back into the original pairs.
+  static void FuseBytecodes(Function* function);
+
  private:
   friend class FoldingVisitor;
   friend class UnfoldingVisitor;
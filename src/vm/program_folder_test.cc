@@ -0,0 +1,159 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifdef FLETCH_ENABLE_LIVE_CODING
+
+#include <string.h>
+
+#include "src/shared/assert.h"
+#include "src/shared/bytecodes.h"
+#include "src/shared/flags.h"
+#include "src/shared/names.h"
+#include "src/shared/selectors.h"
+#include "src/shared/test_case.h"
+#include "src/shared/utils.h"
+
+#include "src/vm/object.h"
+#include "src/vm/program.h"
+#include "src/vm/program_folder.h"
+
+namespace fletch {
+
+// Appends bytecodes to a fixed buffer and terminates them with the
+// method end bytecode when the function is created.
+class BytecodeBuilder {
+ public:
+  BytecodeBuilder() : length_(0) { }
+
+  BytecodeBuilder& Emit(Opcode opcode) {
+    return EmitByte(opcode);
+  }
+
+  BytecodeBuilder& Emit(Opcode opcode, uint8 argument) {
+    return Emit(opcode).EmitByte(argument);
+  }
+
+  BytecodeBuilder& EmitInt32(Opcode opcode, int argument) {
+    Emit(opcode);
+    ASSERT(length_ + 4 <= kCapacity);
+    Utils::WriteInt32(bytes_ + length_, argument);
+    length_ += 4;
+    return *this;
+  }
+
+  BytecodeBuilder& EmitByte(uint8 value) {
+    ASSERT(length_ < kCapacity);
+    bytes_[length_++] = value;
+    return *this;
+  }
+
+  int length() const { return length_; }
+  uint8* bytes() { return bytes_; }
+
+  Function* CreateFunction(Program* program, int arity) {
+    int end = length_;
+    EmitInt32(kMethodEnd, end << 1);
+    List<uint8> bytecodes(bytes_, length_);
+    return Function::cast(program->CreateFunction(arity, bytecodes, 0));
+  }
+
+ private:
+  static const int kCapacity = 64;
+
+  uint8 bytes_[kCapacity];
+  int length_;
+};
+
+TEST_CASE(ProgramFolder_FuseAndUnfuse) {
+  if (!Flags::fuse_bytecodes) return;
+
+  Program* program = new Program();
+  program->Initialize();
+  program->set_static_methods(Array::cast(program->CreateArray(0)));
+  program->set_static_fields(Array::cast(program->CreateArray(0)));
+
+  // Give Object a getter and the noSuchMethod trampoline. Every selector
+  // with a definition ends up in the vtable, so invoking the getter is
+  // fused with the receiver load.
+  int getter = Selector::EncodeGetter(Names::kCount);
+  int trampoline =
+      Selector::EncodeMethod(Names::kNoSuchMethodTrampoline, 0);
+  ASSERT(trampoline < getter);
+
+  BytecodeBuilder getter_builder;
+  getter_builder.Emit(kLoadLocal1).Emit(kLoadField, 0).Emit(kReturn, 1)
+      .EmitByte(1);
+  BytecodeBuilder trampoline_builder;
+  trampoline_builder.Emit(kLoadLiteralNull).Emit(kReturn, 1).EmitByte(1);
+
+  Function* getter_function = getter_builder.CreateFunction(program, 1);
+  void* intrinsic = getter_function->ComputeIntrinsic();
+
+  Array* methods = Array::cast(program->CreateArray(4));
+  methods->set(0, Smi::FromWord(trampoline));
+  methods->set(1, trampoline_builder.CreateFunction(program, 1));
+  methods->set(2, Smi::FromWord(getter));
+  methods->set(3, getter_function);
+  program->object_class()->set_methods(methods);
+
+  // One instance of every fused pair, separated by bytecodes that are
+  // not the first bytecode of any pair.
+  BytecodeBuilder builder;
+  int load_local_0 = builder.Emit(kLoadLiteralNull).length();
+  builder.Emit(kLoadLocal0).Emit(kLoadField, 0);
+  int load_local_1 = builder.Emit(kPop).length();
+  builder.Emit(kLoadLocal1).Emit(kLoadField, 1);
+  int load_local = builder.Emit(kPop).length();
+  builder.Emit(kLoadLocal, 2).Emit(kLoadField, 2);
+  int load_null = builder.Emit(kPop).length();
+  builder.Emit(kLoadLiteralNull).Emit(kIdentical);
+  int invoke = builder.Emit(kPop).length();
+  builder.Emit(kLoadLocal0).EmitInt32(kInvokeMethod, getter);
+  builder.Emit(kReturn, 2).EmitByte(0);
+
+  int length = builder.length();
+  uint8 original[64];
+  memcpy(original, builder.bytes(), length);
+  program->set_entry(builder.CreateFunction(program, 0));
+  program->set_main_arity(0);
+
+  ProgramFolder folder(program);
+  folder.Fold();
+  EXPECT(program->is_compact());
+
+  uint8* bcp = program->entry()->bytecode_address_for(0);
+  EXPECT_EQ(bcp[0], kLoadLiteralNull);
+  EXPECT_EQ(bcp[load_local_0], kLoadLocal0LoadField);
+  EXPECT_EQ(bcp[load_local_1], kLoadLocal1LoadField);
+  EXPECT_EQ(bcp[load_local], kLoadLocalLoadField);
+  EXPECT_EQ(bcp[load_null], kLoadLiteralNullIdentical);
+  EXPECT_EQ(bcp[invoke], kLoadLocal0InvokeMethodVtable);
+
+  // Only the first bytecode of a pair is rewritten.
+  EXPECT_EQ(bcp[load_local_0 + 1], kLoadField);
+  EXPECT_EQ(bcp[load_null + 1], kIdentical);
+  EXPECT_EQ(bcp[invoke + 1], kInvokeMethodVtable);
+
+  // The getter is fused too, but is still recognized as an intrinsic.
+  Function* folded_getter = program->object_class()->LookupMethod(getter);
+  uint8* getter_bcp = folded_getter->bytecode_address_for(0);
+  EXPECT_EQ(getter_bcp[0], kLoadLocal1LoadField);
+  EXPECT(folded_getter->ComputeIntrinsic() == intrinsic);
+
+  folder.Unfold();
+  EXPECT(!program->is_compact());
+  EXPECT_EQ(memcmp(program->entry()->bytecode_address_for(0),
+                   original,
+                   length),
+            0);
+  getter_bcp = program->object_class()->LookupMethod(getter)
+      ->bytecode_address_for(0);
+  EXPECT_EQ(getter_bcp[0], kLoadLocal1);
+
+  delete program;
+}
+
+}  // namespace fletch
+
+#endif  // FLETCH_ENABLE_LIVE_CODING
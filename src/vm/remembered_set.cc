@@ -0,0 +1,56 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/remembered_set.h"
+
+namespace fletch {
+
+bool CardMarkingVisitor::IsRemembered(Object* object) {
+  if (!object->IsHeapObject()) return false;
+  uword address = HeapObject::cast(object)->address();
+  if (young_space_->Includes(address)) return remember_young_;
+  if (old_space_->Includes(address) ||
+      program_space_->Includes(address) ||
+      (large_space_ != NULL && large_space_->Includes(address))) {
+    return false;
+  }
+  ASSERT(object->IsImmutable());
+  return true;
+}
+
+void CardMarkingVisitor::VisitBlock(Object** start, Object** end) {
+  ASSERT(chunk_ != NULL);
+  for (Object** p = start; p < end; p++) {
+    if (IsRemembered(*p)) chunk_->MarkCard(reinterpret_cast<uword>(p));
+  }
+}
+
+bool DirtyCardVisitor::HasDirtyCards(uword start, uword end) {
+  int first = (start - chunk_->base()) >> Chunk::kCardBits;
+  int last = (end - 1 - chunk_->base()) >> Chunk::kCardBits;
+  for (int i = first; i <= last; i++) {
+    if (cards_[i] != 0) return true;
+  }
+  return false;
+}
+
+void DirtyCardVisitor::VisitBlock(Object** start, Object** end) {
+  uword base = chunk_->base();
+  Object** p = start;
+  while (p < end) {
+    uword address = reinterpret_cast<uword>(p);
+    int card = (address - base) >> Chunk::kCardBits;
+    // Cards are aligned, since chunks are page aligned.
+    Object** card_end = reinterpret_cast<Object**>(
+        Utils::RoundUp(address + 1, Chunk::kCardSize));
+    Object** run_end = (card_end < end) ? card_end : end;
+    if (cards_[card] != 0) {
+      visitor_->VisitBlock(p, run_end);
+      if (marker_ != NULL) marker_->MarkCards(chunk_, p, run_end);
+    }
+    p = run_end;
+  }
+}
+
+}  // namespace fletch
@@ -0,0 +1,100 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_REMEMBERED_SET_H_
+#define SRC_VM_REMEMBERED_SET_H_
+
+#include "src/vm/object.h"
+#include "src/vm/object_memory.h"
+
+namespace fletch {
+
+// The remembered set of a process heap is the set of dirty cards in the
+// chunks of its spaces. A process heap has to remember the slots with
+// pointers to an immutable space, which are roots of the immutable GC, and
+// the slots in old objects with pointers to the young generation, which
+// are roots of the young GC.
+//
+// The write barrier marks the card of the slot it stores into (see
+// [Process::RecordStore]). Objects that are written without barriers,
+// like stacks, get all their cards marked instead. The cards are cleaned
+// when a process GC finds that the slots in them no longer need to be
+// remembered.
+
+// Marks the cards of the slots that a generational process heap needs to
+// remember: slots with pointers to an immutable space and, if
+// [remember_young] is set, slots with pointers to the young generation.
+// Objects in [large_space] are old.
+class CardMarkingVisitor: public PointerVisitor {
+ public:
+  CardMarkingVisitor(Space* young_space,
+                     Space* old_space,
+                     Space* program_space,
+                     bool remember_young,
+                     Space* large_space = NULL)
+      : young_space_(young_space),
+        old_space_(old_space),
+        large_space_(large_space),
+        program_space_(program_space),
+        remember_young_(remember_young),
+        chunk_(NULL) {}
+
+  // Marks the cards of the remembered slots of [object], which is in
+  // [chunk].
+  void MarkCards(Chunk* chunk, HeapObject* object) {
+    chunk_ = chunk;
+    object->IteratePointers(this);
+  }
+
+  // Marks the cards of the remembered slots in [start, end), which are in
+  // [chunk].
+  void MarkCards(Chunk* chunk, Object** start, Object** end) {
+    chunk_ = chunk;
+    VisitBlock(start, end);
+  }
+
+  virtual void VisitBlock(Object** start, Object** end);
+
+ private:
+  bool IsRemembered(Object* object);
+
+  Space* young_space_;
+  Space* old_space_;
+  Space* large_space_;
+  Space* program_space_;
+  bool remember_young_;
+  Chunk* chunk_;
+};
+
+// Forwards the parts of the pointer blocks that are in the dirty cards of
+// a chunk to [visitor], and then to [marker] if there is one. Class
+// pointers are never remembered, so they are not forwarded.
+class DirtyCardVisitor: public PointerVisitor {
+ public:
+  DirtyCardVisitor(PointerVisitor* visitor, CardMarkingVisitor* marker)
+      : visitor_(visitor), marker_(marker), chunk_(NULL), cards_(NULL) {}
+
+  // Uses [cards] as the cards of [chunk]. They can be a copy, so the cards
+  // of the chunk can be cleaned while they are visited.
+  void set_chunk(Chunk* chunk, const uint8* cards) {
+    chunk_ = chunk;
+    cards_ = cards;
+  }
+
+  // Tells whether any of the bytes in [start, end) are in a dirty card.
+  bool HasDirtyCards(uword start, uword end);
+
+  virtual void VisitBlock(Object** start, Object** end);
+  virtual void VisitClass(Object** p) { }
+
+ private:
+  PointerVisitor* visitor_;
+  CardMarkingVisitor* marker_;
+  Chunk* chunk_;
+  const uint8* cards_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_REMEMBERED_SET_H_
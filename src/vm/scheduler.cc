@@ -11,8 +11,10 @@
 #include "src/vm/port.h"
 #include "src/vm/process.h"
 #include "src/vm/process_queue.h"
+#include "src/vm/profiler.h"
 #include "src/vm/session.h"
 #include "src/vm/thread.h"
+#include "src/vm/work_stealing_queue.h"
 
 namespace fletch {
 
@@ -47,6 +49,7 @@ Scheduler::~Scheduler() {
   delete[] current_processes_;
   delete[] threads_;
   delete startup_queue_;
+  if (Flags::print_inline_cache_statistics) PrintInlineCacheStatistics();
   ThreadState* current = temporary_thread_states_;
   while (current != NULL) {
     ThreadState* next = current->next_idle_thread();
@@ -172,6 +175,11 @@ void Scheduler::ResumeGcThread() {
   gc_thread_->Resume();
 }
 
+bool Scheduler::IsGcThreadPauseRequested() {
+  ASSERT(gc_thread_ != NULL);
+  return gc_thread_->IsPauseRequested();
+}
+
 void Scheduler::EnqueueProcessOnSchedulerWorkerThread(
     Process* interpreting_process, Process* process) {
   ++processes_;
@@ -234,6 +242,7 @@ bool Scheduler::EnqueueProcess(Process* process, Port* port) {
     if (new_process != NULL) EnqueueOnAnyThread(new_process);
 
     ASSERT(thread_state->queue()->is_empty());
+    ASSERT(thread_state->deque()->is_empty());
 
     ReturnThreadState(thread_state);
 
@@ -353,7 +362,7 @@ void Scheduler::RescheduleProcess(Process* process,
     ExitAtTermination(process, state);
   } else {
     process->ChangeState(Process::kRunning, Process::kReady);
-    EnqueueOnAnyThread(process, state->thread_id() + 1);
+    PushOnThread(state, process);
   }
 }
 
@@ -387,18 +396,20 @@ uint64 Scheduler::GetNextPreemptTime() {
 void Scheduler::EnqueueProcessAndNotifyThreads(ThreadState* thread_state,
                                                Process* process) {
   ASSERT(process != NULL);
-  int thread_id = 0;
   if (thread_state != NULL) {
-    thread_id = thread_state->thread_id();
+    // If we were able to enqueue on an idle thread, no need to spawn a new one.
+    if (PushOnThread(thread_state, process)) return;
   } else if (thread_count_ == 0) {
     bool was_empty;
     while (!startup_queue_->TryEnqueue(process, &was_empty)) { }
     return;
+  } else {
+    // If we were able to enqueue on an idle thread, no need to spawn a new one.
+    if (EnqueueOnAnyThread(process, 1)) return;
   }
 
-  // If we were able to enqueue on an idle thread, no need to spawn a new one.
-  if (EnqueueOnAnyThread(process, thread_id + 1)) return;
-  // Start a worker thread, if less than [processes_] threads are running.
+  // Start a worker thread, if less than [processes_] threads are running. The
+  // new thread will steal the process if no other thread gets to it first.
   while (!thread_pool_.TryStartThread(RunThread, this, processes_)) { }
 }
 
@@ -451,6 +462,7 @@ void Scheduler::RunInThread() {
   while (true) {
     thread_state->idle_monitor()->Lock();
     while (thread_state->queue()->is_empty() &&
+           thread_state->deque()->is_empty() &&
            startup_queue_->is_empty() &&
            !pause_ &&
            processes_ > 0) {
@@ -581,6 +593,13 @@ Process* Scheduler::InterpretProcess(Process* process,
   process->set_immutable_heap(NULL);
   immutable_heap->set_random(NULL);
 
+  // Hand the samples taken during this run over to the program. The
+  // functions they refer to cannot move until the program is stopped.
+  ProfileBuffer* profile_buffer = thread_state->profile_buffer();
+  if (profile_buffer != NULL && !profile_buffer->is_empty()) {
+    profile_buffer->FlushTo(process->program()->profile());
+  }
+
   process->set_thread_state(NULL);
   ClearCurrentProcessForThread(thread_id, process);
 
@@ -652,6 +671,12 @@ Process* Scheduler::InterpretProcess(Process* process,
   }
 
   if (interpreter.IsUncaughtException()) {
+    // A process that runs out of memory is terminated on its own, so it
+    // cannot take the rest of the VM with it.
+    if (process->uncaught_out_of_memory()) {
+      ExitAtTermination(process, thread_state);
+      return NULL;
+    }
     process->ChangeState(Process::kRunning, Process::kUncaughtException);
     Session* session = process->program()->session();
     if (session == NULL ||
@@ -762,10 +787,58 @@ void Scheduler::FlushCacheInThreadStates() {
   }
 }
 
-void Scheduler::DequeueFromThread(ThreadState* thread_state,
-                                  Process** process) {
-  ASSERT(*process == NULL);
-  while (!TryDequeueFromAnyThread(process, thread_state->thread_id())) { }
+class InvalidateInlineCacheVisitor : public ThreadStateVisitor {
+ public:
+  explicit InvalidateInlineCacheVisitor(Class* clazz) : clazz_(clazz) { }
+
+  void VisitThreadState(ThreadState* thread_state) {
+    InlineCache* cache = thread_state->inline_cache();
+    if (cache != NULL) cache->Invalidate(clazz_);
+  }
+
+ private:
+  Class* const clazz_;
+};
+
+void Scheduler::InvalidateInlineCaches(Class* clazz) {
+  InvalidateInlineCacheVisitor visitor(clazz);
+  VisitThreadStates(&visitor);
+}
+
+void Scheduler::VisitThreadStates(ThreadStateVisitor* visitor) {
+  for (int i = 0; i < thread_count_; i++) {
+    ThreadState* thread_state = threads_[i];
+    if (thread_state != NULL) visitor->VisitThreadState(thread_state);
+  }
+  ThreadState* temp = temporary_thread_states_;
+  while (temp != NULL) {
+    visitor->VisitThreadState(temp);
+    temp = temp->next_idle_thread();
+  }
+}
+
+void Scheduler::PrintInlineCacheStatistics() {
+  // All threads have returned their thread states at this point.
+  uword hits = 0;
+  uword misses = 0;
+  ThreadState* temp = temporary_thread_states_;
+  while (temp != NULL) {
+    InlineCache* cache = temp->inline_cache();
+    if (cache != NULL) {
+      hits += cache->hits();
+      misses += cache->misses();
+    }
+    temp = temp->next_idle_thread();
+  }
+  uword total = hits + misses;
+  Print::Out("Inline caches\n");
+  Print::Out("  - hits = %lld\n",
+             static_cast<long long int>(hits));  // NOLINT
+  Print::Out("  - misses = %lld\n",
+             static_cast<long long int>(misses));  // NOLINT
+  if (total > 0) {
+    Print::Out("  - hit rate = %.1f%%\n", hits * 100.0 / total);
+  }
 }
 
 static bool TryDequeue(ProcessQueue* queue,
@@ -781,18 +854,59 @@ static bool TryDequeue(ProcessQueue* queue,
   return false;
 }
 
+static bool TryPop(WorkStealingQueue<Process>* deque, Process** process) {
+  Process* entry = deque->Pop();
+  if (entry == NULL) return false;
+  if (!entry->ChangeState(Process::kReady, Process::kRunning)) UNREACHABLE();
+  *process = entry;
+  return true;
+}
+
+static bool TrySteal(WorkStealingQueue<Process>* deque,
+                     Process** process,
+                     bool* should_retry) {
+  if (deque->TrySteal(process)) {
+    if (*process != NULL) {
+      if (!(*process)->ChangeState(Process::kReady, Process::kRunning)) {
+        UNREACHABLE();
+      }
+      return true;
+    }
+  } else {
+    *should_retry = true;
+  }
+  return false;
+}
+
+void Scheduler::DequeueFromThread(ThreadState* thread_state,
+                                  Process** process) {
+  ASSERT(*process == NULL);
+  // Prefer the process most recently made runnable by this thread; it is the
+  // most likely to find its data in the cache. Every so often the FIFO queue
+  // goes first, so processes preempted on this thread are not starved by
+  // processes that keep waking each other up.
+  bool should_retry = false;
+  if (thread_state->ShouldCheckQueueFirst() &&
+      TryDequeue(thread_state->queue(), process, &should_retry)) {
+    return;
+  }
+  if (TryPop(thread_state->deque(), process)) return;
+
+  // Steal from the other threads. Start at a random victim to avoid all
+  // thieves hammering the same queues.
+  int count = thread_count_;
+  int start_id = (thread_state->random()->NextUInt32() >> 16) % count;
+  while (!TryDequeueFromAnyThread(process, start_id)) { }
+}
+
 bool Scheduler::TryDequeueFromAnyThread(Process** process, int start_id) {
   ASSERT(*process == NULL);
   int count = thread_count_;
   bool should_retry = false;
-  for (int i = start_id; i < count; i++) {
-    ThreadState* thread_state = threads_[i];
-    if (thread_state == NULL) continue;
-    if (TryDequeue(thread_state->queue(), process, &should_retry)) return true;
-  }
-  for (int i = 0; i < start_id; i++) {
-    ThreadState* thread_state = threads_[i];
+  for (int i = 0; i < count; i++) {
+    ThreadState* thread_state = threads_[(start_id + i) % count];
     if (thread_state == NULL) continue;
+    if (TrySteal(thread_state->deque(), process, &should_retry)) return true;
     if (TryDequeue(thread_state->queue(), process, &should_retry)) return true;
   }
   // TODO(ajohnsen): Merge startup_queue_ into the first thread we start, or
@@ -817,6 +931,18 @@ void Scheduler::EnqueueOnThread(ThreadState* thread_state, Process* process) {
   }
 }
 
+bool Scheduler::PushOnThread(ThreadState* thread_state, Process* process) {
+  ASSERT(process->state() == Process::kReady);
+  // Idle threads are handed work directly, rather than having to steal it.
+  if (TryEnqueueOnIdleThread(process)) return true;
+  int thread_id = thread_state->thread_id();
+  // Threads not owned by the scheduler do not drain their deque.
+  if (thread_id == -1 || !thread_state->deque()->Push(process)) {
+    return EnqueueOnAnyThread(process, thread_id + 1);
+  }
+  return false;
+}
+
 bool Scheduler::TryEnqueueOnIdleThread(Process* process) {
   while (true) {
     ThreadState* thread_state = PopIdleThread();
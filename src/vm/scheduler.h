@@ -11,6 +11,7 @@
 
 namespace fletch {
 
+class Class;
 class GCThread;
 class Heap;
 class Object;
@@ -27,6 +28,13 @@ class ProcessVisitor {
   virtual void VisitProcess(Process* process) = 0;
 };
 
+class ThreadStateVisitor {
+ public:
+  virtual ~ThreadStateVisitor() { }
+
+  virtual void VisitThreadState(ThreadState* thread_state) = 0;
+};
+
 class Scheduler {
  public:
   Scheduler();
@@ -38,8 +46,18 @@ class Scheduler {
   void StopProgram(Program* program);
   void ResumeProgram(Program* program);
 
+  // Drops the inline cache entries for [clazz] and its subclasses on all
+  // threads. Must only be called while the program is stopped.
+  void InvalidateInlineCaches(Class* clazz);
+
+  // Visits the thread states of the scheduler threads and of the foreign
+  // threads that have run processes. Unless the program is stopped, the
+  // threads may be interpreting while their states are visited.
+  void VisitThreadStates(ThreadStateVisitor* visitor);
+
   void PauseGcThread();
   void ResumeGcThread();
+  bool IsGcThreadPauseRequested();
 
   // This method should only be called from a thread which is currently
   // interpreting a process.
@@ -128,15 +146,24 @@ class Scheduler {
   ThreadState* TakeThreadState();
   void ReturnThreadState(ThreadState* thread_state);
   void FlushCacheInThreadStates();
+  void PrintInlineCacheStatistics();
 
   // Dequeue from [thread_state]. If [process] is [NULL] after a call to
-  // DequeueFromThread, the [thread_state] is empty. Note that DequeueFromThread
-  // may dequeue a process from another ThreadState.
+  // DequeueFromThread, all thread_states were empty. Note that
+  // DequeueFromThread steals processes from other ThreadStates when
+  // [thread_state] is empty.
   void DequeueFromThread(ThreadState* thread_state, Process** process);
   // Returns true if it was able to dequeue a process, or all thread_states were
-  // empty. Returns false if the operation should be retried.
+  // empty. Returns false if the operation should be retried. Visits the
+  // thread_states starting at [start_id], stealing from their deques before
+  // looking at their queues.
   bool TryDequeueFromAnyThread(Process** process, int start_id = 0);
+  // Enqueue [process] at the end of the FIFO queue of [thread_state].
   void EnqueueOnThread(ThreadState* thread_state, Process* process);
+  // Push [process] on the work-stealing deque of [thread_state], which must be
+  // owned by the calling thread. Returns true if it was able to enqueue the
+  // process on an idle thread instead.
+  bool PushOnThread(ThreadState* thread_state, Process* process);
   // Returns true if it was able to enqueue the process on an idle thread.
   bool TryEnqueueOnIdleThread(Process* process);
   // Returns true if it was able to enqueue the process on an idle thread.
@@ -11,8 +11,10 @@
 #include "src/shared/flags.h"
 #include "src/shared/platform.h"
 
+#include "src/vm/heap_census.h"
 #include "src/vm/object_map.h"
 #include "src/vm/process.h"
+#include "src/vm/profiler.h"
 #include "src/vm/scheduler.h"
 #include "src/vm/snapshot.h"
 #include "src/vm/stack_walker.h"
@@ -178,6 +180,142 @@ void Session::SendStackTrace(Stack* stack) {
   connection_->Send(Connection::kProcessBacktrace, buffer);
 }
 
+class ProfileWriter : public ProfileStackVisitor {
+ public:
+  ProfileWriter(Session* session, int method_map_id, WriteBuffer* buffer)
+      : session_(session), method_map_id_(method_map_id), buffer_(buffer) { }
+
+  void VisitStack(ProfileNode** frames, int depth, int count) {
+    buffer_->WriteInt(count);
+    buffer_->WriteInt(depth);
+    for (int i = 0; i < depth; i++) {
+      Function* function = frames[i]->function();
+      int64 id = session_->MapLookupByObject(method_map_id_, function);
+      buffer_->WriteInt64(id);
+      buffer_->WriteInt64(frames[i]->bytecode_index());
+    }
+  }
+
+ private:
+  Session* const session_;
+  const int method_map_id_;
+  WriteBuffer* const buffer_;
+};
+
+void Session::SendProfile() {
+  // The stacks are written back to back, so the compiler reads them until
+  // the end of the buffer.
+  WriteBuffer buffer;
+  Profile* profile = program()->profile();
+  if (profile != NULL) {
+    ProfileWriter writer(this, method_map_id_, &buffer);
+    profile->VisitStacks(&writer);
+  }
+  connection_->Send(Connection::kProcessProfile, buffer);
+}
+
+void Session::SendGcEvents() {
+  // The events are written back to back, oldest first.
+  GcEvent* events = new GcEvent[GcEventLog::kCapacity];
+  int length = program()->gc_events()->CopyEvents(events);
+  WriteBuffer buffer;
+  for (int i = 0; i < length; i++) {
+    GcEvent* event = &events[i];
+    buffer.WriteInt(event->kind);
+    buffer.WriteInt64(event->process);
+    buffer.WriteInt64(event->start);
+    buffer.WriteInt64(event->end);
+    buffer.WriteInt(event->size_before);
+    buffer.WriteInt(event->size_after);
+    buffer.WriteInt(event->promoted);
+    buffer.WriteInt64(event->wait);
+  }
+  delete[] events;
+  connection_->Send(Connection::kGcEvents, buffer);
+}
+
+class CensusProcessVisitor : public ProcessVisitor {
+ public:
+  explicit CensusProcessVisitor(HeapCensus* census) : census_(census) { }
+
+  void VisitProcess(Process* process) { census_->AddProcess(process); }
+
+ private:
+  HeapCensus* const census_;
+};
+
+void Session::SendHeapCensus(bool retained_sizes) {
+  // The whole program is stopped, so the census sees all the processes.
+  // Immutable objects allocated since the last immutable collection are
+  // still in the heap parts of the processes and are left out.
+  Scheduler* scheduler = program()->scheduler();
+  if (scheduler != NULL) {
+    scheduler->StopProgram(program());
+    scheduler->PauseGcThread();
+  }
+
+  HeapCensus census;
+  CensusProcessVisitor visitor(&census);
+  program()->VisitProcesses(&visitor);
+  census.AddSpace(program()->immutable_heap()->heap()->space());
+  if (retained_sizes) census.ComputeRetainedSizes();
+
+  WriteBuffer buffer;
+  std::vector<HeapCensus::Entry>* entries = census.SortedEntries();
+  for (size_t i = 0; i < entries->size(); i++) {
+    HeapCensus::Entry* entry = &(*entries)[i];
+    int64 id = -1;
+    if (class_map_id_ >= 0) {
+      id = MapLookupByObject(class_map_id_, entry->klass);
+    }
+    buffer.WriteInt64(id);
+    buffer.WriteInt(entry->count);
+    buffer.WriteInt64(entry->bytes);
+    buffer.WriteInt64(entry->retained);
+  }
+
+  if (scheduler != NULL) {
+    scheduler->ResumeGcThread();
+    scheduler->ResumeProgram(program());
+  }
+  connection_->Send(Connection::kHeapCensus, buffer);
+}
+
+class LookupCacheStatisticsVisitor : public ThreadStateVisitor {
+ public:
+  explicit LookupCacheStatisticsVisitor(WriteBuffer* buffer)
+      : buffer_(buffer) { }
+
+  void VisitThreadState(ThreadState* thread_state) {
+    LookupCache* cache = thread_state->cache();
+    if (cache == NULL) return;
+    LookupCache::Statistics* statistics = cache->statistics();
+    buffer_->WriteInt(thread_state->thread_id());
+    buffer_->WriteInt(cache->primary_size());
+    buffer_->WriteInt64(statistics->primary_hits);
+    buffer_->WriteInt64(statistics->secondary_hits);
+    buffer_->WriteInt64(statistics->lookups);
+    buffer_->WriteInt64(statistics->no_such_method);
+    buffer_->WriteInt64(statistics->vtable_hits);
+    buffer_->WriteInt64(statistics->vtable_no_such_method);
+  }
+
+ private:
+  WriteBuffer* const buffer_;
+};
+
+void Session::SendLookupCacheStatistics() {
+  // The counters are only updated with -Xlookup-cache-statistics, and
+  // threads that are interpreting may update them while they are read.
+  WriteBuffer buffer;
+  Scheduler* scheduler = program()->scheduler();
+  if (scheduler != NULL) {
+    LookupCacheStatisticsVisitor visitor(&buffer);
+    scheduler->VisitThreadStates(&visitor);
+  }
+  connection_->Send(Connection::kLookupCacheStatistics, buffer);
+}
+
 void Session::ProcessMessages() {
   while (true) {
     Connection::Opcode opcode = connection_->Receive();
@@ -289,6 +427,26 @@ void Session::ProcessMessages() {
         break;
       }
 
+      case Connection::kProcessProfileRequest: {
+        SendProfile();
+        break;
+      }
+
+      case Connection::kGcEventsRequest: {
+        SendGcEvents();
+        break;
+      }
+
+      case Connection::kHeapCensusRequest: {
+        SendHeapCensus(connection_->ReadBoolean());
+        break;
+      }
+
+      case Connection::kLookupCacheStatisticsRequest: {
+        SendLookupCacheStatistics();
+        break;
+      }
+
       case Connection::kProcessFiberBacktraceRequest: {
         StoppedGcThreadScope scope(program()->scheduler());
         int64 fiber_id = connection_->ReadInt64();
@@ -972,6 +1130,7 @@ void Session::CommitChangeSuperClass(Array* change) {
   Class* klass = Class::cast(change->get(1));
   Class* super = Class::cast(change->get(2));
   klass->set_super_class(super);
+  InvalidateInlineCaches(klass);
 }
 
 void Session::ChangeMethodTable(int length) {
@@ -983,6 +1142,12 @@ void Session::CommitChangeMethodTable(Array* change) {
   Class* clazz = Class::cast(change->get(1));
   Array* methods = Array::cast(change->get(2));
   clazz->set_methods(methods);
+  InvalidateInlineCaches(clazz);
+}
+
+void Session::InvalidateInlineCaches(Class* clazz) {
+  Scheduler* scheduler = program()->scheduler();
+  if (scheduler != NULL) scheduler->InvalidateInlineCaches(clazz);
 }
 
 void Session::ChangeMethodLiteral(int index) {
@@ -1233,6 +1398,9 @@ class TransformInstancesProcessVisitor : public ProcessVisitor {
     // process heap, because otherwise we'll not update the pointers it has to
     // the program space / to the process heap objects which were transformed.
     process->TakeChildHeaps();
+    // Transformed instances are cloned into the nursery, so keep all the
+    // objects in one space while they are transformed.
+    process->MergeGenerations();
 
     Heap* heap = process->heap();
 
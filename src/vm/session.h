@@ -164,6 +164,10 @@ class Session {
   void ProcessContinue(Process* process);
 
   void SendStackTrace(Stack* stack);
+  void SendProfile();
+  void SendGcEvents();
+  void SendHeapCensus(bool retained_sizes);
+  void SendLookupCacheStatistics();
   void SendDartValue(Object* value);
   void SendInstanceStructure(Instance* instance);
 
@@ -180,6 +184,9 @@ class Session {
   void CommitChangeStatics(Array* change);
   void CommitChangeSchemas(Array* change);
 
+  // Drops the inline cache entries that depend on the methods of [clazz].
+  void InvalidateInlineCaches(Class* clazz);
+
   // This will leave process and program heaps with old and new objects behind.
   // Where the old objects will have a forwarding pointer installed. It is
   // therefore not safe to traverse heap objects after calling this method.
@@ -0,0 +1,207 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/vm/timer_wheel.h"
+
+#include "src/shared/assert.h"
+
+namespace fletch {
+
+static int LowestBit(uint64 bits) {
+  ASSERT(bits != 0);
+  return __builtin_ctzll(bits);
+}
+
+TimerWheel::TimerWheel(int64 now)
+    : current_(now), count_(0), overflow_(NULL) {
+  for (int level = 0; level < kLevels; level++) {
+    occupied_[level] = 0;
+    for (int slot = 0; slot < kSlots; slot++) slots_[level][slot] = NULL;
+  }
+}
+
+TimerWheel::~TimerWheel() {
+  DeleteTimers(RemoveAll());
+}
+
+void TimerWheel::DeleteTimers(Timer* timers) {
+  while (timers != NULL) {
+    Timer* next = timers->next_;
+    delete timers;
+    timers = next;
+  }
+}
+
+bool TimerWheel::Schedule(Port* port, int64 deadline) {
+  // Timers in the past expire on the next tick.
+  if (deadline <= current_) deadline = current_ + 1;
+
+  HashMap<Port*, Timer*>::ConstIterator it = timers_.Find(port);
+  if (it != timers_.End()) {
+    Timer* timer = it->second;
+    Remove(timer);
+    timer->deadline_ = deadline;
+    Insert(timer);
+    return false;
+  }
+
+  Timer* timer = new Timer(port, deadline);
+  timers_[port] = timer;
+  Insert(timer);
+  count_++;
+  return true;
+}
+
+bool TimerWheel::Cancel(Port* port) {
+  HashMap<Port*, Timer*>::ConstIterator it = timers_.Find(port);
+  if (it == timers_.End()) return false;
+  Timer* timer = it->second;
+  timers_.Erase(it);
+  Remove(timer);
+  delete timer;
+  count_--;
+  return true;
+}
+
+Timer* TimerWheel::RemoveAll() {
+  Timer* removed = Forget(overflow_, NULL);
+  overflow_ = NULL;
+  for (int level = 0; level < kLevels; level++) {
+    for (int slot = 0; slot < kSlots; slot++) {
+      if (slots_[level][slot] == NULL) continue;
+      removed = Forget(TakeSlot(level, slot), removed);
+    }
+  }
+  ASSERT(count_ == 0);
+  return removed;
+}
+
+Timer* TimerWheel::Advance(int64 now) {
+  Timer* expired = NULL;
+  while (count_ > 0) {
+    int64 tick = NextTick();
+    if (tick > now) break;
+    current_ = tick;
+
+    // Move the timers of all slots we have reached one or more levels down,
+    // starting from the top so they can cascade all the way.
+    if ((tick & ((static_cast<int64>(1) << (kLevels * kBits)) - 1)) == 0) {
+      Timer* timers = overflow_;
+      overflow_ = NULL;
+      while (timers != NULL) {
+        Timer* next = timers->next_;
+        Insert(timers);
+        timers = next;
+      }
+    }
+    for (int level = kLevels - 1; level > 0; level--) {
+      int shift = level * kBits;
+      if ((tick & ((static_cast<int64>(1) << shift) - 1)) != 0) continue;
+      Timer* timers = TakeSlot(level, (tick >> shift) & (kSlots - 1));
+      while (timers != NULL) {
+        Timer* next = timers->next_;
+        Insert(timers);
+        timers = next;
+      }
+    }
+
+    Timer* timers = TakeSlot(0, tick & (kSlots - 1));
+    while (timers != NULL) {
+      Timer* next = timers->next_;
+      ASSERT(timers->deadline_ == tick);
+      timers_.Erase(timers_.Find(timers->port_));
+      count_--;
+      timers->next_ = expired;
+      expired = timers;
+      timers = next;
+    }
+  }
+  // Nothing happens before the next tick, so the wheel can be moved forward
+  // without touching any of the slots.
+  if (now > current_) current_ = now;
+  return expired;
+}
+
+int64 TimerWheel::NextTick() const {
+  if (count_ == 0) return -1;
+  // All timers on a level are in slots ahead of the current one, and all
+  // timers on a level expire before those on the levels above it.
+  for (int level = 0; level < kLevels; level++) {
+    if (occupied_[level] == 0) continue;
+    int shift = level * kBits;
+    int64 base = (current_ >> (shift + kBits)) << (shift + kBits);
+    return base + (static_cast<int64>(LowestBit(occupied_[level])) << shift);
+  }
+  ASSERT(overflow_ != NULL);
+  int shift = kLevels * kBits;
+  return ((current_ >> shift) + 1) << shift;
+}
+
+void TimerWheel::Insert(Timer* timer) {
+  ASSERT(timer->deadline_ > current_ ||
+         (timer->deadline_ == current_ && (current_ & (kSlots - 1)) == 0));
+  // Find the lowest level where the deadline and the current tick agree on
+  // all the bits above it.
+  int64 difference = timer->deadline_ ^ current_;
+  int level = 0;
+  while (level < kLevels && (difference >> ((level + 1) * kBits)) != 0) {
+    level++;
+  }
+
+  timer->previous_ = NULL;
+  timer->level_ = level;
+  if (level == kOverflowLevel) {
+    timer->next_ = overflow_;
+    if (overflow_ != NULL) overflow_->previous_ = timer;
+    overflow_ = timer;
+    return;
+  }
+
+  int slot = (timer->deadline_ >> (level * kBits)) & (kSlots - 1);
+  timer->slot_ = slot;
+  Timer* head = slots_[level][slot];
+  timer->next_ = head;
+  if (head != NULL) head->previous_ = timer;
+  slots_[level][slot] = timer;
+  occupied_[level] |= static_cast<uint64>(1) << slot;
+}
+
+void TimerWheel::Remove(Timer* timer) {
+  Timer* next = timer->next_;
+  Timer* previous = timer->previous_;
+  if (next != NULL) next->previous_ = previous;
+  if (previous != NULL) {
+    previous->next_ = next;
+  } else if (timer->level_ == kOverflowLevel) {
+    overflow_ = next;
+  } else {
+    slots_[timer->level_][timer->slot_] = next;
+    if (next == NULL) {
+      occupied_[timer->level_] &= ~(static_cast<uint64>(1) << timer->slot_);
+    }
+  }
+  timer->next_ = NULL;
+  timer->previous_ = NULL;
+}
+
+Timer* TimerWheel::Forget(Timer* timers, Timer* list) {
+  while (timers != NULL) {
+    Timer* next = timers->next_;
+    timers_.Erase(timers_.Find(timers->port_));
+    count_--;
+    timers->next_ = list;
+    list = timers;
+    timers = next;
+  }
+  return list;
+}
+
+Timer* TimerWheel::TakeSlot(int level, int slot) {
+  Timer* timers = slots_[level][slot];
+  slots_[level][slot] = NULL;
+  occupied_[level] &= ~(static_cast<uint64>(1) << slot);
+  return timers;
+}
+
+}  // namespace fletch
@@ -0,0 +1,105 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_TIMER_WHEEL_H_
+#define SRC_VM_TIMER_WHEEL_H_
+
+#include "src/shared/globals.h"
+#include "src/vm/hash_map.h"
+
+namespace fletch {
+
+class Port;
+
+class Timer {
+ public:
+  Port* port() const { return port_; }
+  int64 deadline() const { return deadline_; }
+
+  // Next timer in the list returned by [TimerWheel::Advance].
+  Timer* next() const { return next_; }
+
+ private:
+  friend class TimerWheel;
+
+  Timer(Port* port, int64 deadline)
+      : port_(port), deadline_(deadline), next_(NULL), previous_(NULL),
+        level_(0), slot_(0) { }
+
+  Port* port_;
+  int64 deadline_;
+  Timer* next_;
+  Timer* previous_;
+  int level_;
+  int slot_;
+};
+
+// Hierarchical timer wheel with a resolution of one tick (the event handler
+// uses milliseconds). Each of the [kLevels] wheels has [kSlots] slots, and
+// one slot on level n covers a full rotation of level n - 1. Timers are put
+// on the lowest level that can represent their deadline relative to the
+// current tick, and are moved down a level when the wheel reaches their slot.
+// Timers too far in the future to be represented at all are kept in an
+// overflow list that is revisited whenever the top level wraps around.
+//
+// Scheduling and cancelling are O(1). Advancing the wheel only visits slots
+// that contain timers, so it is cheap to advance it by large amounts.
+//
+// There can be at most one timer per port. The wheel is not thread safe.
+class TimerWheel {
+ public:
+  static const int kBits = 6;
+  static const int kSlots = 1 << kBits;
+  static const int kLevels = 4;
+
+  explicit TimerWheel(int64 now);
+  ~TimerWheel();
+
+  int64 current() const { return current_; }
+  bool is_empty() const { return count_ == 0; }
+
+  // Arm the timer for [port] to expire at [deadline]. If the port already
+  // had a timer, it is moved to the new deadline and false is returned.
+  bool Schedule(Port* port, int64 deadline);
+
+  // Disarm the timer for [port]. Returns false if there was no timer.
+  bool Cancel(Port* port);
+
+  // Advance the wheel to [now]. All timers with a deadline before or at
+  // [now] are removed from the wheel and returned as a list linked through
+  // [Timer::next]. The caller must delete them using [DeleteTimers].
+  Timer* Advance(int64 now);
+
+  // Remove all timers from the wheel and return them as a list like
+  // [Advance] does.
+  Timer* RemoveAll();
+
+  static void DeleteTimers(Timer* timers);
+
+  // Returns the next tick at which [Advance] has work to do, or -1 if the
+  // wheel is empty. This is never later than the earliest deadline.
+  int64 NextTick() const;
+
+ private:
+  static const int kOverflowLevel = kLevels;
+
+  void Insert(Timer* timer);
+  void Remove(Timer* timer);
+  Timer* TakeSlot(int level, int slot);
+
+  // Unregister all [timers] and prepend them to [list].
+  Timer* Forget(Timer* timers, Timer* list);
+
+  int64 current_;
+  int count_;
+  uint64 occupied_[kLevels];
+  Timer* slots_[kLevels][kSlots];
+  Timer* overflow_;
+
+  HashMap<Port*, Timer*> timers_;
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_TIMER_WHEEL_H_
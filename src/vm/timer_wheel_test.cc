@@ -0,0 +1,134 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/random.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/timer_wheel.h"
+
+namespace fletch {
+
+// The wheel never dereferences the ports, so any distinct values will do.
+static Port* FakePort(int i) {
+  return reinterpret_cast<Port*>(static_cast<uword>(i + 1) << 4);
+}
+
+static int CountTimers(Timer* timers) {
+  int count = 0;
+  for (Timer* timer = timers; timer != NULL; timer = timer->next()) count++;
+  return count;
+}
+
+TEST_CASE(TimerWheel_Expire) {
+  TimerWheel wheel(1000);
+  EXPECT(wheel.is_empty());
+  EXPECT_EQ(wheel.NextTick(), -1);
+
+  EXPECT(wheel.Schedule(FakePort(0), 1010));
+  EXPECT(wheel.Schedule(FakePort(1), 1500));
+  EXPECT(!wheel.is_empty());
+  EXPECT(wheel.NextTick() <= 1010);
+
+  Timer* expired = wheel.Advance(1009);
+  EXPECT(expired == NULL);
+  expired = wheel.Advance(1010);
+  EXPECT_EQ(CountTimers(expired), 1);
+  EXPECT_EQ(expired->port(), FakePort(0));
+  EXPECT_EQ(expired->deadline(), 1010);
+  TimerWheel::DeleteTimers(expired);
+
+  EXPECT(wheel.NextTick() <= 1500);
+  expired = wheel.Advance(2000);
+  EXPECT_EQ(CountTimers(expired), 1);
+  EXPECT_EQ(expired->port(), FakePort(1));
+  TimerWheel::DeleteTimers(expired);
+  EXPECT(wheel.is_empty());
+  EXPECT_EQ(wheel.current(), 2000);
+}
+
+TEST_CASE(TimerWheel_RescheduleAndCancel) {
+  TimerWheel wheel(0);
+  EXPECT(wheel.Schedule(FakePort(0), 100));
+  EXPECT(!wheel.Schedule(FakePort(0), 50));
+  EXPECT(wheel.Schedule(FakePort(1), 70));
+  EXPECT(wheel.Cancel(FakePort(1)));
+  EXPECT(!wheel.Cancel(FakePort(1)));
+
+  Timer* expired = wheel.Advance(60);
+  EXPECT_EQ(CountTimers(expired), 1);
+  EXPECT_EQ(expired->deadline(), 50);
+  TimerWheel::DeleteTimers(expired);
+  EXPECT(wheel.is_empty());
+
+  // Deadlines in the past expire on the next tick.
+  EXPECT(wheel.Schedule(FakePort(2), 10));
+  EXPECT_EQ(wheel.NextTick(), 61);
+  expired = wheel.Advance(61);
+  EXPECT_EQ(CountTimers(expired), 1);
+  TimerWheel::DeleteTimers(expired);
+}
+
+TEST_CASE(TimerWheel_Overflow) {
+  TimerWheel wheel(12345);
+  int64 far = 12345 + (static_cast<int64>(1) << 30) + 7;
+  EXPECT(wheel.Schedule(FakePort(0), far));
+  EXPECT(wheel.Advance(far - 1) == NULL);
+  Timer* expired = wheel.Advance(far);
+  EXPECT_EQ(CountTimers(expired), 1);
+  EXPECT_EQ(expired->deadline(), far);
+  TimerWheel::DeleteTimers(expired);
+}
+
+TEST_CASE(TimerWheel_RemoveAll) {
+  TimerWheel wheel(0);
+  EXPECT(wheel.Schedule(FakePort(0), 5));
+  EXPECT(wheel.Schedule(FakePort(1), 5000));
+  EXPECT(wheel.Schedule(FakePort(2), static_cast<int64>(1) << 30));
+  Timer* removed = wheel.RemoveAll();
+  EXPECT_EQ(CountTimers(removed), 3);
+  TimerWheel::DeleteTimers(removed);
+  EXPECT(wheel.is_empty());
+  EXPECT_EQ(wheel.NextTick(), -1);
+
+  // The ports can be scheduled again.
+  EXPECT(wheel.Schedule(FakePort(1), 10));
+}
+
+TEST_CASE(TimerWheel_Random) {
+  static const int kTimers = 2000;
+  RandomLCG random(42);
+  int64 deadlines[kTimers];
+  TimerWheel wheel(random.NextUInt32());
+  for (int i = 0; i < kTimers; i++) {
+    // Spread the deadlines over all the levels.
+    int bits = 1 + random.NextUInt32() % 28;
+    int64 delay = random.NextUInt32() & ((static_cast<int64>(1) << bits) - 1);
+    deadlines[i] = wheel.current() + 1 + delay;
+    EXPECT(wheel.Schedule(FakePort(i), deadlines[i]));
+  }
+
+  int seen = 0;
+  while (!wheel.is_empty()) {
+    int64 next = wheel.NextTick();
+    EXPECT(next > wheel.current());
+    // Advance in irregular steps that are sometimes before [next].
+    int64 now = next - 1 + random.NextUInt32() % 3;
+    Timer* expired = wheel.Advance(now);
+    for (Timer* timer = expired; timer != NULL; timer = timer->next()) {
+      int index = (reinterpret_cast<uword>(timer->port()) >> 4) - 1;
+      EXPECT_EQ(timer->deadline(), deadlines[index]);
+      EXPECT(timer->deadline() <= now);
+      deadlines[index] = -1;
+      seen++;
+    }
+    TimerWheel::DeleteTimers(expired);
+    // Nothing that should have expired is left behind.
+    for (int i = 0; i < kTimers; i++) EXPECT(deadlines[i] == -1 ||
+                                             deadlines[i] > now);
+  }
+  EXPECT_EQ(seen, kTimers);
+}
+
+}  // namespace fletch
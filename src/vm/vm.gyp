@@ -29,33 +29,43 @@
         'ffi_macos.cc',
         'ffi_posix.cc',
         'ffi_disabled.cc',
+        'finalizer_queue.cc',
         'fletch.cc',
         'fletch_api_impl.cc',
+        'gc_events.cc',
         'heap.cc',
+        'heap_census.cc',
         'heap_validator.cc',
+        'io_uring_linux.cc',
         'immutable_heap.cc',
         'gc_thread.cc',
+        'inline_cache.cc',
         'interpreter.cc',
         'intrinsics.cc',
         'lookup_cache.cc',
+        'mark_sweep.cc',
         'natives.cc',
         'object.cc',
         'object_list.cc',
         'object_map.cc',
         'object_memory.cc',
+        'parallel_scavenger.cc',
+        'pause_histogram.cc',
         'port.cc',
         'process.cc',
         'program.cc',
         'program_folder.cc',
+        'profiler.cc',
+        'remembered_set.cc',
         'scheduler.cc',
         'selector_row.cc',
         'service_api_impl.cc',
         'session.cc',
         'snapshot.cc',
         'stack_walker.cc',
-        'storebuffer.cc',
         'thread_pool.cc',
         'thread_posix.cc',
+        'timer_wheel.cc',
         'unicode.cc',
         'void_hash_table.cc',
         'weak_pointer.cc',
@@ -213,11 +223,22 @@
       ],
       'sources': [
         # TODO(ahe): Add header (.h) files.
+        'finalizer_queue_test.cc',
+        'gc_events_test.cc',
         'hash_table_test.cc',
+        'heap_census_test.cc',
+        'inline_cache_test.cc',
+        'io_uring_test.cc',
+        'lookup_cache_test.cc',
         'object_map_test.cc',
         'object_memory_test.cc',
         'object_test.cc',
         'platform_test.cc',
+        'profiler_test.cc',
+        'program_folder_test.cc',
+        'timer_wheel_test.cc',
+        'weak_pointer_test.cc',
+        'work_stealing_queue_test.cc',
 
         '../shared/test_main.cc',
       ],
@@ -11,98 +11,133 @@
 
 namespace fletch {
 
-WeakPointer::WeakPointer(HeapObject* object,
-                         WeakPointerCallback callback,
-                         WeakPointer* next)
-    : object_(object),
-      callback_(callback),
-      prev_(NULL),
-      next_(next) { }
-
-void WeakPointer::Process(Space* garbage_space, WeakPointer** pointers) {
-  WeakPointer* new_list = NULL;
-  WeakPointer* previous = NULL;
-  WeakPointer* current = *pointers;
-  while (current != NULL) {
-    WeakPointer* next = current->next_;
-    HeapObject* current_object = current->object_;
-    HeapObject* forward = current_object->forwarding_address();
-    if (garbage_space->Includes(current_object->address())) {
-      if (forward != NULL) {
-        current->object_ = forward;
-        if (new_list == NULL) new_list = current;
-        previous = current;
-      } else {
-        if (current->next_ != NULL) current->next_->prev_ = previous;
-        if (previous != NULL) previous->next_ = current->next_;
-        current->callback_(current_object);
-        delete current;
+void WeakPointerTable::Add(HeapObject* object, WeakPointerCallback callback) {
+  HashMap<HeapObject*, int>::ConstIterator it = index_.Find(object);
+  if (it != index_.End()) {
+    entries_[it->second].callback = callback;
+    return;
+  }
+  index_[object] = entries_.size();
+  Entry entry = { object, callback };
+  entries_.push_back(entry);
+}
+
+void WeakPointerTable::Remove(HeapObject* object) {
+  HashMap<HeapObject*, int>::ConstIterator it = index_.Find(object);
+  if (it == index_.End()) return;
+  int index = it->second;
+  index_.Erase(it);
+
+  // Fill the hole with the last tenured entry, and the hole that leaves
+  // with the last entry.
+  if (index < tenured_) {
+    tenured_--;
+    if (index != tenured_) {
+      entries_[index] = entries_[tenured_];
+      index_[entries_[index].object] = index;
+    }
+    index = tenured_;
+  }
+  int last = entries_.size() - 1;
+  if (index != last) {
+    entries_[index] = entries_[last];
+    index_[entries_[index].object] = index;
+  }
+  entries_.pop_back();
+}
+
+void WeakPointerTable::Process(Space* garbage_space, Space* survivor_space) {
+  int first = (survivor_space == NULL) ? 0 : tenured_;
+  int length = entries_.size();
+
+  // The moved and dead objects are removed from the index first, so their
+  // old addresses cannot be confused with the new ones.
+  for (int i = first; i < length; i++) {
+    HeapObject* object = entries_[i].object;
+    if (garbage_space->Includes(object->address())) {
+      index_.Erase(index_.Find(object));
+    }
+  }
+
+  // Compact the entries, keeping the tenured ones first.
+  std::vector<Entry> young;
+  int tenured = first;
+  for (int i = first; i < length; i++) {
+    Entry entry = entries_[i];
+    if (garbage_space->Includes(entry.object->address())) {
+      HeapObject* forward = entry.object->forwarding_address();
+      if (forward == NULL) {
+        entry.callback(entry.object);
+        continue;
       }
+      entry.object = forward;
+    }
+    bool is_tenured = (survivor_space == NULL)
+        ? i < tenured_
+        : !survivor_space->Includes(entry.object->address());
+    if (is_tenured) {
+      entries_[tenured++] = entry;
     } else {
-      if (new_list == NULL) new_list = current;
-      previous = current;
+      young.push_back(entry);
     }
-    current = next;
   }
-  *pointers = new_list;
-}
+  entries_.resize(tenured);
+  entries_.insert(entries_.end(), young.begin(), young.end());
+  tenured_ = tenured;
 
-void WeakPointer::ForceCallbacks(WeakPointer** pointers) {
-  WeakPointer* current = *pointers;
-  while (current != NULL) {
-    WeakPointer* temp = current->next_;
-    current->callback_(current->object_);
-    delete current;
-    current = temp;
+  for (int i = first; i < static_cast<int>(entries_.size()); i++) {
+    index_[entries_[i].object] = i;
   }
-  *pointers = NULL;
 }
 
-void WeakPointer::Remove(WeakPointer** pointers, HeapObject* object) {
-  WeakPointer* current = *pointers;
-  WeakPointer* previous = NULL;
-  while (current != NULL) {
-    if (current->object_ == object) {
-      if (previous == NULL) {
-        *pointers = current->next_;
-      } else {
-        previous->next_ = current->next_;
+void WeakPointerTable::ProcessSwept(SweepingVisitor* visitor) {
+  int live = 0;
+  int tenured = 0;
+  int length = entries_.size();
+  for (int i = 0; i < length; i++) {
+    Entry entry = entries_[i];
+    if (visitor->IsLive(entry.object)) {
+      if (i < tenured_) tenured++;
+      if (live != i) {
+        entries_[live] = entry;
+        index_[entry.object] = live;
       }
-      if (current->next_ != NULL) current->next_->prev_ = previous;
-      delete current;
-      return;
+      live++;
     } else {
-      previous = current;
-      current = current->next_;
+      index_.Erase(index_.Find(entry.object));
+      entry.callback(entry.object);
     }
   }
+  entries_.resize(live);
+  tenured_ = tenured;
 }
 
-void WeakPointer::PrependWeakPointers(WeakPointer** pointers,
-                                      WeakPointer* to_be_prepended) {
-  if (to_be_prepended != NULL) {
-    WeakPointer* head = *pointers;
-
-    ASSERT(head == NULL || head->prev_ == NULL);
-    ASSERT(to_be_prepended->prev_ == NULL);
+void WeakPointerTable::ForceCallbacks() {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    entries_[i].callback(entries_[i].object);
+  }
+  Clear();
+}
 
-    WeakPointer* last = to_be_prepended;
-    while (last->next_ != NULL) {
-      last = last->next_;
-    }
-    last->next_ = head;
-    if (head != NULL) {
-      head->prev_ = last;
-    }
-    *pointers = to_be_prepended;
+void WeakPointerTable::TakeFrom(WeakPointerTable* other) {
+  for (size_t i = 0; i < other->entries_.size(); i++) {
+    index_[other->entries_[i].object] = entries_.size();
+    entries_.push_back(other->entries_[i]);
   }
+  other->Clear();
 }
 
-void WeakPointer::Visit(WeakPointer* pointers, PointerVisitor *visitor) {
-  while (pointers != NULL) {
-    visitor->Visit(reinterpret_cast<Object**>(&pointers->object_));
-    pointers = pointers->next_;
+void WeakPointerTable::Visit(PointerVisitor* visitor) {
+  for (size_t i = 0; i < entries_.size(); i++) {
+    visitor->Visit(reinterpret_cast<Object**>(&entries_[i].object));
   }
 }
 
+void WeakPointerTable::Clear() {
+  HashMap<HeapObject*, int> empty;
+  index_.Swap(empty);
+  entries_.clear();
+  tenured_ = 0;
+}
+
 }  // namespace fletch
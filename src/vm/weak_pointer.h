@@ -5,32 +5,76 @@
 #ifndef SRC_VM_WEAK_POINTER_H_
 #define SRC_VM_WEAK_POINTER_H_
 
+#include <vector>
+
+#include "src/vm/hash_map.h"
+
 namespace fletch {
 
 class HeapObject;
 class Space;
 class PointerVisitor;
+class SweepingVisitor;
 
 typedef void (*WeakPointerCallback)(HeapObject* object);
 
-class WeakPointer {
+// The weak pointers of a heap. Every weak pointer has a callback that is
+// called when its object dies, which is how finalizers are implemented.
+//
+// The weak pointers are kept in an array, indexed by a hash map from the
+// object to its position, so a weak pointer can be removed without
+// searching. The array is split in two: the weak pointers to tenured
+// objects come first, and generational collections only process the
+// weak pointers after them.
+class WeakPointerTable {
  public:
-  WeakPointer(HeapObject* object,
-              WeakPointerCallback callback,
-              WeakPointer* next);
+  WeakPointerTable() : tenured_(0) { }
+
+  int length() const { return entries_.size(); }
+
+  // Adds a weak pointer to [object]. An object has at most one weak
+  // pointer, so adding another one replaces its callback.
+  void Add(HeapObject* object, WeakPointerCallback callback);
+
+  // Removes the weak pointer to [object], if there is one.
+  void Remove(HeapObject* object);
+
+  // Updates the weak pointers after a collection that moved the live
+  // objects out of [garbage_space], and calls the callbacks of the objects
+  // that died. If [survivor_space] is given, the collection is
+  // generational: the objects that did not end up in [survivor_space] are
+  // tenured, and their weak pointers are skipped from now on.
+  void Process(Space* garbage_space, Space* survivor_space = NULL);
 
-  static void Process(Space* garbage_space, WeakPointer** pointers);
-  static void ForceCallbacks(WeakPointer** pointers);
-  static void Remove(WeakPointer** pointers, HeapObject* object);
-  static void PrependWeakPointers(WeakPointer** pointers,
-                                  WeakPointer* to_be_prepended);
-  static void Visit(WeakPointer* pointers, PointerVisitor *visitor);
+  // Like [Process], but for a collection that does not move objects.
+  void ProcessSwept(SweepingVisitor* visitor);
+
+  // Forgets which objects are tenured, for when the old generation is
+  // merged back into the young one.
+  void Untenure() { tenured_ = 0; }
+
+  // Calls the callbacks of all the weak pointers and removes them.
+  void ForceCallbacks();
+
+  // Moves all the weak pointers of [other] to this table.
+  void TakeFrom(WeakPointerTable* other);
+
+  // Visits the object pointers. The visitor must not move the objects.
+  void Visit(PointerVisitor* visitor);
 
  private:
-  HeapObject* object_;
-  WeakPointerCallback callback_;
-  WeakPointer* prev_;
-  WeakPointer* next_;
+  struct Entry {
+    HeapObject* object;
+    WeakPointerCallback callback;
+  };
+
+  void Clear();
+
+  std::vector<Entry> entries_;
+  HashMap<HeapObject*, int> index_;
+  // The number of weak pointers to tenured objects at the start of
+  // [entries_].
+  int tenured_;
 };
 
 }  // namespace fletch
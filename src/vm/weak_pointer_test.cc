@@ -0,0 +1,81 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/random.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/heap.h"
+#include "src/vm/weak_pointer.h"
+
+namespace fletch {
+
+static int finalized = 0;
+
+static void CountFinalized(HeapObject* object) {
+  finalized++;
+}
+
+static Space* Scavenge(Space* from, Array** roots, int count) {
+  Space* to = new Space();
+  NoAllocationFailureScope scope(to);
+  ScavengeVisitor visitor(from, to);
+  for (int i = 0; i < count; i++) {
+    visitor.Visit(reinterpret_cast<Object**>(&roots[i]));
+  }
+  to->CompleteScavenge(&visitor);
+  return to;
+}
+
+TEST_CASE(WeakPointerTable) {
+  RandomLCG random(0);
+  Heap program_heap(&random);
+  Class* meta_class = Class::cast(program_heap.CreateMetaClass());
+  Class* array_class = Class::cast(program_heap.CreateClass(
+      InstanceFormat::array_format(), meta_class, NULL));
+
+  Heap heap(&random);
+  NoAllocationFailureScope scope(heap.space());
+  WeakPointerTable table;
+  Array* arrays[8];
+  for (int i = 0; i < 8; i++) {
+    arrays[i] = Array::cast(
+        heap.CreateArray(array_class, 1, Smi::FromWord(i)));
+    table.Add(arrays[i], CountFinalized);
+  }
+  table.Add(arrays[0], CountFinalized);
+  EXPECT_EQ(table.length(), 8);
+  table.Remove(arrays[2]);
+  EXPECT_EQ(table.length(), 7);
+
+  // Only the first four arrays survive, and the removed one is not
+  // finalized.
+  finalized = 0;
+  Space* survivors = Scavenge(heap.space(), arrays, 4);
+  table.Process(heap.space(), survivors);
+  EXPECT_EQ(finalized, 4);
+  EXPECT_EQ(table.length(), 3);
+  table.Remove(arrays[1]);
+  EXPECT_EQ(table.length(), 2);
+
+  // The survivors are promoted, so their weak pointers are tenured and
+  // skipped by the next generational collection.
+  Space empty;
+  Space* old_space = Scavenge(survivors, arrays, 4);
+  table.Process(survivors, &empty);
+  EXPECT_EQ(finalized, 4);
+  EXPECT_EQ(table.length(), 2);
+  table.Process(old_space, &empty);
+  EXPECT_EQ(finalized, 4);
+
+  // A full collection processes all of them.
+  table.Process(old_space);
+  EXPECT_EQ(finalized, 6);
+  EXPECT_EQ(table.length(), 0);
+
+  delete old_space;
+  delete survivors;
+}
+
+}  // namespace fletch
@@ -0,0 +1,100 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#ifndef SRC_VM_WORK_STEALING_QUEUE_H_
+#define SRC_VM_WORK_STEALING_QUEUE_H_
+
+#include "src/shared/assert.h"
+#include "src/shared/atomic.h"
+#include "src/shared/globals.h"
+
+namespace fletch {
+
+// A fixed-size Chase-Lev work-stealing deque.
+//
+// The owning thread pushes and pops entries at the bottom end (LIFO). This
+// only requires plain loads and stores, except when the owner and a thief
+// race for the very last entry. All other threads can steal entries from the
+// top end (FIFO) using a single compare-and-swap.
+//
+// The deque does not grow. When it is full [Push] fails and the caller has to
+// put the entry somewhere else. That way the buffer never has to be
+// reallocated while thieves may still be reading from it.
+template<typename T>
+class WorkStealingQueue {
+ public:
+  static const int kCapacity = 256;
+
+  WorkStealingQueue() : top_(0), bottom_(0) { }
+
+  // Push [entry] at the bottom of the deque. Must only be called by the
+  // owning thread. Returns false if the deque is full.
+  bool Push(T* entry) {
+    ASSERT(entry != NULL);
+    word bottom = bottom_.load(kRelaxed);
+    word top = top_.load(kAcquire);
+    if (bottom - top >= kCapacity) return false;
+    entries_[bottom & kMask].store(entry, kRelaxed);
+    bottom_.store(bottom + 1, kRelease);
+    return true;
+  }
+
+  // Pop the most recently pushed entry. Must only be called by the owning
+  // thread. Returns NULL if the deque is empty.
+  T* Pop() {
+    word bottom = bottom_.load(kRelaxed) - 1;
+    // The store to bottom_ must be globally visible before top_ is read, or
+    // a thief could take the same entry.
+    bottom_.store(bottom, kSeqCst);
+    word top = top_.load(kSeqCst);
+    if (top > bottom) {
+      // The deque was empty.
+      bottom_.store(bottom + 1, kRelaxed);
+      return NULL;
+    }
+    T* entry = entries_[bottom & kMask].load(kRelaxed);
+    if (top == bottom) {
+      // This is the last entry. Race against the thieves by claiming it
+      // through top_, just like they do.
+      if (!top_.compare_exchange_strong(top, top + 1, kSeqCst, kRelaxed)) {
+        entry = NULL;
+      }
+      bottom_.store(bottom + 1, kRelaxed);
+    }
+    return entry;
+  }
+
+  // Try to steal the oldest entry. Can be called from any thread.
+  // Returns false if another thread modified the deque concurrently. The
+  // operation should be retried.
+  // Returns true if an entry was successfully stolen (or the deque is empty).
+  bool TrySteal(T** entry) {
+    ASSERT(*entry == NULL);
+    word top = top_.load(kSeqCst);
+    word bottom = bottom_.load(kSeqCst);
+    if (top >= bottom) return true;
+    T* result = entries_[top & kMask].load(kRelaxed);
+    if (!top_.compare_exchange_strong(top, top + 1, kSeqCst, kRelaxed)) {
+      return false;
+    }
+    *entry = result;
+    return true;
+  }
+
+  // Only a hint when called from a thread other than the owner.
+  bool is_empty() const {
+    return bottom_.load(kAcquire) <= top_.load(kAcquire);
+  }
+
+ private:
+  static const int kMask = kCapacity - 1;
+
+  Atomic<word> top_;
+  Atomic<word> bottom_;
+  Atomic<T*> entries_[kCapacity];
+};
+
+}  // namespace fletch
+
+#endif  // SRC_VM_WORK_STEALING_QUEUE_H_
@@ -0,0 +1,111 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+#include "src/shared/assert.h"
+#include "src/shared/atomic.h"
+#include "src/shared/test_case.h"
+
+#include "src/vm/thread.h"
+#include "src/vm/work_stealing_queue.h"
+
+namespace fletch {
+
+typedef WorkStealingQueue<int> IntQueue;
+
+TEST_CASE(WorkStealingQueue_PopIsLIFO) {
+  IntQueue queue;
+  int values[3] = { 0, 1, 2 };
+  EXPECT(queue.is_empty());
+  EXPECT(queue.Pop() == NULL);
+  for (int i = 0; i < 3; i++) EXPECT(queue.Push(&values[i]));
+  EXPECT(!queue.is_empty());
+  EXPECT_EQ(queue.Pop(), &values[2]);
+  EXPECT_EQ(queue.Pop(), &values[1]);
+  EXPECT_EQ(queue.Pop(), &values[0]);
+  EXPECT(queue.Pop() == NULL);
+  EXPECT(queue.is_empty());
+}
+
+TEST_CASE(WorkStealingQueue_StealIsFIFO) {
+  IntQueue queue;
+  int values[3] = { 0, 1, 2 };
+  for (int i = 0; i < 3; i++) EXPECT(queue.Push(&values[i]));
+  int* entry = NULL;
+  EXPECT(queue.TrySteal(&entry));
+  EXPECT_EQ(entry, &values[0]);
+  EXPECT_EQ(queue.Pop(), &values[2]);
+  entry = NULL;
+  EXPECT(queue.TrySteal(&entry));
+  EXPECT_EQ(entry, &values[1]);
+  entry = NULL;
+  EXPECT(queue.TrySteal(&entry));
+  EXPECT(entry == NULL);
+}
+
+TEST_CASE(WorkStealingQueue_Full) {
+  IntQueue queue;
+  int value = 0;
+  for (int i = 0; i < IntQueue::kCapacity; i++) EXPECT(queue.Push(&value));
+  EXPECT(!queue.Push(&value));
+  int* entry = NULL;
+  EXPECT(queue.TrySteal(&entry));
+  EXPECT(queue.Push(&value));
+  for (int i = 0; i < IntQueue::kCapacity; i++) EXPECT(queue.Pop() != NULL);
+  EXPECT(queue.Pop() == NULL);
+}
+
+static const int kStealIterations = 100000;
+static const int kThieves = 3;
+
+static IntQueue* steal_queue;
+static Atomic<bool> owner_done;
+
+static void Take(int* entry) {
+  __atomic_fetch_add(entry, 1, __ATOMIC_SEQ_CST);
+}
+
+static void* Thief(void* data) {
+  while (true) {
+    bool done = owner_done;
+    int* entry = NULL;
+    if (steal_queue->TrySteal(&entry)) {
+      if (entry != NULL) {
+        Take(entry);
+      } else if (done) {
+        return NULL;
+      }
+    }
+  }
+}
+
+TEST_CASE(WorkStealingQueue_ConcurrentSteal) {
+  IntQueue queue;
+  steal_queue = &queue;
+  owner_done = false;
+
+  // Every pushed entry must be taken exactly once, either by the owner or by
+  // one of the thieves.
+  static const int kEntries = 64;
+  int* counts = new int[kEntries];
+  for (int i = 0; i < kEntries; i++) counts[i] = 0;
+
+  ThreadIdentifier thieves[kThieves];
+  for (int i = 0; i < kThieves; i++) thieves[i] = Thread::Run(Thief);
+
+  for (int i = 0; i < kStealIterations; i++) {
+    EXPECT(queue.Push(&counts[i % kEntries]));
+    // Race the thieves for the only entry in the deque.
+    int* entry = queue.Pop();
+    if (entry != NULL) Take(entry);
+  }
+  owner_done = true;
+  for (int i = 0; i < kThieves; i++) thieves[i].Join();
+
+  int total = 0;
+  for (int i = 0; i < kEntries; i++) total += counts[i];
+  EXPECT_EQ(total, kStealIterations);
+  delete[] counts;
+}
+
+}  // namespace fletch
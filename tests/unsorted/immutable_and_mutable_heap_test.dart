@@ -40,8 +40,8 @@ void mutableToImmutableObjects(bool useConstConstructor) {
     Expect.equals(abc, 'abc');
   }
 
-  // [survivorContainer] was added to storebuffer and we therefore do not
-  // collect [survivorContainer.second] as garbage.
+  // [survivorContainer] has its card in the remembered set and we therefore
+  // do not collect [survivorContainer.second] as garbage.
   Expect.equals(survivorContainer.second, 'number: 42');
 }
 
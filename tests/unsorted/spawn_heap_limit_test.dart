@@ -0,0 +1,46 @@
+// Copyright (c) 2015, the Fletch project authors. Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE.md file.
+
+import 'dart:fletch';
+
+import 'package:expect/expect.dart';
+
+const int heapLimit = 1024 * 1024;
+
+main() {
+  Expect.throws(() => Process.spawn(noarg, null, 0),
+                (e) => e is ArgumentError);
+
+  var channel = new Channel();
+  var port = new Port(channel);
+  Process.spawn(allocateAndCatch, port, heapLimit);
+  Expect.equals("Out of memory.", channel.receive());
+
+  // A process that does not catch the exception is terminated, but the
+  // rest of the program keeps running.
+  Process.spawn(allocate, null, heapLimit);
+  Process.spawn(sendDone, port);
+  Expect.equals("done", channel.receive());
+}
+
+void noarg() { }
+
+void allocate() {
+  var list = [];
+  while (true) list.add(new List(1000));
+}
+
+void allocateAndCatch(Port port) {
+  var error;
+  try {
+    allocate();
+  } catch (e) {
+    error = e;
+  }
+  port.send(error);
+}
+
+void sendDone(Port port) {
+  port.send("done");
+}
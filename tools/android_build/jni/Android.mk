@@ -27,33 +27,42 @@ LOCAL_SRC_FILES := \
 	../../../src/vm/ffi.cc \
 	../../../src/vm/ffi_linux.cc \
 	../../../src/vm/ffi_posix.cc \
+	../../../src/vm/finalizer_queue.cc \
 	../../../src/vm/fletch.cc \
 	../../../src/vm/fletch_api_impl.cc \
+	../../../src/vm/gc_events.cc \
 	../../../src/vm/gc_thread.cc \
 	../../../src/vm/heap.cc \
+	../../../src/vm/heap_census.cc \
 	../../../src/vm/heap_validator.cc \
 	../../../src/vm/immutable_heap.cc \
 	../../../src/vm/interpreter.cc \
 	../../../src/vm/intrinsics.cc \
+	../../../src/vm/io_uring_linux.cc \
 	../../../src/vm/lookup_cache.cc \
+	../../../src/vm/mark_sweep.cc \
 	../../../src/vm/natives.cc \
 	../../../src/vm/object.cc \
 	../../../src/vm/object_list.cc \
 	../../../src/vm/object_map.cc \
 	../../../src/vm/object_memory.cc \
+	../../../src/vm/parallel_scavenger.cc \
+	../../../src/vm/pause_histogram.cc \
 	../../../src/vm/port.cc \
 	../../../src/vm/process.cc \
 	../../../src/vm/program.cc \
 	../../../src/vm/program_folder.cc \
+	../../../src/vm/profiler.cc \
+	../../../src/vm/remembered_set.cc \
 	../../../src/vm/scheduler.cc \
 	../../../src/vm/selector_row.cc \
 	../../../src/vm/service_api_impl.cc \
 	../../../src/vm/session.cc \
 	../../../src/vm/snapshot.cc \
 	../../../src/vm/stack_walker.cc \
-	../../../src/vm/storebuffer.cc \
 	../../../src/vm/thread_pool.cc \
 	../../../src/vm/thread_posix.cc \
+	../../../src/vm/timer_wheel.cc \
 	../../../src/vm/unicode.cc \
 	../../../src/vm/weak_pointer.cc \
 	../../../third_party/double-conversion/src/bignum-dtoa.cc \